@@ -4,8 +4,29 @@
 
 
 expandTable <- function(dbfile, 
-    tables, boundCols, indexCol, copyCols, expandCols, verbose=FALSE)
+    tables, boundCols, indexCol, copyCols, expandCols, verbose=FALSE,
+    batchSize=64L, threads=1L, pipeline=FALSE, sourceDb=NULL,
+    incremental=FALSE, commitRows=0L, bulkSchema=FALSE, indexCols=NULL,
+    analyze=FALSE, output=c("table", "frame", "binary", "csv"), file=NULL,
+    refCol=NULL, window=0L, relIndex=FALSE,
+    distribution=c("even", "days", "weights", "first", "last"),
+    dayCols=NULL, weightTable=NULL,
+    pragmaProfile=c("default", "bulk", "bulk_wal", "none"), pragmas=NULL,
+    instrument=FALSE, engine=c("auto", "callback", "sql"))
 {
+    output <- match.arg(output)
+    engine <- match.arg(engine)
+    distribution <- match.arg(distribution)
+    pragmaProfile <- match.arg(pragmaProfile)
+    
+    # Persistent connection (sqliteToolsConnect)
+    connection <- NULL
+    if(inherits(dbfile, "sqliteToolsConnection"))
+    {
+        connection <- dbfile
+        dbfile <- attr(connection, "dbfile")
+    }
+
     if(!is.character(dbfile))
         stop("dbfile must be character")
     
@@ -18,6 +39,10 @@ expandTable <- function(dbfile,
     if(!is.character(tables))
         stop("tables must be character")
     
+    # No outTable needed for output other than "table"
+    if(output != "table" && length(tables) == 1)
+        tables <- c(tables, "")
+    
     if(length(tables) != 2)
         stop("tables must have length 2 (inTable and outTable)")
     
@@ -48,7 +73,106 @@ expandTable <- function(dbfile,
     if(!is.integer(verbose))
         verbose <- as.integer(verbose)
     
-    con <- dbConnect(RSQLite::SQLite(), dbfile)
+    if(!is.numeric(batchSize) || length(batchSize) != 1 || batchSize < 0)
+        stop("batchSize must be a single non-negative number")
+    
+    if(!is.numeric(threads) || length(threads) != 1 || threads < 0)
+        stop("threads must be a single non-negative number")
+    
+    if(!is.logical(pipeline) || length(pipeline) != 1)
+        stop("pipeline must be logical")
+    
+    if(!is.logical(incremental) || length(incremental) != 1)
+        stop("incremental must be logical")
+    
+    if(!is.numeric(commitRows) || length(commitRows) != 1 || commitRows < 0)
+        stop("commitRows must be a single non-negative number")
+    
+    if(commitRows > 0 && (threads != 1 || pipeline))
+        stop("commitRows requires threads=1 and pipeline=FALSE")
+    
+    if(output != "table" && (threads != 1 || pipeline || incremental || commitRows > 0))
+        stop("output='", output, "' requires threads=1, pipeline=FALSE, incremental=FALSE and commitRows=0")
+    
+    if(output %in% c("binary", "csv"))
+    {
+        if(!is.character(file) || length(file) != 1)
+            stop("output='", output, "' requires file (character of length 1)")
+        
+        file <- path.expand(file)
+    }
+    else
+        file <- NULL
+    
+    if(!is.logical(bulkSchema) || length(bulkSchema) != 1)
+        stop("bulkSchema must be logical")
+    
+    if(!is.null(indexCols))
+    {
+        if(!is.character(indexCols))
+            stop("indexCols must be character")
+        
+        mtc <- match(indexCols, c("rid", indexCol, copyCols, expandCols))
+        if(any(is.na(mtc)))
+            stop("indexCols must be columns of outTable")
+    }
+    
+    if(!is.logical(analyze) || length(analyze) != 1)
+        stop("analyze must be logical")
+    
+    if(!is.null(refCol) && (!is.character(refCol) || length(refCol) != 1))
+        stop("refCol must be character of length 1")
+    
+    if(!is.numeric(window) || length(window) != 1 || window < 0)
+        stop("window must be a single non-negative number")
+    
+    if(!is.logical(relIndex) || length(relIndex) != 1)
+        stop("relIndex must be logical")
+    
+    if(relIndex && is.null(refCol))
+        stop("relIndex requires refCol")
+    
+    if(distribution == "days")
+    {
+        if(!is.character(dayCols) || length(dayCols) != 2)
+            stop("distribution='days' requires dayCols (start and end day)")
+    }
+    else
+        dayCols <- NULL
+    
+    if(distribution == "weights")
+    {
+        if(!is.character(weightTable) || length(weightTable) != 1)
+            stop("distribution='weights' requires weightTable")
+    }
+    else
+        weightTable <- NULL
+    
+    checkPragmas(pragmas)
+    
+    if(pragmaProfile == "bulk" && (threads != 1 || (pipeline && is.null(sourceDb))))
+        stop("pragmaProfile='bulk' (exclusive locking) requires threads=1 and pipeline=FALSE (or sourceDb)")
+    
+    if(!is.null(sourceDb))
+    {
+        if(!is.character(sourceDb) || length(sourceDb) != 1)
+            stop("sourceDb must be character")
+        
+        if(!file.exists(sourceDb))
+            stop("sourceDb file does not exist!")
+        
+        if(!pipeline)
+            stop("sourceDb requires pipeline=TRUE")
+        
+        sourceDb <- path.expand(sourceDb)
+    }
+    
+    # Column names and types are read from the database
+    # which contains the input table
+    if(is.null(sourceDb))
+        con <- dbConnect(RSQLite::SQLite(), dbfile)
+    else
+        con <- dbConnect(RSQLite::SQLite(), sourceDb)
     inputTable <- tables[1]
     outputTable <- tables[2]
     
@@ -67,7 +191,7 @@ expandTable <- function(dbfile,
     sql <- paste("SELECT * FROM", inputTable, "LIMIT 1;")
     res <- dbGetQuery(con, sql)
     
-    colnames <- c("id", copyCols, expandCols)
+    colnames <- c("id", copyCols, expandCols, refCol, dayCols)
     mtc <- match(colnames, names(res))
     if(any(is.na(mtc)))
     {
@@ -104,41 +228,420 @@ expandTable <- function(dbfile,
         indexCol
     )
     
-    # (pParams, pCopyCol, pCopyColTypes,  pExpCol, pVerbose)
-    .Call("expand_table", params, copyCols, copyColTypes,
-            expandCols, verbose, PACKAGE="sqliteTools")
+    # - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - #
+    # Options (named list)
+    # batchSize     :   Number of rows per INSERT statement
+    #                   (0 = default, 64 rows)
+    # threads       :   Number of worker threads (0 = number of cores)
+    # pipeline      :   Read input table in separate thread
+    # sourceDb      :   Database which contains input table (pipeline)
+    # incremental   :   Append rows of input table which have been added
+    #                   since last run (watermark in table 'expand_meta')
+    # commitRows    :   Commit and write checkpoint every n input rows
+    #                   (0 = single transaction)
+    # bulkSchema    :   id INTEGER PRIMARY KEY and integer index column
+    # indexCols     :   Columns of outTable which are indexed after loading
+    # analyze       :   Run ANALYZE on outTable after loading
+    # output        :   "table" (write outTable), "frame" (return data.frame),
+    #                   "binary" or "csv" (write file)
+    # file          :   Output file for "binary" and "csv"
+    # refCol        :   Reference column: Only index values inside
+    #                   [refCol - window, refCol + window] are written
+    # window        :   Window size around refCol
+    # relIndex      :   Write offset to refCol into indexCol
+    # distribution  :   Shares of expandCols per index value
+    # dayCols       :   Start and end day (distribution="days")
+    # weightTable   :   Table with (index, weight) (distribution="weights")
+    # connection    :   Connection handle (sqliteToolsConnect) or NULL
+    # pragmaProfile :   PRAGMAs for this call (restored afterwards)
+    # pragmas       :   Additional PRAGMAs (named character)
+    # instrument    :   Return time per phase and counters
+    # engine        :   "callback" (C++), "sql" (INSERT ... SELECT inside
+    #                   SQLite) or "auto" (chosen from table statistics)
+    # - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - #
+    options <- list(
+        batchSize=as.integer(batchSize),
+        threads=as.integer(threads),
+        pipeline=as.integer(pipeline),
+        sourceDb=sourceDb,
+        incremental=as.integer(incremental),
+        commitRows=as.integer(commitRows),
+        bulkSchema=as.integer(bulkSchema),
+        indexCols=indexCols,
+        analyze=as.integer(analyze),
+        output=output,
+        file=file,
+        refCol=refCol,
+        window=as.integer(window),
+        relIndex=as.integer(relIndex),
+        distribution=distribution,
+        dayCols=dayCols,
+        weightTable=weightTable,
+        connection=connection,
+        pragmaProfile=pragmaProfile,
+        pragmas=pragmas,
+        instrument=as.integer(instrument),
+        engine=engine
+    )
+    
+    # (pParams, pCopyCol, pCopyColTypes,  pExpCol, pVerbose, pOptions)
+    res <- .Call("expand_table", params, copyCols, copyColTypes,
+            expandCols, verbose, options, PACKAGE="sqliteTools")
+    
+    if(output == "frame" || instrument)
+        return(res)
+    return(invisible())
+}
+
+# - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - #
+# Persistent native connection: Page cache, schema and prepared statements
+# are kept across calls. Closed by sqliteToolsDisconnect or by the
+# garbage collector.
+# - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - #
+
+sqliteToolsConnect <- function(dbfile, verbose=FALSE)
+{
+    if(!is.character(dbfile) || length(dbfile) != 1)
+        stop("dbfile must be character of length 1")
+    
+    if(!file.exists(dbfile))
+        stop("Database file does not exist!")
+    
+    if(!is.integer(verbose))
+        verbose <- as.integer(verbose)
+    
+    .Call("open_connection", path.expand(dbfile), verbose,
+            PACKAGE="sqliteTools")
+}
+
+sqliteToolsDisconnect <- function(con)
+{
+    if(!inherits(con, "sqliteToolsConnection"))
+        stop("con must be sqliteToolsConnection")
+    
+    .Call("close_connection", con, PACKAGE="sqliteTools")
     return(invisible())
 }
 
+# - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - #
+# PRAGMAs of persistent connection (kept until restored or disconnected).
+# Returns previous values of all changed PRAGMAs.
+# - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - #
+
+sqliteToolsPragmas <- function(con, profile=c("none", "default", "bulk", "bulk_wal"),
+    pragmas=NULL, restore=FALSE)
+{
+    profile <- match.arg(profile)
+    
+    if(!inherits(con, "sqliteToolsConnection"))
+        stop("con must be sqliteToolsConnection")
+    
+    checkPragmas(pragmas)
+    
+    if(!is.logical(restore) || length(restore) != 1)
+        stop("restore must be logical")
+    
+    options <- list(pragmaProfile=profile, pragmas=pragmas,
+                        restore=as.integer(restore))
+    
+    res <- .Call("connection_pragmas", con, options, PACKAGE="sqliteTools")
+    return(invisible(res))
+}
+
+checkPragmas <- function(pragmas)
+{
+    if(is.null(pragmas))
+        return(invisible())
+    
+    if(!is.character(pragmas) || is.null(names(pragmas)) || any(names(pragmas) == ""))
+        stop("pragmas must be named character (e.g. c(cache_size='-100000'))")
+    
+    if(length(grep("^[[:alnum:]_-]+$", c(names(pragmas), pragmas), invert=TRUE)))
+        stop("pragmas must only contain names and numbers")
+    
+    return(invisible())
+}
+
+print.sqliteToolsConnection <- function(x, ...)
+{
+    cat("sqliteToolsConnection:", attr(x, "dbfile"), "\n")
+    return(invisible(x))
+}
+
+# - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - #
+# Database file of connection (or file name) for native functions.
+# Native connections (sqliteToolsConnect) are passed as they are,
+# otherwise a separate connection is opened on the file.
+# - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - #
+
+dbHandle <- function(dbcon)
+{
+    if(inherits(dbcon, "sqliteToolsConnection"))
+        return(dbcon)
+    
+    if(is(dbcon, "SQLiteConnection"))
+        dbfile <- dbcon@dbname
+    else
+        dbfile <- dbcon
+    
+    if(!is.character(dbfile) || length(dbfile) != 1)
+        stop("dbcon must be SQLiteConnection or character of length 1")
+    
+    if(!file.exists(dbfile))
+        stop("Database file does not exist!")
+    
+    return(path.expand(dbfile))
+}
+
+# - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - #
+# Query expanded rows without writing the output table
+# (Table valued function 'expand' on a temporary virtual table).
+# - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - #
+
+expandQuery <- function(dbfile, table, boundCols, indexCol, copyCols,
+    expandCols, where=NULL, verbose=FALSE)
+{
+    connection <- NULL
+    if(inherits(dbfile, "sqliteToolsConnection"))
+    {
+        connection <- dbfile
+        dbfile <- attr(connection, "dbfile")
+    }
+    
+    if(!is.character(dbfile) || length(dbfile) != 1)
+        stop("dbfile must be character of length 1")
+    
+    if(!file.exists(dbfile))
+        stop("Database file does not exist!")
+    
+    if(!is.character(table) || length(table) != 1)
+        stop("table must be character of length 1")
+    
+    if(!is.character(boundCols) || length(boundCols) != 2)
+        stop("boundCols must be character of length 2 (lowerBound and upperBound)!")
+    
+    if(!is.character(indexCol) || length(indexCol) != 1)
+        stop("indexCol must be character of length 1")
+    
+    if(!is.character(copyCols))
+        stop("copyCols must be character!")
+    
+    if(!is.character(expandCols))
+        stop("expandCols must be character!")
+    
+    if(length(expandCols) == 0)
+        stop("expandCols must not be empty!")
+    
+    if(is.null(where))
+        where <- ""
+    
+    if(!is.character(where) || length(where) != 1)
+        stop("where must be character of length 1")
+    
+    if(!is.integer(verbose))
+        verbose <- as.integer(verbose)
+    
+    # Same layout as for expandTable ([2] = name of virtual table)
+    params <- c(
+        path.expand(dbfile),
+        table,
+        "expand_query",
+        boundCols[1],
+        boundCols[2],
+        indexCol
+    )
+    
+    # (pParams, pCopyCol, pExpCol, pWhere, pVerbose, pCon)
+    .Call("expand_query", params, copyCols, expandCols, where, verbose,
+            connection, PACKAGE="sqliteTools")
+}
+
+# - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - #
+# Read columnar binary file written by expandTable(output="binary")
+# - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - #
+
+readColumnFile <- function(file)
+{
+    if(!is.character(file) || length(file) != 1)
+        stop("file must be character of length 1")
+    
+    if(!file.exists(file))
+        stop("File does not exist!")
+    
+    .Call("read_column_file", path.expand(file), PACKAGE="sqliteTools")
+}
+
 # - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - #
 # 3) It turned out, that some 'kosten' actually are stored as character
 # inside SQLite (for format reasons: 13,21 instead of 13.21)
 # They have to be converted.
 # - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - #
 
-convertToNum <- function(dbcon, tbl, column)
+convertToNum <- function(dbcon, tbl, column, chunkSize=100000L, rebuild=FALSE,
+    verbose=FALSE)
 {
-    dfr <- dbReadTable(dbcon, tbl)
+    dbfile <- dbHandle(dbcon)
+    
+    if(!is.character(tbl) || length(tbl) != 1)
+        stop("tbl must be character of length 1")
+    
+    if(!is.character(column))
+        stop("column must be character")
+    
+    if(!is.numeric(chunkSize) || length(chunkSize) != 1 || chunkSize < 1)
+        stop("chunkSize must be a single positive number")
+    
+    if(!is.logical(rebuild) || length(rebuild) != 1)
+        stop("rebuild must be logical of length 1")
+    
+    if(!is.integer(verbose))
+        verbose <- as.integer(verbose)
     
-    for(cl in column)
-        dfr[, cl] <- as.numeric(sub(",",".", dfr[, cl]))
+    # (pDbFile, pTable, pColumns, pChunkRows, pRebuild, pVerbose)
+    res <- .Call("convert_to_num", dbfile, tbl, column,
+            as.integer(chunkSize), as.integer(rebuild), verbose,
+            PACKAGE="sqliteTools")
     
-    dbWriteTable(dbcon, tbl, dfr, overwrite=TRUE, row.names=FALSE)
+    return(invisible(res))
+}
+
+# - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - #
+# Read table into data.frame (vectors are allocated once from
+# COUNT(*) or nRows and filled natively)
+# - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - #
+
+checkReadArgs <- function(name, columns, where, nRows)
+{
+    if(!is.character(name) || length(name) != 1)
+        stop("name must be character of length 1")
+    
+    if(!is.null(columns) && !is.character(columns))
+        stop("columns must be character")
+    
+    if(!is.null(where) && (!is.character(where) || length(where) != 1))
+        stop("where must be character of length 1")
+    
+    if(length(nRows) != 1 || (!is.na(nRows) && (!is.numeric(nRows) || nRows < 0)))
+        stop("nRows must be NA or a single number >= 0")
+}
+
+readTableFast <- function(con, name, columns=NULL, where=NULL, nRows=NA,
+    verbose=FALSE)
+{
+    dbfile <- dbHandle(con)
+    checkReadArgs(name, columns, where, nRows)
+    
+    if(!is.integer(verbose))
+        verbose <- as.integer(verbose)
+    
+    # (pDb, pTable, pColumns, pWhere, pNRows, pVerbose)
+    .Call("read_table_fast", dbfile, name, as.character(columns),
+            as.character(where), as.numeric(nRows), verbose,
+            PACKAGE="sqliteTools")
+}
+
+# - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - #
+# Chunked reading: The reader has its own connection, the query stays
+# active until the last chunk has been read or the reader is closed.
+# - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - #
+
+openTableReader <- function(con, name, columns=NULL, where=NULL,
+    chunkSize=100000L, nRows=NA, verbose=FALSE)
+{
+    dbfile <- dbHandle(con)
+    if(inherits(dbfile, "sqliteToolsConnection"))
+        dbfile <- attr(dbfile, "dbfile")
+    
+    checkReadArgs(name, columns, where, nRows)
+    
+    if(!is.numeric(chunkSize) || length(chunkSize) != 1 || chunkSize < 1)
+        stop("chunkSize must be a single positive number")
+    
+    if(!is.integer(verbose))
+        verbose <- as.integer(verbose)
+    
+    # (pDbFile, pTable, pColumns, pWhere, pChunkRows, pNRows, pVerbose)
+    .Call("open_table_reader", dbfile, name, as.character(columns),
+            as.character(where), as.integer(chunkSize), as.numeric(nRows),
+            verbose, PACKAGE="sqliteTools")
+}
+
+readTableChunk <- function(reader)
+{
+    if(!inherits(reader, "sqliteToolsReader"))
+        stop("reader must be sqliteToolsReader")
+    
+    .Call("read_table_chunk", reader, PACKAGE="sqliteTools")
+}
+
+closeTableReader <- function(reader)
+{
+    if(!inherits(reader, "sqliteToolsReader"))
+        stop("reader must be sqliteToolsReader")
+    
+    .Call("close_table_reader", reader, PACKAGE="sqliteTools")
+    return(invisible())
+}
+
+# - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - #
+# Write data.frame into table (values are bound from the column vectors)
+# - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - #
+
+writeTableFast <- function(con, name, df, overwrite=FALSE, chunkSize=100000L,
+    batchSize=64L, verbose=FALSE)
+{
+    # Database file is created when it does not exist
+    if(is.character(con) && length(con) == 1 && !file.exists(con))
+        dbfile <- path.expand(con)
+    else
+        dbfile <- dbHandle(con)
+    
+    if(!is.character(name) || length(name) != 1)
+        stop("name must be character of length 1")
+    
+    if(!is.data.frame(df) || ncol(df) == 0)
+        stop("df must be a data.frame with at least one column")
+    
+    if(!is.numeric(chunkSize) || length(chunkSize) != 1 || chunkSize < 0)
+        stop("chunkSize must be a single number >= 0")
+    
+    if(!is.numeric(batchSize) || length(batchSize) != 1 || batchSize < 0)
+        stop("batchSize must be a single number >= 0")
+    
+    if(!is.integer(verbose))
+        verbose <- as.integer(verbose)
+    
+    # (pDb, pTable, pDf, pChunkRows, pBatchSize, pOverwrite, pVerbose)
+    res <- .Call("write_table_fast", dbfile, name, df, as.integer(chunkSize),
+            as.integer(batchSize), as.integer(overwrite), verbose,
+            PACKAGE="sqliteTools")
+    
+    return(invisible(res))
 }
 
 # - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - #
 # Add woche_index column
 # - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - #
 
-wocheIndex <- function(tbl, bas="fbas", con)
+wocheIndex <- function(tbl, bas="fbas", con, chunkSize=100000L, verbose=FALSE)
 {
-    btb <- dbReadTable(con, bas)
-    n <- length(tbl)
-    for(i in 1:n)
-    {
-        dt <- dbReadTable(con, tbl[i])
-        mtc <- match(dt$vers_id, btb$vers_id)
-        dt$woche_index <- btb$woche_index[mtc]
-        dbWriteTable(con, tbl[i], dt, overwrite=TRUE, row.names=FALSE)
-    }
+    dbfile <- dbHandle(con)
+    
+    if(!is.character(tbl))
+        stop("tbl must be character")
+    
+    if(!is.character(bas) || length(bas) != 1)
+        stop("bas must be character of length 1")
+    
+    if(!is.numeric(chunkSize) || length(chunkSize) != 1 || chunkSize < 1)
+        stop("chunkSize must be a single positive number")
+    
+    if(!is.integer(verbose))
+        verbose <- as.integer(verbose)
+    
+    # (pDbFile, pTables, pBase, pColumns, pChunkRows, pVerbose)
+    res <- .Call("woche_index", dbfile, tbl, bas, c("vers_id", "woche_index"),
+            as.integer(chunkSize), verbose, PACKAGE="sqliteTools")
+    
+    return(invisible(res))
 }
@@ -0,0 +1,176 @@
+/*
+ * column_batch.cpp
+ *
+ *  Created on: 17.10.2026
+ *      Author: kaisers
+ */
+
+#include "column_batch.h"
+
+#include <sstream>
+#include <algorithm>
+
+namespace sqlite {
+
+
+bool column_batch_stmt::prepare(const string &sql_head, unsigned ncols, unsigned nbatch)
+{
+	if(!con)
+		return false;
+
+	if(ncols == 0)
+	{
+		con.getos() << log_error << "[column_batch_stmt] prepare ERROR: Number of columns must be > 0!\n";
+		return false;
+	}
+
+	head = sql_head;
+	n_cols = ncols;
+
+	// Number of rows is restricted by maximal number of host parameters
+	unsigned max_batch = con.get_limit(SQLITE_LIMIT_VARIABLE_NUMBER) / n_cols;
+	if(max_batch == 0)
+	{
+		con.getos() << log_error << "[column_batch_stmt] prepare ERROR: Too many columns (" << n_cols << ")!\n";
+		return false;
+	}
+
+	if( (nbatch == 0) || (nbatch > max_batch) )
+		n_batch = max_batch;
+	else
+		n_batch = nbatch;
+
+	return stmt.prepare(multi_row_sql(head, n_cols, n_batch));
+}
+
+bool column_batch_stmt::insert(const vector<column_buffer> &cols, size_t first, size_t n)
+{
+	if(cols.size() != n_cols)
+	{
+		con.getos() << log_error << "[column_batch_stmt] insert ERROR: " << cols.size()
+			<< " columns given, " << n_cols << " expected!\n";
+		return false;
+	}
+
+	size_t end = first + n;
+	for(; first + n_batch <= end; first += n_batch, ++n_steps)
+	{
+		if(!stmt.step(cols, first, n_batch))
+			return false;
+	}
+
+	if(first == end)
+		return true;
+
+	// Incomplete batch: Separate statement for remaining rows
+	sqlite_stmt tail(con);
+	unsigned nrows = end - first;
+	++n_steps;
+	if(!tail.prepare(multi_row_sql(head, n_cols, nrows)))
+		return false;
+
+	bool success = tail.step(cols, first, nrows);
+	tail.finalize();
+	return success;
+}
+
+bool column_batch_stmt::finalize()
+{
+	return stmt.finalize();
+}
+
+
+// CREATE TABLE IF NOT EXISTS tbl ("a" INTEGER, "b" TEXT);
+// Column names are quoted (names of R data.frames may contain dots).
+static string quote_name(const string &name)
+{
+	string res = "\"";
+	size_t i;
+	for(i = 0; i < name.size(); ++i)
+	{
+		if(name[i] == '"')
+			res += '"';
+		res += name[i];
+	}
+	return res + "\"";
+}
+
+long write_columns(sqlite_con &con, const string &table, const vector<string> &names,
+		const vector<string> &types, const vector<column_buffer> &cols, size_t n_rows,
+		size_t chunk_rows, unsigned batch_size, bool overwrite, bool verbose)
+{
+	ostream &os = con.getos();
+	stringstream create, insert;
+	size_t i;
+
+	if(names.size() != cols.size() || types.size() != cols.size() || cols.empty())
+	{
+		os << log_error << "[write_columns] ERROR: Number of names, types and columns differ or is 0!\n";
+		return -1;
+	}
+
+	if(overwrite && !con.drop_table(table))
+		return -1;
+
+	create << "CREATE TABLE IF NOT EXISTS " << table << " (";
+	insert << "INSERT INTO " << table << " (";
+	for(i = 0; i < cols.size(); ++i)
+	{
+		if(i)
+		{
+			create << ", ";
+			insert << ", ";
+		}
+		create << quote_name(names[i]) << " " << types[i];
+		insert << quote_name(names[i]);
+	}
+	create << ");";
+	insert << ") VALUES ";
+
+	if(verbose)
+		os << "[write_columns] SQL: '" << create.str() << "'\n";
+
+	if(!con.create_table(create.str()))
+		return -1;
+
+	column_batch_stmt stmt(con);
+	if(!stmt.prepare(insert.str(), cols.size(), batch_size))
+		return -1;
+
+	// Chunks are a multiple of the batch size (only the last
+	// chunk needs a separate statement for remaining rows)
+	size_t n_batch = stmt.batch_size();
+	if(chunk_rows == 0 || chunk_rows >= n_rows)
+		chunk_rows = n_rows;
+	else
+		chunk_rows = ((chunk_rows + n_batch - 1) / n_batch) * n_batch;
+
+	if(verbose)
+		os << "[write_columns] SQL: '" << insert.str() << "(?, ...)' x " << n_batch
+			<< " rows, " << chunk_rows << " rows per transaction.\n";
+
+	size_t first, n;
+	for(first = 0; first < n_rows; first += n)
+	{
+		n = std::min(chunk_rows, n_rows - first);
+		con.begin();
+		if(!stmt.insert(cols, first, n))
+		{
+			con.rollback();
+			stmt.finalize();
+			os << log_error << "[write_columns] Insert of rows " << first + 1 << " .. " << first + n
+				<< " into table '" << table << "' failed!\n";
+			return -1;
+		}
+		con.commit();
+	}
+	stmt.finalize();
+
+	if(verbose)
+		os << "[write_columns] " << n_rows << " rows written into table '" << table
+			<< "' (" << stmt.steps() << " INSERT steps).\n";
+	return (long) n_rows;
+}
+
+
+} // namespace sqlite
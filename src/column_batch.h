@@ -0,0 +1,79 @@
+/*
+ * column_batch.h
+ *
+ *  Created on: 17.10.2026
+ *      Author: kaisers
+ *
+ *  Bulk insert of column-major buffers (e.g. the vectors of an R
+ *  data.frame, see writeTableFast in R):
+ *
+ *  column_batch_stmt	: Multi-row INSERT statement. Rows are bound
+ *  					  column by column directly from the buffers
+ *  					  (sqlite_stmt::step(columns, ...)), text is bound
+ *  					  without copy.
+ *  write_columns		: Creates the table and inserts all rows in
+ *  					  chunked transactions.
+ *
+ *  Messages are written to the ostream of the used sqlite_con.
+ */
+
+#ifndef COLUMN_BATCH_H_
+#define COLUMN_BATCH_H_
+
+#include "sqlite_con.h"
+#include "sqlite_stmt.h"
+#include "sqlite_batch.h"
+
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace sqlite {
+
+class column_batch_stmt {
+public:
+	column_batch_stmt(sqlite_con &c) : con(c), stmt(c), n_cols(0), n_batch(0), n_steps(0) {}
+
+	// sql_head: "INSERT INTO tbl (a, b) VALUES " (value tuples are appended)
+	// nbatch: Rows per INSERT statement (0: default_batch_rows)
+	bool prepare(const string &sql_head, unsigned ncols, unsigned nbatch = 0);
+
+	// Inserts rows first .. first + n - 1 of cols (one buffer per column).
+	// Rows after the last complete batch are inserted by a separate
+	// statement (n should be a multiple of batch_size()).
+	bool insert(const vector<column_buffer> &cols, size_t first, size_t n);
+
+	bool finalize();
+
+	unsigned batch_size() const { return n_batch; }
+
+	// Number of executed INSERT statements
+	unsigned long steps() const { return n_steps; }
+
+private:
+	column_batch_stmt(const column_batch_stmt &rhs);
+
+	sqlite_con &con;
+	sqlite_stmt stmt;			// Prepared for n_batch rows
+	string head;
+	unsigned n_cols;
+	unsigned n_batch;
+	unsigned long n_steps;
+};
+
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
+// Creates table (overwrite: existing table is dropped before) with
+// columns (names and types) and inserts rows 0 .. n_rows - 1.
+// A transaction is committed every chunk_rows rows (0: single transaction).
+// Returns number of inserted rows or -1 on error (rows of committed
+// chunks remain in the table).
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
+long write_columns(sqlite_con &con, const string &table, const vector<string> &names,
+		const vector<string> &types, const vector<column_buffer> &cols, size_t n_rows,
+		size_t chunk_rows, unsigned batch_size, bool overwrite, bool verbose);
+
+
+} // namespace sqlite
+#endif /* COLUMN_BATCH_H_ */
@@ -0,0 +1,601 @@
+/*
+ * column_file.cpp
+ *
+ *  Created on: 17.10.2026
+ *      Author: kaisers
+ */
+
+// 64 bit file offsets (fseeko) on 32 bit systems
+#ifndef _FILE_OFFSET_BITS
+#define _FILE_OFFSET_BITS 64
+#endif
+
+#include "column_file.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+namespace sqlite {
+
+
+int column_file_affinity(const string &decl)
+{
+	string type(decl);
+	transform(type.begin(), type.end(), type.begin(), ::toupper);
+
+	if(type.find("INT") != string::npos)
+		return COL_INT64;
+	if(type.empty() || type.find("CHAR") != string::npos || type.find("CLOB") != string::npos
+			|| type.find("TEXT") != string::npos || type.find("BLOB") != string::npos)
+		return COL_STRING;
+	return COL_DOUBLE;
+}
+
+
+// Offsets may exceed 2 GB (long has 32 bits on Windows)
+static int seek_file(FILE *file, uint64_t offset)
+{
+#ifdef _WIN32
+	return _fseeki64(file, (__int64) offset, SEEK_SET);
+#else
+	return fseeko(file, (off_t) offset, SEEK_SET);
+#endif
+}
+
+bool column_file_writer::write_at(uint64_t offset, const void *data, size_t size)
+{
+	if(seek_file(file, offset) != 0 || fwrite(data, 1, size, file) != size)
+	{
+		os << "[column_file_writer] Write error on file '" << filename << "'!\n";
+		return false;
+	}
+	return true;
+}
+
+bool column_file_writer::open(const string &fname, const vector<string> &names, const vector<int> &types, int64_t n_rows_total)
+{
+	filename = fname;
+	n_total = n_rows_total;
+	n_rows = 0;
+
+	file = fopen(filename.c_str(), "wb");
+	if(!file)
+	{
+		os << "[column_file_writer] Cannot open file '" << filename << "'!\n";
+		return false;
+	}
+
+	unsigned j, n_cols = names.size();
+
+	// Names
+	string name_block;
+	for(j = 0; j < n_cols; ++j)
+	{
+		name_block.append(names[j]);
+		name_block.push_back('\0');
+	}
+	name_block.resize(column_file_pad(name_block.size()), '\0');
+
+	column_file_header h;
+	memcpy(h.magic, column_file_magic, sizeof(h.magic));
+	h.version = column_file_version;
+	h.n_cols = n_cols;
+	h.n_rows = n_total;
+	h.names_size = name_block.size();
+
+	// Column data sections
+	uint64_t offset = sizeof(column_file_header) + n_cols * sizeof(column_file_entry) + name_block.size();
+	cols.assign(n_cols, column());
+	entries.assign(n_cols, column_file_entry());
+	for(j = 0; j < n_cols; ++j)
+	{
+		column_file_entry &e = entries[j];
+		e.type = types[j];
+		e.reserved = 0;
+		e.data_offset = offset;
+		e.heap_offset = 0;
+		e.heap_size = 0;
+
+		cols[j].type = types[j];
+		if(e.type == COL_STRING)
+		{
+			cols[j].heap = tmpfile();
+			if(!cols[j].heap)
+			{
+				os << "[column_file_writer] Cannot create temporary file!\n";
+				return false;
+			}
+			offset += column_file_pad((n_total + 1) * sizeof(int64_t) + n_total);
+		}
+		else
+			offset += n_total * 8;
+		cols[j].buf.reserve(buf_size + 8);
+	}
+
+	row.assign(n_cols, sqlite_cell());
+	return write_at(0, &h, sizeof(h))
+			&& write_at(sizeof(h), &entries[0], n_cols * sizeof(column_file_entry))
+			&& write_at(sizeof(h) + n_cols * sizeof(column_file_entry), name_block.data(), name_block.size());
+}
+
+bool column_file_writer::flush_column(column &c, column_file_entry &e)
+{
+	if(c.buf.empty())
+		return true;
+
+	if(!write_at(e.data_offset + c.written, &c.buf[0], c.buf.size()))
+		return false;
+
+	c.written += c.buf.size();
+	c.buf.clear();
+	return true;
+}
+
+bool column_file_writer::step()
+{
+	if(n_rows >= n_total)
+	{
+		os << "[column_file_writer] step ERROR: Number of rows (" << n_total << ") exceeded!\n";
+		return false;
+	}
+
+	unsigned j, n_cols = cols.size();
+	for(j = 0; j < n_cols; ++j)
+	{
+		column &c = cols[j];
+		const sqlite_cell &v = row[j];
+		char bytes[8];
+
+		if(c.type == COL_INT64)
+		{
+			int64_t i;
+			switch(v.type)
+			{
+				case SQLITE_INTEGER:	i = v.ival; break;
+				case SQLITE_FLOAT:		i = (int64_t) v.dval; break;
+				case SQLITE_TEXT:		i = atoll(v.text.c_str()); break;
+				default:				i = column_file_na_int;
+			}
+			memcpy(bytes, &i, 8);
+			c.buf.insert(c.buf.end(), bytes, bytes + 8);
+		}
+		else if(c.type == COL_DOUBLE)
+		{
+			double d;
+			switch(v.type)
+			{
+				case SQLITE_INTEGER:	d = (double) v.ival; break;
+				case SQLITE_FLOAT:		d = v.dval; break;
+				case SQLITE_TEXT:		d = strtod(v.text.c_str(), NULL); break;
+				default:				memcpy(&d, &column_file_na_double_bits, 8);
+			}
+			memcpy(bytes, &d, 8);
+			c.buf.insert(c.buf.end(), bytes, bytes + 8);
+		}
+		else
+		{
+			// Heap offset of value
+			int64_t start = c.heap_size;
+			memcpy(bytes, &start, 8);
+			c.buf.insert(c.buf.end(), bytes, bytes + 8);
+
+			char sbuf[32];
+			const char *s = 0;
+			switch(v.type)
+			{
+				case SQLITE_TEXT:		s = v.text.c_str(); break;
+				case SQLITE_INTEGER:	snprintf(sbuf, sizeof(sbuf), "%lld", (long long) v.ival); s = sbuf; break;
+				case SQLITE_FLOAT:		snprintf(sbuf, sizeof(sbuf), "%.15g", v.dval); s = sbuf; break;
+			}
+			c.nulls.push_back(s == 0 ? 1 : 0);
+			if(s)
+			{
+				size_t len = (v.type == SQLITE_TEXT) ? v.text.size() : strlen(s);
+				if(fwrite(s, 1, len, c.heap) != len)
+				{
+					os << "[column_file_writer] Write error on temporary file!\n";
+					return false;
+				}
+				c.heap_size += len;
+			}
+		}
+
+		if(c.buf.size() >= buf_size && !flush_column(c, entries[j]))
+			return false;
+	}
+	++n_rows;
+	return true;
+}
+
+bool column_file_writer::close()
+{
+	if(!file)
+		return false;
+
+	bool success = true;
+	if(n_rows != n_total)
+	{
+		os << "[column_file_writer] close ERROR: " << n_rows << " rows written (expected: " << n_total << ")!\n";
+		success = false;
+	}
+
+	unsigned j, n_cols = cols.size();
+	uint64_t heap_offset = 0;
+	for(j = 0; success && j < n_cols; ++j)
+	{
+		column &c = cols[j];
+		column_file_entry &e = entries[j];
+		success = flush_column(c, e);
+
+		if(success && c.type == COL_STRING)
+		{
+			// Terminal offset and NULL flags
+			int64_t end = c.heap_size;
+			uint64_t pos = e.data_offset + n_total * sizeof(int64_t);
+			success = write_at(pos, &end, 8);
+			if(success && n_total)
+				success = write_at(pos + 8, &c.nulls[0], c.nulls.size());
+		}
+	}
+
+	// String heaps (after data sections)
+	if(success && n_cols)
+	{
+		const column_file_entry &last = entries[n_cols - 1];
+		if(last.type == COL_STRING)
+			heap_offset = last.data_offset + column_file_pad((n_total + 1) * sizeof(int64_t) + n_total);
+		else
+			heap_offset = last.data_offset + n_total * 8;
+	}
+
+	vector<char> buf(1 << 16);
+	for(j = 0; success && j < n_cols; ++j)
+	{
+		column &c = cols[j];
+		column_file_entry &e = entries[j];
+		if(c.type != COL_STRING)
+			continue;
+
+		e.heap_offset = heap_offset;
+		e.heap_size = c.heap_size;
+		rewind(c.heap);
+
+		uint64_t pos = heap_offset;
+		size_t n;
+		while(success && (n = fread(&buf[0], 1, buf.size(), c.heap)) > 0)
+		{
+			success = write_at(pos, &buf[0], n);
+			pos += n;
+		}
+		heap_offset = column_file_pad(heap_offset + c.heap_size);
+	}
+
+	if(success && n_cols)
+		success = write_at(sizeof(column_file_header), &entries[0], n_cols * sizeof(column_file_entry));
+
+	for(j = 0; j < n_cols; ++j)
+	{
+		if(cols[j].heap)
+			fclose(cols[j].heap);
+		cols[j].heap = 0;
+	}
+
+	if(fclose(file) != 0)
+		success = false;
+	file = 0;
+
+	if(!success)
+		remove(filename.c_str());
+	return success;
+}
+
+// Removes incomplete file
+void column_file_writer::abort()
+{
+	unsigned j;
+	for(j = 0; j < cols.size(); ++j)
+	{
+		if(cols[j].heap)
+			fclose(cols[j].heap);
+		cols[j].heap = 0;
+	}
+
+	if(file)
+	{
+		fclose(file);
+		file = 0;
+		remove(filename.c_str());
+	}
+}
+
+bool csv_file_writer::open(const string &fname, const vector<string> &names)
+{
+	filename = fname;
+	n_rows = 0;
+
+	file = fopen(filename.c_str(), "wb");
+	if(!file)
+	{
+		os << "[csv_file_writer] Cannot open file '" << filename << "'!\n";
+		return false;
+	}
+	setvbuf(file, 0, _IOFBF, 1 << 16);
+
+	unsigned j;
+	line.clear();
+	for(j = 0; j < names.size(); ++j)
+	{
+		if(j)
+			line.push_back(',');
+		put_text(names[j]);
+	}
+	line.push_back('\n');
+	row.assign(names.size(), sqlite_cell());
+
+	return fwrite(line.data(), 1, line.size(), file) == line.size();
+}
+
+void csv_file_writer::put_text(const string &text)
+{
+	line.push_back('"');
+	string::const_iterator iter;
+	for(iter = text.begin(); iter != text.end(); ++iter)
+	{
+		if(*iter == '"')
+			line.push_back('"');
+		line.push_back(*iter);
+	}
+	line.push_back('"');
+}
+
+bool csv_file_writer::step()
+{
+	char buf[32];
+	unsigned j;
+
+	line.clear();
+	for(j = 0; j < row.size(); ++j)
+	{
+		const sqlite_cell &c = row[j];
+		if(j)
+			line.push_back(',');
+
+		switch(c.type)
+		{
+			case SQLITE_INTEGER:
+				snprintf(buf, sizeof(buf), "%lld", (long long) c.ival);
+				line.append(buf);
+				break;
+			case SQLITE_FLOAT:
+				snprintf(buf, sizeof(buf), "%.15g", c.dval);
+				line.append(buf);
+				break;
+			case SQLITE_TEXT:
+				put_text(c.text);
+				break;
+		}
+	}
+	line.push_back('\n');
+
+	if(fwrite(line.data(), 1, line.size(), file) != line.size())
+	{
+		os << "[csv_file_writer] Write error on file '" << filename << "'!\n";
+		return false;
+	}
+	++n_rows;
+	return true;
+}
+
+bool csv_file_writer::close()
+{
+	if(!file)
+		return false;
+
+	bool success = (fclose(file) == 0);
+	file = 0;
+	return success;
+}
+
+
+bool column_file_reader::open(const string &filename)
+{
+	close();
+
+#ifndef _WIN32
+	int fd = ::open(filename.c_str(), O_RDONLY);
+	if(fd < 0)
+	{
+		os << "[column_file_reader] Cannot open file '" << filename << "'!\n";
+		return false;
+	}
+
+	struct stat st;
+	if(fstat(fd, &st) != 0 || st.st_size == 0)
+	{
+		::close(fd);
+		os << "[column_file_reader] Cannot read size of file '" << filename << "'!\n";
+		return false;
+	}
+	size = st.st_size;
+
+	void *p = mmap(0, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	::close(fd);
+	if(p == MAP_FAILED)
+	{
+		size = 0;
+		os << "[column_file_reader] Cannot map file '" << filename << "'!\n";
+		return false;
+	}
+	data = (const char*) p;
+#else
+	// No mmap: File is read into memory
+	FILE *f = fopen(filename.c_str(), "rb");
+	if(!f)
+	{
+		os << "[column_file_reader] Cannot open file '" << filename << "'!\n";
+		return false;
+	}
+	char buf[1 << 16];
+	size_t n;
+	content.clear();
+	while((n = fread(buf, 1, sizeof(buf), f)) > 0)
+		content.insert(content.end(), buf, buf + n);
+	fclose(f);
+	data = content.empty() ? 0 : &content[0];
+	size = content.size();
+#endif
+
+	// Validation of header and directory
+	if(size < sizeof(column_file_header) || memcmp(header().magic, column_file_magic, sizeof(column_file_magic)) != 0
+			|| header().version != column_file_version)
+	{
+		os << "[column_file_reader] '" << filename << "' is no column file (version " << column_file_version << ")!\n";
+		close();
+		return false;
+	}
+
+	uint64_t names_offset = sizeof(column_file_header) + (uint64_t) n_cols() * sizeof(column_file_entry);
+	if(names_offset > size || header().names_size > size - names_offset)
+	{
+		os << "[column_file_reader] File '" << filename << "' is truncated!\n";
+		close();
+		return false;
+	}
+
+	// Each column needs at least 8 bytes per row (also prevents overflow below)
+	if(n_rows() < 0 || (uint64_t) n_rows() > size / 8)
+	{
+		os << "[column_file_reader] File '" << filename << "' is truncated!\n";
+		close();
+		return false;
+	}
+
+	unsigned j;
+	int64_t i;
+	const char *p_name = data + names_offset;
+	for(j = 0; j < n_cols(); ++j)
+	{
+		const column_file_entry &e = entry(j);
+		uint64_t n_bytes = e.type == COL_STRING ? (n_rows() + 1) * 8 + n_rows() : n_rows() * 8;
+		if(e.data_offset > size || n_bytes > size - e.data_offset
+				|| (e.type == COL_STRING && (e.heap_offset > size || e.heap_size > size - e.heap_offset)))
+		{
+			os << "[column_file_reader] File '" << filename << "' is truncated!\n";
+			close();
+			return false;
+		}
+
+		// String offsets must be increasing and inside of heap
+		if(e.type == COL_STRING)
+		{
+			const int64_t *offsets = (const int64_t*) (data + e.data_offset);
+			bool valid = offsets[0] >= 0 && (uint64_t) offsets[n_rows()] <= e.heap_size;
+			for(i = 0; valid && i < n_rows(); ++i)
+				valid = offsets[i] <= offsets[i + 1];
+
+			if(!valid)
+			{
+				os << "[column_file_reader] File '" << filename << "' has invalid string offsets in column " << j << "!\n";
+				close();
+				return false;
+			}
+		}
+
+		// Name must be terminated inside of name block
+		const char *names_end = data + names_offset + header().names_size;
+		const char *p_end = (const char*) memchr(p_name, '\0', names_end - p_name);
+		if(p_name >= names_end || !p_end)
+		{
+			os << "[column_file_reader] File '" << filename << "' has invalid column names!\n";
+			close();
+			return false;
+		}
+		names.push_back(p_name);
+		p_name = p_end + 1;
+	}
+	return true;
+}
+
+void column_file_reader::close()
+{
+#ifndef _WIN32
+	if(data)
+		munmap((void*) data, size);
+#else
+	content.clear();
+#endif
+	data = 0;
+	size = 0;
+	names.clear();
+}
+
+
+long expand_to_file(sqlite_con &con, const expand_spec &spec, const string &format, const string &file,
+		expand_stats *stats)
+{
+	vector<string> names;
+	vector<int> types;
+	list<string>::const_iterator iter, titer;
+
+	names.push_back("id");
+	names.push_back("rid");
+	names.push_back(spec.index_column);
+	types.assign(3, COL_INT64);
+
+	for(iter = spec.copyCols.begin(), titer = spec.copyColTypes.begin(); iter != spec.copyCols.end(); ++iter, ++titer)
+	{
+		names.push_back(*iter);
+		types.push_back(column_file_affinity(*titer));
+	}
+
+	for(iter = spec.expandCols.begin(); iter != spec.expandCols.end(); ++iter)
+	{
+		names.push_back(*iter);
+		types.push_back(COL_DOUBLE);
+	}
+
+	sqlite_stmt read_stmt(con);
+	if(!read_stmt.prepare(spec.select_sql(spec.where_sql())))
+		return -1;
+
+	long nRows = -1;
+	bool success;
+	if(format == "csv")
+	{
+		csv_file_writer writer(con.getos());
+		success = writer.open(file, names);
+		if(success)
+			nRows = expand_rows(read_stmt, writer, spec, stats);
+		success = writer.close() && success;
+	}
+	else
+	{
+		// Arrays are preallocated: Number of rows is needed in advance
+		sqlite3_int64 n_total = -1;
+		sqlite_stmt span_stmt(con);
+		if(span_stmt.prepare(spec.span_sql()) && span_stmt.fetch())
+		{
+			n_total = span_stmt.column_int(0);
+			span_stmt.reset();
+		}
+		span_stmt.finalize();
+
+		column_file_writer writer(con.getos());
+		success = (n_total >= 0) && writer.open(file, names, types, n_total);
+		if(success)
+			nRows = expand_rows(read_stmt, writer, spec, stats);
+		success = (nRows >= 0) && writer.close() && success;
+	}
+	if(stats)
+		stats->read.add(read_stmt);
+	read_stmt.finalize();
+
+	return success ? nRows : -1;
+}
+
+
+} // namespace sqlite
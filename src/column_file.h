@@ -0,0 +1,280 @@
+/*
+ * column_file.h
+ *
+ *  Created on: 17.10.2026
+ *      Author: kaisers
+ *
+ *  Output of expanded rows into flat files (no SQLite table):
+ *
+ *  column_file_writer	: Columnar binary file. One contiguous array per
+ *  					  column, written through per-column buffers.
+ *  csv_file_writer		: Comma separated text file with header line.
+ *  column_file_reader	: Memory mapped access to columnar binary files.
+ *
+ *  Writers have the same bind/step interface as sqlite_batch_stmt,
+ *  so they can be used with expand_row and expand_rows (see expander.h).
+ *  expand_to_file expands a source table into either file format.
+ *
+ *  Binary layout (native byte order, all offsets 8 byte aligned):
+ *
+ *  column_file_header
+ *  column_file_entry	x n_cols
+ *  Column names		'\0' terminated, padded to 8 bytes
+ *  Column data			COL_INT64	: int64  x n_rows (NA: INT64_MIN)
+ *  					COL_DOUBLE	: double x n_rows (NA: R's NA_real_)
+ *  					COL_STRING	: int64 x (n_rows + 1) heap offsets,
+ *  								  uint8 x n_rows NULL flags
+ *  String heaps		UTF-8 characters of COL_STRING columns (not terminated)
+ */
+
+#ifndef COLUMN_FILE_H_
+#define COLUMN_FILE_H_
+
+#include "sqlite_batch.h"
+#include "expander.h"
+
+#include <string>
+#include <vector>
+#include <sstream>
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <stdint.h>
+
+using namespace std;
+
+namespace sqlite {
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
+// File format
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
+enum column_file_type { COL_INT64 = 1, COL_DOUBLE = 2, COL_STRING = 3 };
+
+const char column_file_magic[8] = { 'S', 'Q', 'T', 'C', 'O', 'L', '1', '\0' };
+const uint32_t column_file_version = 1;
+const int64_t column_file_na_int = INT64_MIN;
+const uint64_t column_file_na_double_bits = 0x7FF00000000007A2ULL;	// Bit pattern of NA_real_
+
+struct column_file_header
+{
+	char magic[8];
+	uint32_t version;
+	uint32_t n_cols;
+	int64_t n_rows;
+	uint64_t names_size;		// Including padding
+};
+
+struct column_file_entry
+{
+	uint32_t type;				// column_file_type
+	uint32_t reserved;
+	uint64_t data_offset;
+	uint64_t heap_offset;		// COL_STRING only
+	uint64_t heap_size;
+};
+
+inline uint64_t column_file_pad(uint64_t n) { return (n + 7) & ~((uint64_t) 7); }
+
+// Column type for declared SQLite type (affinity rules)
+int column_file_affinity(const string &decl);
+
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
+// Common bind interface of file writers (values of current row)
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
+class row_writer {
+public:
+	row_writer(ostream &o) : os(o), n_rows(0), auto_id(0) {}
+	virtual ~row_writer() {}
+
+	ostream & getos() const { return os; }
+
+	unsigned long getAutoId() { return ++auto_id; }
+	void setAutoId(unsigned long id) { auto_id = id; }
+	unsigned long lastAutoId() const { return auto_id; }
+
+	// Number of written rows
+	int64_t size() const { return n_rows; }
+
+	// Same semantics as sqlite_batch_stmt (pos is 1-based position inside row)
+	void bind_int(unsigned pos, const sqlite3_int64 &value)
+	{
+		sqlite_cell &c = row[pos - 1];
+		c.type = SQLITE_INTEGER;
+		c.ival = value;
+	}
+
+	void bind_double(unsigned pos, const double &value)
+	{
+		sqlite_cell &c = row[pos - 1];
+		c.type = SQLITE_FLOAT;
+		c.dval = value;
+	}
+
+	void bind_text(unsigned pos, const char *text)
+	{
+		bind_text(pos, text, strlen(text));
+	}
+
+	void bind_text(unsigned pos, const char *text, int n)
+	{
+		sqlite_cell &c = row[pos - 1];
+		c.type = SQLITE_TEXT;
+		c.text.assign(text, n);
+	}
+
+	// Written as text
+	void bind_blob(unsigned pos, const void *data, int n)
+	{
+		bind_text(pos, (const char*) data, n);
+	}
+
+	void bind_null(unsigned pos)
+	{
+		row[pos - 1].type = SQLITE_NULL;
+	}
+
+	virtual bool step() = 0;
+	virtual bool flush() = 0;
+
+protected:
+	ostream &os;
+	vector<sqlite_cell> row;
+	int64_t n_rows;
+	unsigned long int auto_id;
+};
+
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
+// Columnar binary file
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
+class column_file_writer : public row_writer {
+public:
+	column_file_writer(ostream &o, size_t buffer_size = 1 << 16) :
+		row_writer(o), file(0), buf_size(buffer_size), n_total(0) {}
+	virtual ~column_file_writer() { abort(); }
+
+	// n_rows: Number of rows which will be written (arrays are preallocated)
+	bool open(const string &filename, const vector<string> &names, const vector<int> &types, int64_t n_rows);
+	virtual bool step();
+	virtual bool flush() { return true; }
+
+	// Writes remaining buffers and string heaps
+	bool close();
+
+private:
+	column_file_writer(const column_file_writer &rhs);
+
+	struct column
+	{
+		column() : type(0), written(0), heap(0), heap_size(0) {}
+		int type;
+		uint64_t written;			// Bytes of data section written to file
+		vector<char> buf;
+		vector<char> nulls;			// COL_STRING
+		FILE *heap;					// COL_STRING: temporary file
+		uint64_t heap_size;
+	};
+
+	bool write_at(uint64_t offset, const void *data, size_t size);
+	bool flush_column(column &c, column_file_entry &e);
+	void abort();
+
+	string filename;
+	FILE *file;
+	size_t buf_size;
+	int64_t n_total;
+	vector<column> cols;
+	vector<column_file_entry> entries;
+};
+
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
+// CSV file (RFC 4180 quoting for text values, NULL as empty field)
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
+class csv_file_writer : public row_writer {
+public:
+	csv_file_writer(ostream &o) : row_writer(o), file(0) {}
+	virtual ~csv_file_writer() { if(file) fclose(file); }
+
+	bool open(const string &filename, const vector<string> &names);
+	virtual bool step();
+	virtual bool flush() { return true; }
+	bool close();
+
+private:
+	csv_file_writer(const csv_file_writer &rhs);
+
+	void put_text(const string &text);
+
+	string filename;
+	FILE *file;
+	string line;
+};
+
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
+// Reader for columnar binary file (memory mapped)
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
+class column_file_reader {
+public:
+	column_file_reader(ostream &o) : os(o), data(0), size(0) {}
+	~column_file_reader() { close(); }
+
+	bool open(const string &filename);
+	void close();
+
+	unsigned n_cols() const { return header().n_cols; }
+	int64_t n_rows() const { return header().n_rows; }
+
+	int type(unsigned col) const { return entry(col).type; }
+	const char * name(unsigned col) const { return names[col]; }
+
+	const int64_t * int_column(unsigned col) const { return (const int64_t*) (data + entry(col).data_offset); }
+	const double * double_column(unsigned col) const { return (const double*) (data + entry(col).data_offset); }
+
+	// String value (0 for NULL)
+	const char * text(unsigned col, int64_t row, size_t &len) const
+	{
+		const column_file_entry &e = entry(col);
+		const int64_t *offsets = (const int64_t*) (data + e.data_offset);
+		const uint8_t *nulls = (const uint8_t*) (offsets + n_rows() + 1);
+		if(nulls[row])
+			return 0;
+		len = offsets[row + 1] - offsets[row];
+		return data + e.heap_offset + offsets[row];
+	}
+
+private:
+	column_file_reader(const column_file_reader &rhs);
+
+	const column_file_header & header() const { return *(const column_file_header*) data; }
+	const column_file_entry & entry(unsigned col) const
+	{
+		return ((const column_file_entry*) (data + sizeof(column_file_header)))[col];
+	}
+
+	ostream &os;
+	const char *data;
+	size_t size;
+	vector<const char*> names;
+#ifdef _WIN32
+	vector<char> content;
+#endif
+};
+
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
+// Expansion into flat file. Columns are the same as for the output
+// table (expand_spec::create_sql).
+// format: "binary" or "csv"
+// Returns number of source rows or -1 on error.
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
+long expand_to_file(sqlite_con &con, const expand_spec &spec, const string &format, const string &file,
+		expand_stats *stats = 0);
+
+
+} // namespace sqlite
+#endif /* COLUMN_FILE_H_ */
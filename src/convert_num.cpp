@@ -0,0 +1,194 @@
+/*
+ * convert_num.cpp
+ *
+ *  Created on: 17.10.2026
+ *      Author: kaisers
+ */
+
+#include "convert_num.h"
+
+namespace sqlite {
+
+
+bool parse_dec_comma(const char *text, int n_bytes, double &value)
+{
+	char buf[64];
+	string str;
+	char *p = buf;
+
+	if(n_bytes < (int) sizeof(buf))
+	{
+		memcpy(buf, text, n_bytes);
+		buf[n_bytes] = 0;
+	}
+	else
+	{
+		str.assign(text, n_bytes);
+		p = &str[0];
+	}
+
+	char *comma = strchr(p, ',');
+	if(comma)
+		*comma = '.';
+
+	while(isspace((unsigned char) *p))
+		++p;
+	if(*p == 0)
+		return false;
+
+	char *end;
+	value = strtod(p, &end);
+	if(end == p)
+		return false;
+
+	while(isspace((unsigned char) *end))
+		++end;
+	return *end == 0;
+}
+
+void dec_comma_func(sqlite3_context *ctx, int argc, sqlite3_value **argv)
+{
+	sqlite3_value *v = argv[0];
+	if(sqlite3_value_type(v) != SQLITE_TEXT)
+	{
+		sqlite3_result_value(ctx, v);
+		return;
+	}
+
+	double value;
+	const char *text = (const char*) sqlite3_value_text(v);
+	if(parse_dec_comma(text, sqlite3_value_bytes(v), value))
+		sqlite3_result_double(ctx, value);
+	else
+		sqlite3_result_null(ctx);
+}
+
+bool register_dec_comma(sqlite_con &con)
+{
+	return con.create_function("dec_comma", 1, dec_comma_func);
+}
+
+
+bool is_text_affinity(const string &decl)
+{
+	string type(decl);
+	transform(type.begin(), type.end(), type.begin(), ::toupper);
+
+	if(type.find("INT") != string::npos)
+		return false;
+	return type.find("CHAR") != string::npos || type.find("CLOB") != string::npos
+			|| type.find("TEXT") != string::npos;
+}
+
+long update_chunked(sqlite_con &con, const string &table, const string &update_sql,
+		sqlite3_int64 chunk_rows, bool verbose)
+{
+	ostream &os = con.getos();
+	sqlite3_int64 min_rowid = 0, max_rowid = 0;
+
+	sqlite_stmt range(con);
+	if(!range.prepare("SELECT MIN(rowid), MAX(rowid) FROM " + table + ";") || !range.fetch())
+		return -1;
+	if(range.column_is_null(0))
+	{
+		range.finalize();
+		return 0;
+	}
+	min_rowid = range.column_int(0);
+	max_rowid = range.column_int(1);
+	range.reset();
+	range.finalize();
+
+	sqlite_stmt stmt(con);
+	if(!stmt.prepare(update_sql))
+		return -1;
+
+	long n_updated = 0;
+	sqlite3_int64 lo, hi;
+	for(lo = min_rowid; lo <= max_rowid; lo = hi + 1)
+	{
+		hi = (max_rowid - lo < chunk_rows) ? max_rowid : lo + chunk_rows - 1;
+
+		con.begin();
+		if(!stmt.bind_int64(1, lo) || !stmt.bind_int64(2, hi) || !stmt.step())
+		{
+			con.rollback();
+			stmt.finalize();
+			return -1;
+		}
+		n_updated += con.changes();
+		con.commit();
+
+		if(verbose)
+			os << "[update_chunked] rowid " << lo << " - " << hi << ": " << n_updated << " rows updated.\n";
+	}
+	stmt.finalize();
+	return n_updated;
+}
+
+long convert_column(sqlite_con &con, const string &table, const string &column,
+		sqlite3_int64 chunk_rows, bool rebuild, bool verbose)
+{
+	ostream &os = con.getos();
+	bool found;
+	string decl;
+
+	if(!get_column_decltype(con, table, column, found, decl))
+		return -1;
+
+	if(!found)
+	{
+		os << "[convert_column] Table '" << table << "' has no column '" << column << "'!\n";
+		return -1;
+	}
+
+	// Only rows whose value changes are updated. With TEXT affinity, the
+	// REAL result is compared (and stored) as text, so values with '.'
+	// are not touched again.
+	stringstream sql;
+	if(!rebuild)
+	{
+		sql << "UPDATE " << table << " SET " << column << " = dec_comma(" << column << ")"
+				<< " WHERE rowid BETWEEN ?1 AND ?2 AND typeof(" << column << ") = 'text'"
+				<< " AND dec_comma(" << column << ") IS NOT " << column << ";";
+		return update_chunked(con, table, sql.str(), chunk_rows, verbose);
+	}
+
+	// - - - - - - - - - - - - - - - - - - - - - - - - - //
+	// Rebuild (opt-in): Replace by new REAL column, so
+	// values are stored as REAL for every affinity.
+	// Rewrites the whole table in one transaction.
+	// - - - - - - - - - - - - - - - - - - - - - - - - - //
+	if(sqlite3_libversion_number() < 3035000)
+	{
+		os << "[convert_column] Rebuild of column '" << column << "' "
+				<< "requires SQLite >= 3.35 (ALTER TABLE DROP COLUMN)!\n";
+		return -1;
+	}
+
+	string tmp_column = column + "_dec_comma";
+	sql << "UPDATE " << table << " SET " << tmp_column << " = dec_comma(" << column << ");";
+
+	con.begin();
+	bool success = con.exec("ALTER TABLE " + table + " ADD COLUMN " + tmp_column + " REAL;")
+			&& con.exec(sql.str());
+	long n_updated = success ? con.changes() : -1;
+
+	success = success && con.exec("ALTER TABLE " + table + " DROP COLUMN " + column + ";")
+			&& con.exec("ALTER TABLE " + table + " RENAME COLUMN " + tmp_column + " TO " + column + ";");
+	if(!success)
+	{
+		con.rollback();
+		os << "[convert_column] Rebuild of column '" << column << "' failed (column is indexed "
+				<< "or used by a view, trigger or constraint?)!\n";
+		return -1;
+	}
+	con.commit();
+
+	if(verbose)
+		os << "[convert_column] Column '" << column << "' replaced by REAL column.\n";
+	return n_updated;
+}
+
+
+} // namespace sqlite
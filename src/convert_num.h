@@ -0,0 +1,78 @@
+/*
+ * convert_num.h
+ *
+ *  Created on: 17.10.2026
+ *      Author: kaisers
+ *
+ *  Conversion of decimal comma text values ('13,21') into REAL values
+ *  inside the database (replaces reading and rewriting the whole table
+ *  from R).
+ *
+ *  The SQL function dec_comma(x) replaces the first ',' by '.' and
+ *  converts text values into REAL (NULL when the text is not a number,
+ *  as for as.numeric in R). Other values are returned unchanged.
+ *
+ *  Columns are converted in place by UPDATE statements over rowid ranges
+ *  (one transaction per chunk), so memory usage does not depend on
+ *  table size. Only rows with a changed value are written.
+ *  Columns with TEXT affinity store the converted values as text
+ *  ('13.21'). Opt-in rebuild replaces the column by a new REAL column
+ *  (appended at the end of the table, whole table is rewritten,
+ *  requires SQLite >= 3.35).
+ */
+
+#ifndef CONVERT_NUM_H_
+#define CONVERT_NUM_H_
+
+#include "sqlite_con.h"
+#include "sqlite_stmt.h"
+#include "expander.h"
+
+#include <string>
+#include <sstream>
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+
+using namespace std;
+
+namespace sqlite {
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
+// Parsing of decimal comma numbers
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
+
+// Returns false for empty text and text which is not completely numeric
+// (leading and trailing white space is allowed).
+bool parse_dec_comma(const char *text, int n_bytes, double &value);
+
+// SQL function dec_comma(x)
+void dec_comma_func(sqlite3_context *ctx, int argc, sqlite3_value **argv);
+
+bool register_dec_comma(sqlite_con &con);
+
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
+// Column conversion
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
+
+// TEXT affinity (rule 2 of the SQLite affinity rules)
+bool is_text_affinity(const string &decl);
+
+// Runs update (with rowid range bound to ?1 and ?2) in chunks of
+// chunk_rows rowids (one transaction per chunk).
+// Returns number of updated rows or -1 on error.
+long update_chunked(sqlite_con &con, const string &table, const string &update_sql,
+		sqlite3_int64 chunk_rows, bool verbose);
+
+// Converts text values of column into REAL (in place, chunked).
+// rebuild: Column is replaced by REAL column (one transaction, fails
+// when the column is indexed or used by a view, trigger or constraint).
+// Returns number of converted rows or -1 on error.
+long convert_column(sqlite_con &con, const string &table, const string &column,
+		sqlite3_int64 chunk_rows, bool rebuild, bool verbose);
+
+
+} // namespace sqlite
+#endif /* CONVERT_NUM_H_ */
@@ -0,0 +1,190 @@
+/*
+ * distribution.cpp
+ *
+ *  Created on: 17.10.2026
+ *      Author: kaisers
+ */
+
+#include "distribution.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define DISTRIBUTION_AVX2
+#endif
+
+namespace sqlite {
+
+
+int dist_kernel_from_name(const string &name)
+{
+	if(name == "even")		return DIST_EVEN;
+	if(name == "days")		return DIST_DAYS;
+	if(name == "weights")	return DIST_WEIGHTS;
+	if(name == "first")		return DIST_FIRST;
+	if(name == "last")		return DIST_LAST;
+	return -1;
+}
+
+bool weight_table::load(sqlite_con &con, const string &table)
+{
+	ostream &os = con.getos();
+	const sqlite3_int64 max_range = 1 << 24;
+
+	// First column: index value, second column: weight
+	sqlite_stmt s(con);
+	if(!s.prepare("SELECT * FROM " + table + ";"))
+		return false;
+
+	if(s.column_count() < 2)
+	{
+		os << "[weight_table] Table '" << table << "' must have two columns (index, weight)!\n";
+		return false;
+	}
+
+	vector<pair<sqlite3_int64, double> > values;
+	while(s.fetch())
+	{
+		if(!s.column_is_null(0) && !s.column_is_null(1))
+			values.push_back(make_pair(s.column_int(0), s.column_double(1)));
+	}
+	if(!s.is_done())
+		return false;
+	s.finalize();
+
+	weights.clear();
+	if(values.empty())
+		return true;
+
+	sqlite3_int64 lo = values[0].first, hi = values[0].first;
+	vector<pair<sqlite3_int64, double> >::const_iterator iter;
+	for(iter = values.begin(); iter != values.end(); ++iter)
+	{
+		lo = std::min(lo, iter->first);
+		hi = std::max(hi, iter->first);
+	}
+
+	if(lo < INT_MIN || hi > INT_MAX || hi - lo >= max_range)
+	{
+		os << "[weight_table] Index range of table '" << table << "' too large!\n";
+		return false;
+	}
+
+	first = (int) lo;
+	weights.assign(hi - lo + 1, 0);
+	for(iter = values.begin(); iter != values.end(); ++iter)
+		weights[iter->first - lo] += iter->second;
+
+	return true;
+}
+
+
+void period_shares(const distribution &dist, int lo, int hi,
+		bool has_days, sqlite3_int64 start_day, sqlite3_int64 end_day, vector<double> &w)
+{
+	int i, n = hi - lo + 1;
+	double sum = 0;
+	w.assign(n, 0);
+
+	switch(dist.kernel)
+	{
+		case DIST_FIRST:
+			w[0] = 1;
+			return;
+
+		case DIST_LAST:
+			w[n - 1] = 1;
+			return;
+
+		case DIST_DAYS:
+			if(has_days && end_day >= start_day)
+			{
+				for(i = 0; i < n; ++i)
+				{
+					sqlite3_int64 first_day = std::max(start_day, (sqlite3_int64) (lo + i) * 7);
+					sqlite3_int64 last_day = std::min(end_day, (sqlite3_int64) (lo + i) * 7 + 6);
+					if(last_day >= first_day)
+					{
+						w[i] = (double) (last_day - first_day + 1);
+						sum += w[i];
+					}
+				}
+			}
+			break;
+
+		case DIST_WEIGHTS:
+			if(dist.weights)
+			{
+				for(i = 0; i < n; ++i)
+				{
+					w[i] = dist.weights->get(lo + i);
+					sum += w[i];
+				}
+			}
+			break;
+	}
+
+	if(sum > 0)
+	{
+		for(i = 0; i < n; ++i)
+			w[i] /= sum;
+	}
+	else
+	{
+		// Even distribution
+		for(i = 0; i < n; ++i)
+			w[i] = 1.0 / n;
+	}
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
+// out[j * n + i] = v[j] * w[i] (column major: contiguous per expanded column)
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
+static inline void outer_product_scalar(const double *v, unsigned m, const double *w, unsigned n, double *out)
+{
+	unsigned i, j;
+	for(j = 0; j < m; ++j)
+	{
+		double vj = v[j];
+		double *o = out + (size_t) j * n;
+		for(i = 0; i < n; ++i)
+			o[i] = vj * w[i];
+	}
+}
+
+#ifdef DISTRIBUTION_AVX2
+__attribute__((target("avx2")))
+static void outer_product_avx2(const double *v, unsigned m, const double *w, unsigned n, double *out)
+{
+	unsigned i, j;
+	for(j = 0; j < m; ++j)
+	{
+		__m256d vj = _mm256_set1_pd(v[j]);
+		double *o = out + (size_t) j * n;
+		for(i = 0; i + 4 <= n; i += 4)
+			_mm256_storeu_pd(o + i, _mm256_mul_pd(vj, _mm256_loadu_pd(w + i)));
+		for(; i < n; ++i)
+			o[i] = v[j] * w[i];
+	}
+}
+
+static bool has_avx2()
+{
+	static const bool avx2 = __builtin_cpu_supports("avx2");
+	return avx2;
+}
+#endif
+
+void outer_product(const double *v, unsigned m, const double *w, unsigned n, double *out)
+{
+#ifdef DISTRIBUTION_AVX2
+	if(has_avx2())
+	{
+		outer_product_avx2(v, m, w, n, out);
+		return;
+	}
+#endif
+	outer_product_scalar(v, m, w, n, out);
+}
+
+
+} // namespace sqlite
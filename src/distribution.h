@@ -0,0 +1,99 @@
+/*
+ * distribution.h
+ *
+ *  Created on: 17.10.2026
+ *      Author: kaisers
+ *
+ *  Distribution kernels for expanded columns:
+ *  For a source row with index range [lo, hi], a kernel calculates one
+ *  share per index value (shares sum up to 1). The values of all expanded
+ *  columns are multiplied with the shares at once (outer product into a
+ *  contiguous array), so expand_row only binds precalculated values.
+ *
+ *  DIST_EVEN		: 1 / (hi - lo + 1) for each index value (default)
+ *  DIST_DAYS		: Proportional to overlap of day range [start, end]
+ *  				  with the days of each index value (week w contains
+ *  				  days 7w .. 7w + 6)
+ *  DIST_WEIGHTS	: Proportional to weights from weight table
+ *  DIST_FIRST		: Complete value at lo
+ *  DIST_LAST		: Complete value at hi
+ *
+ *  When no share can be calculated (missing day values, zero weights),
+ *  values are evenly distributed.
+ */
+
+#ifndef DISTRIBUTION_H_
+#define DISTRIBUTION_H_
+
+#include "sqlite_con.h"
+#include "sqlite_stmt.h"
+
+#include <string>
+#include <sstream>
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <climits>
+
+using namespace std;
+
+namespace sqlite {
+
+enum dist_kernel { DIST_EVEN = 0, DIST_DAYS, DIST_WEIGHTS, DIST_FIRST, DIST_LAST };
+
+// Returns -1 for unknown name
+int dist_kernel_from_name(const string &name);
+
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
+// Weights per index value (dense array over index range).
+// Loaded from table with columns (index, weight).
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
+class weight_table {
+public:
+	weight_table() : first(0) {}
+
+	bool load(sqlite_con &con, const string &table);
+
+	double get(int index) const
+	{
+		if(index < first || index - first >= (int) weights.size())
+			return 0;
+		return weights[index - first];
+	}
+
+private:
+	int first;
+	vector<double> weights;
+};
+
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
+// Selected kernel (part of expand_spec)
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
+struct distribution
+{
+	distribution() : kernel(DIST_EVEN) {}
+
+	int kernel;
+	string start_day_col;		// DIST_DAYS
+	string end_day_col;
+	shared_ptr<const weight_table> weights;	// DIST_WEIGHTS (shared by workers)
+};
+
+
+// Shares for index values lo .. hi (w[i] for index lo + i).
+// start_day, end_day: Only used by DIST_DAYS (has_days = false: NULL values)
+void period_shares(const distribution &dist, int lo, int hi,
+		bool has_days, sqlite3_int64 start_day, sqlite3_int64 end_day, vector<double> &w);
+
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
+// out[j * n + i] = v[j] * w[i] (column major: contiguous per expanded column)
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
+// (AVX2 when supported by CPU)
+void outer_product(const double *v, unsigned m, const double *w, unsigned n, double *out);
+
+
+} // namespace sqlite
+#endif /* DISTRIBUTION_H_ */
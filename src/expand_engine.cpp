@@ -0,0 +1,146 @@
+/*
+ * expand_engine.cpp
+ *
+ *  Created on: 17.10.2026
+ *      Author: kaisers
+ */
+
+#include "expand_engine.h"
+
+#include <sstream>
+#include <algorithm>
+
+namespace sqlite {
+
+
+int engine_from_name(const string &name)
+{
+	if(name == "auto")		return ENGINE_AUTO;
+	if(name == "callback")	return ENGINE_CALLBACK;
+	if(name == "sql")		return ENGINE_SQL;
+	return -1;
+}
+
+const char * engine_name(int engine)
+{
+	switch(engine)
+	{
+		case ENGINE_AUTO:		return "auto";
+		case ENGINE_CALLBACK:	return "callback";
+		case ENGINE_SQL:		return "sql";
+	}
+	return "";
+}
+
+
+// SELECT COUNT(*), COUNT(_n), SUM(_n), MAX(_n) FROM
+// (SELECT CASE WHEN <valid> THEN <last> - <first> + 1 END AS _n FROM tbl [WHERE filter]);
+bool source_stats::load(sqlite_con &con, const expand_spec &spec)
+{
+	stringstream sql;
+	sql << "SELECT COUNT(*), COUNT(_n), COALESCE(SUM(_n), 0), COALESCE(MAX(_n), 0) FROM ";
+	sql << "(SELECT CASE WHEN " << spec.valid_sql() << " THEN "
+		<< spec.last_sql() << " - " << spec.first_sql() << " + 1 END AS _n";
+	sql << " FROM " << spec.read_table << " " << spec.where_sql() << ");";
+
+	sqlite_stmt stmt(con);
+	if(!stmt.prepare(sql.str()) || !stmt.fetch())
+		return false;
+
+	rows = (long) stmt.column_int(0);
+	valid_rows = (long) stmt.column_int(1);
+	expanded = stmt.column_int(2);
+	max_span = stmt.column_int(3);
+	mean_span = valid_rows ? (double) expanded / valid_rows : 0;
+	n_columns = spec.n_columns();
+	return stmt.finalize();
+}
+
+
+string sql_engine_restriction(const expand_spec &spec)
+{
+	if(sqlite3_libversion_number() < 3025000)
+		return string("SQLite ") + sqlite3_libversion() + " has no window functions (3.25.0)";
+
+	if(spec.dist.kernel != DIST_EVEN && spec.dist.kernel != DIST_FIRST && spec.dist.kernel != DIST_LAST)
+		return "distribution is not available in SQL";
+
+	return string();
+}
+
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
+// Cost model (microseconds, fitted with tools/expand_bench):
+// callback	: Preparation of batch statement (per bound variable) and
+//			  per created row and column
+// sql		: Per visited offset (valid rows x max span) and per created
+//			  row and column
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
+static const double cost_cb_variable = 4.0;
+static const double cost_cb_row = 0.6;
+static const double cost_cb_column = 0.05;
+static const double cost_sql_offset = 0.05;
+static const double cost_sql_row = 0.44;
+static const double cost_sql_column = 0.08;
+
+bool plan_engine(sqlite_con &con, const expand_spec &spec, int engine,
+		unsigned int batch_size, expand_plan &plan)
+{
+	plan = expand_plan();
+	if(engine == ENGINE_CALLBACK)
+	{
+		plan.reason = "requested";
+		return true;
+	}
+
+	string restriction = sql_engine_restriction(spec);
+	if(restriction.size())
+	{
+		plan.reason = restriction;
+		return engine == ENGINE_AUTO;
+	}
+
+	if(!plan.stats.load(con, spec))
+	{
+		plan.reason = "Cannot read statistics of table '" + spec.read_table + "'!";
+		return false;
+	}
+
+	const source_stats &st = plan.stats;
+	stringstream reason;
+	reason << "rows=" << st.valid_rows << ", mean span=" << st.mean_span
+		<< ", max span=" << st.max_span << ", columns=" << st.n_columns << ": ";
+
+	if(engine == ENGINE_SQL)
+	{
+		plan.engine = ENGINE_SQL;
+		reason << "requested";
+		plan.reason = reason.str();
+		return true;
+	}
+
+	if(st.valid_rows == 0)
+	{
+		reason << "no rows to expand";
+		plan.reason = reason.str();
+		return true;
+	}
+
+	// Variables of batch statement (see sqlite_batch_stmt::prepare)
+	double n_vars = con.get_limit(SQLITE_LIMIT_VARIABLE_NUMBER);
+	if(batch_size)
+		n_vars = std::min(n_vars, (double) batch_size * st.n_columns);
+
+	double cost_cb = n_vars * cost_cb_variable
+			+ st.expanded * (cost_cb_row + cost_cb_column * st.n_columns);
+	double cost_sql = (double) st.valid_rows * st.max_span * cost_sql_offset
+			+ st.expanded * (cost_sql_row + cost_sql_column * st.n_columns);
+
+	plan.engine = cost_sql < cost_cb ? ENGINE_SQL : ENGINE_CALLBACK;
+	reason << "estimated cost sql / callback = " << cost_sql / cost_cb;
+	plan.reason = reason.str();
+	return true;
+}
+
+
+} // namespace sqlite
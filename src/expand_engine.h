@@ -0,0 +1,88 @@
+/*
+ * expand_engine.h
+ *
+ *  Created on: 17.10.2026
+ *      Author: kaisers
+ *
+ *  Execution engines of expand_table (write table output):
+ *
+ *  ENGINE_CALLBACK	: Source rows are expanded in C++ (expand_row) and
+ *  				  written through sqlite_batch_stmt (values cross the
+ *  				  C++/SQLite boundary once per expanded row).
+ *  ENGINE_SQL		: One INSERT INTO ... SELECT statement with a recursive
+ *  				  CTE (see expand_spec::expand_sql). Rows are created
+ *  				  inside the VDBE without calls into C++.
+ *
+ *  The sql engine joins each source row with the offsets 0 .. max_span - 1
+ *  of a recursive CTE (no index, all offsets are visited), so its cost
+ *  grows with rows x max span. The callback engine has a fixed cost for
+ *  preparing the batch statement and a lower cost per created column.
+ *  plan_engine chooses the engine from statistics of the read table:
+ *  sql for small and medium tables with even spans, callback for large
+ *  or wide tables and for spans with max span >> mean span.
+ *
+ *  The sql engine requires window functions (SQLite >= 3.25.0) and
+ *  supports the distributions "even", "first" and "last".
+ */
+
+#ifndef EXPAND_ENGINE_H_
+#define EXPAND_ENGINE_H_
+
+#include "sqlite_con.h"
+#include "expander.h"
+
+#include <string>
+#include <ostream>
+
+using namespace std;
+
+namespace sqlite {
+
+enum expand_engine { ENGINE_AUTO = 0, ENGINE_CALLBACK, ENGINE_SQL };
+
+// Returns -1 for unknown name
+int engine_from_name(const string &name);
+const char * engine_name(int engine);
+
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
+// Statistics of read table (one scan, filter of spec applied)
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
+struct source_stats
+{
+	source_stats() : rows(0), valid_rows(0), expanded(0), max_span(0), mean_span(0), n_columns(0) {}
+
+	bool load(sqlite_con &con, const expand_spec &spec);
+
+	long rows;					// Source rows (including skipped rows)
+	long valid_rows;			// Source rows which are expanded
+	sqlite3_int64 expanded;		// Created rows
+	sqlite3_int64 max_span;		// Created rows per valid source row
+	double mean_span;
+	unsigned int n_columns;		// Columns of write table
+};
+
+
+// Empty when spec can be expanded by the sql engine
+string sql_engine_restriction(const expand_spec &spec);
+
+
+struct expand_plan
+{
+	expand_plan() : engine(ENGINE_CALLBACK) {}
+
+	int engine;					// ENGINE_CALLBACK or ENGINE_SQL
+	string reason;
+	source_stats stats;			// Loaded for ENGINE_AUTO and ENGINE_SQL
+};
+
+// engine: Requested engine (ENGINE_AUTO: chosen from statistics).
+// batch_size: Rows per INSERT statement of callback engine (0: default_batch_rows)
+// Returns false when statistics cannot be read or when the requested
+// sql engine is not available (plan.reason contains the message).
+bool plan_engine(sqlite_con &con, const expand_spec &spec, int engine,
+		unsigned int batch_size, expand_plan &plan);
+
+
+} // namespace sqlite
+#endif /* EXPAND_ENGINE_H_ */
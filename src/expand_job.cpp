@@ -0,0 +1,478 @@
+/*
+ * expand_job.cpp
+ *
+ *  Created on: 17.10.2026
+ *      Author: kaisers
+ */
+
+#include "expand_job.h"
+#include "pipeline.h"
+#include "column_file.h"
+
+#include <sstream>
+#include <thread>
+#include <memory>
+#include <algorithm>
+#include <climits>
+
+namespace sqlite {
+
+
+// locking_mode=EXCLUSIVE blocks other connections (workers and readers)
+static bool has_exclusive_locking(const sqlite_con::pragma_list &pragmas)
+{
+	sqlite_con::pragma_list::const_iterator iter;
+	for(iter = pragmas.begin(); iter != pragmas.end(); ++iter)
+	{
+		if(sqlite3_stricmp(iter->first.c_str(), "locking_mode") == 0
+				&& sqlite3_stricmp(iter->second.c_str(), "EXCLUSIVE") == 0)
+			return true;
+	}
+	return false;
+}
+
+
+bool expand_job::check(const expand_spec &spec, expand_options &opt, string &error_msg)
+{
+	stringstream msg;
+
+	if(opt.batch_size < 0)
+		msg << "batchSize must be >= 0!";
+	else if(opt.n_threads < 0)
+		msg << "threads must be >= 0!";
+	else if(spec.window_lo > 0 || spec.window_hi < 0)
+		msg << "window must be >= 0!";
+	else if(spec.rel_index && spec.ref_col.empty())
+		msg << "relIndex requires refCol!";
+	else if(spec.dist.kernel == DIST_DAYS && (spec.dist.start_day_col.empty() || spec.dist.end_day_col.empty()))
+		msg << "distribution 'days' requires dayCols (start and end day)!";
+	else if(spec.dist.kernel == DIST_WEIGHTS && opt.weight_table.empty())
+		msg << "distribution 'weights' requires weightTable!";
+	else if(opt.commit_rows < 0)
+		msg << "commitRows must be >= 0!";
+	else if(opt.engine < 0)
+		msg << "engine must be 'auto', 'callback' or 'sql'!";
+	else if(opt.engine == ENGINE_SQL && sql_engine_restriction(spec).size())
+		msg << "engine='sql' is not available: " << sql_engine_restriction(spec) << "!";
+
+	if(msg.str().size())
+	{
+		error_msg = msg.str();
+		return false;
+	}
+
+	if(opt.n_threads == 0)
+		opt.n_threads = std::max(1u, thread::hardware_concurrency());
+
+	const string &output = opt.output;
+	if(opt.commit_rows && (opt.n_threads > 1 || opt.pipeline))
+		msg << "commitRows requires serial expansion (threads=1, pipeline=FALSE)!";
+	else if(output != "table" && output != "frame" && output != "binary" && output != "csv")
+		msg << "output must be 'table', 'frame', 'binary' or 'csv'!";
+	else if(output != "table" && (opt.n_threads > 1 || opt.pipeline || opt.incremental || opt.commit_rows))
+		msg << "output='" << output << "' requires serial expansion without incremental or commitRows!";
+	else if((output == "binary" || output == "csv") && opt.file.empty())
+		msg << "output='" << output << "' requires option 'file'!";
+	else if(opt.engine == ENGINE_SQL && (output != "table" || opt.n_threads > 1 || opt.pipeline || opt.commit_rows))
+		msg << "engine='sql' requires output='table' and serial expansion (threads=1, pipeline=FALSE, commitRows=0)!";
+	else if(has_exclusive_locking(opt.pragmas) && (opt.n_threads > 1 || (opt.pipeline && opt.source_db.empty())))
+		msg << "locking_mode=EXCLUSIVE requires serial expansion (or pipeline with sourceDb)!";
+
+	error_msg = msg.str();
+	return error_msg.empty();
+}
+
+
+bool expand_job::prepare()
+{
+	if(spec.dist.kernel == DIST_WEIGHTS)
+	{
+		shared_ptr<weight_table> weights(new weight_table());
+		if(!weights->load(con, opt.weight_table))
+			return fail("[expand_table] Cannot read weight table '" + opt.weight_table + "'!");
+		spec.dist.weights = weights;
+	}
+
+	if(!con.apply_pragmas(opt.pragmas))
+		return fail("[expand_table] Cannot apply PRAGMA profile!");
+
+	return true;
+}
+
+
+bool expand_job::run()
+{
+	ostream &os = con.getos();
+
+	if(opt.output != "table" && opt.output != "binary" && opt.output != "csv")
+		return fail("[expand_table] output='" + opt.output + "' is not supported here!");
+
+	if(stats)
+		stats->start(con);
+
+	// No output table: Rows are written into file
+	if(opt.output == "binary" || opt.output == "csv")
+	{
+		n_source = expand_to_file(con, spec, opt.output, opt.file, stats);
+		if(n_source < 0)
+			return fail("[expand_table] Expansion of table '" + spec.read_table + "' into file '" + opt.file + "' failed!");
+
+		if(opt.verbose)
+			os << "[expand_table] Expanded " << n_source << " rows into file '" << opt.file << "'.\n";
+	}
+	else
+	{
+		if(!run_table())
+			return false;
+
+		if(stats)
+			stats->lap(PHASE_COMMIT);
+
+		if(!create_output_indexes())
+			return false;
+
+		if(stats)
+			stats->lap(PHASE_INDEX);
+	}
+
+	if(stats)
+	{
+		stats->finish(con);
+		stats->source_rows = n_source;
+		stats->expanded_rows = n_expanded;
+		if(opt.verbose)
+			stats->print(os);
+	}
+	return true;
+}
+
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
+// Drop and create target table
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
+bool expand_job::create_output_table()
+{
+	ostream &os = con.getos();
+
+	if(!con.drop_table(spec.write_table))
+		return fail("Drop table error!");
+
+	if(opt.verbose)
+		os << "[expand_table] Drop table success.\n";
+
+	string sql = spec.create_sql(spec.write_table);
+	if(opt.verbose)
+		os << "[expand_table] SQL: '" << sql << "'\n";
+
+	if(!con.create_table(sql))
+		return fail("[expand_table] Create table error!");
+
+	if(opt.verbose)
+		os << "[expand_table] Create table success.\n";
+	return true;
+}
+
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
+// Secondary indexes are created after loading, so that only one B-tree
+// is maintained while rows are inserted.
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
+bool expand_job::create_output_indexes()
+{
+	vector<string>::const_iterator iter;
+	for(iter = opt.index_cols.begin(); iter != opt.index_cols.end(); ++iter)
+	{
+		string index_name = spec.write_table + "_" + *iter + "_idx";
+		if(!con.create_index(index_name, spec.write_table, iter->c_str()))
+			return fail("[expand_table] Cannot create index on column '" + *iter + "'!");
+	}
+
+	if(opt.analyze)
+	{
+		if(opt.verbose)
+			con.getos() << "[expand_table] Analyze table '" << spec.write_table << "'.\n";
+
+		if(!con.exec("ANALYZE " + spec.write_table + ";"))
+			return fail("[expand_table] ANALYZE error!");
+	}
+	return true;
+}
+
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
+// Prepare INSERT statement
+// Value tuples (one per row) are appended by sqlite_batch_stmt:
+// VALUES (?, ?, ?, ...), (?, ?, ?, ...), ...
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
+bool expand_job::prepare_insert_statement(sqlite_batch_stmt &stmt)
+{
+	string sql = spec.insert_sql(spec.write_table);
+
+	if(!stmt.prepare(sql, spec.n_columns(), opt.batch_size))
+		return fail("[expand_table] Prepare statement error!");
+
+	if(opt.verbose)
+		con.getos() << "[expand_table] SQL: '" << sql << "(?, ?, ?, ...)' x " << stmt.batch_size() << " rows\n";
+	return true;
+}
+
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
+// Engine for serial expansion into table (see expand_engine.h).
+// Threads, pipeline and chunked expansion use the callback engine.
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
+bool expand_job::choose_engine(expand_plan &plan)
+{
+	if(opt.engine != ENGINE_CALLBACK && (opt.n_threads > 1 || opt.pipeline || opt.commit_rows))
+		plan.reason = "threads, pipeline and commitRows require callback";
+	else if(!plan_engine(con, spec, opt.engine, opt.batch_size, plan))
+		return fail("[expand_table] Engine: " + plan.reason);
+
+	if(opt.verbose)
+		con.getos() << "[expand_table] Engine: " << engine_name(plan.engine) << " (" << plan.reason << ").\n";
+	return true;
+}
+
+
+bool expand_job::run_table()
+{
+	ostream &os = con.getos();
+
+	// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
+	// Incremental expansion: Only source rows between recorded watermark
+	// and current maximal rowid of read table are expanded.
+	// Rows which are added to the read table meanwhile are left for next run.
+	// Chunked expansion: An incomplete watermark (checkpoint) is resumed.
+	// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
+	expand_watermark wm;
+	sqlite3_int64 high_mark = 0;
+	unsigned long first_id = 0;
+	bool append = false;
+
+	if(opt.incremental || opt.commit_rows)
+	{
+		if(!create_expand_meta(con) || !get_watermark(con, spec, wm))
+			return fail("[expand_table] Cannot read watermark from table '" + string(expand_meta_table) + "'!");
+
+		bool success;
+		if(opt.pipeline && opt.source_db.size())
+		{
+			sqlite_con src(opt.source_db, os, opt.verbose);
+			success = src.open() && get_max_rowid(src, spec.read_table, high_mark);
+			src.close();
+		}
+		else
+			success = get_max_rowid(con, spec.read_table, high_mark);
+
+		if(!success)
+			return fail("[expand_table] Cannot read maximal rowid of table '" + spec.read_table + "'!");
+
+		append = wm.found && (opt.incremental || !wm.complete);
+		if(!append)
+		{
+			wm = expand_watermark();
+			wm.rowid = LLONG_MIN;
+		}
+
+		stringstream filter;
+		if(append)
+			filter << "rowid > " << wm.rowid << " AND ";
+		filter << "rowid <= " << high_mark;
+		spec.filter = filter.str();
+	}
+
+	if(append)
+	{
+		// Checkpoint and write table are committed together
+		first_id = wm.complete ? con.get_max_id_val(spec.write_table) : wm.last_id;
+		wm.last_id = first_id;
+		if(opt.verbose)
+			os << "[expand_table] " << (wm.complete ? "Appending rows" : "Resuming")
+				<< " after watermark " << wm.rowid << " (last id: " << first_id << ").\n";
+	}
+	else if(!create_output_table())
+		return false;
+
+	expand_plan plan;
+	if(!choose_engine(plan))
+		return false;
+
+	if(plan.engine == ENGINE_SQL)
+		return run_sql(plan, high_mark, first_id);
+
+	// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
+	// Execute query and expand algorithm
+	// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
+	// See also:
+	// http://stackoverflow.com/questions/1711631/improve-insert-per-second-performance-of-sqlite
+
+	if(opt.n_threads > 1)
+	{
+		// Workers read the database file through separate connections
+		if(stats)
+			stats->lap(PHASE_PREPARE);
+
+		// Watermark is written in the merge transaction
+		expand_watermark end_wm;
+		end_wm.rowid = high_mark;
+		if(!parallel_expand(con, spec, opt.n_threads, opt.batch_size, opt.verbose, first_id,
+				opt.incremental ? &end_wm : 0))
+			return fail("[expand_table] Parallel expansion of table '" + spec.read_table + "' failed!");
+
+		if(stats)
+			stats->lap(PHASE_EXPAND);
+
+		n_expanded = con.get_max_id_val(spec.write_table) - first_id;
+		if(stats)
+			n_source = con.get_count_value("SELECT COUNT(*) FROM " + spec.read_table + " " + spec.where_sql() + ";");
+		return true;
+	}
+
+	sqlite_batch_stmt stmt(con);
+	if(!prepare_insert_statement(stmt))
+		return false;
+	stmt.setAutoId(first_id);
+	stmt.set_stats(stats);
+
+	// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
+	// Create SELECT query
+	// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
+	string sql = spec.select_sql(spec.where_sql());
+	if(opt.verbose)
+		os << "[expand_table] SQL: '" << sql << "'\n";
+
+	long nRows;
+	if(opt.pipeline)
+	{
+		// Reader connection must not be blocked by writer
+		string source_db = opt.source_db;
+		if(source_db.empty())
+		{
+			source_db = con.get_db_name();
+			if(!con.set_con_journal(sqlite_con::JRNL_WAL))
+				return fail("[expand_table] Cannot set WAL journal mode for pipeline!");
+		}
+
+		if(opt.verbose)
+			os << "[expand_table] Pipeline: reading from '" << source_db << "'.\n";
+
+		expand_pipeline pl(spec, source_db, opt.verbose);
+		con.begin();
+		if(stats)
+			stats->lap(PHASE_PREPARE);
+		nRows = pl.run(stmt);
+		if(nRows >= 0 && opt.incremental && !set_watermark(con, spec, high_mark, stmt.lastAutoId()))
+			nRows = -1;
+
+		// Watermark must not be behind appended rows
+		if(nRows >= 0)
+			con.commit();
+		else
+			con.rollback();
+	}
+	else
+	{
+		// Source rows are read through a typed cursor: Numeric values
+		// are passed as they are (no conversion into text and back).
+		if(opt.commit_rows)
+		{
+			if(stats)
+				stats->lap(PHASE_PREPARE);
+			nRows = expand_chunked(stmt, spec, wm, high_mark, opt.commit_rows, opt.verbose);
+		}
+		else
+		{
+			sqlite_stmt read_stmt(con);
+			if(!read_stmt.prepare(sql))
+				return fail("[expand_table] Prepare SELECT statement error!");
+
+			con.begin();
+			if(stats)
+				stats->lap(PHASE_PREPARE);
+			nRows = expand_rows(read_stmt, stmt, spec, stats);
+			if(nRows >= 0 && opt.incremental && !set_watermark(con, spec, high_mark, stmt.lastAutoId()))
+				nRows = -1;
+
+			// Watermark must not be behind appended rows
+			if(nRows >= 0)
+				con.commit();
+			else
+				con.rollback();
+
+			if(stats)
+				stats->read.add(read_stmt);
+			read_stmt.finalize();
+		}
+	}
+	stmt.finalize();
+
+	if(stats)
+	{
+		stats->steps = stmt.steps();
+		stats->bytes_bound = stmt.bytes_bound();
+	}
+
+	if(nRows < 0)
+		return fail("[expand_table] Expansion of table '" + spec.read_table + "' failed!");
+
+	n_source = nRows;
+	n_expanded = stmt.lastAutoId() - first_id;
+
+	if(opt.verbose)
+		os << "[expand_table] Expanded " << nRows << " rows into " << n_expanded
+			<< " rows (" << stmt.steps() << " INSERT steps).\n";
+	return true;
+}
+
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
+// Expansion inside SQLite: One INSERT INTO ... SELECT statement
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
+bool expand_job::run_sql(const expand_plan &plan, sqlite3_int64 high_mark, unsigned long first_id)
+{
+	ostream &os = con.getos();
+
+	string sql = spec.expand_sql(spec.write_table, plan.stats.max_span, first_id);
+	if(opt.verbose)
+		os << "[expand_table] SQL: '" << sql << "'\n";
+
+	sqlite_stmt stmt(con);
+	if(!stmt.prepare(sql))
+		return fail("[expand_table] Prepare INSERT ... SELECT statement error!");
+
+	con.begin();
+	if(stats)
+		stats->lap(PHASE_PREPARE);
+
+	bool success = stmt.step();
+	if(stats)
+		stats->lap(PHASE_STEP);
+
+	n_expanded = plan.stats.expanded;
+	if(success && opt.incremental && !set_watermark(con, spec, high_mark, first_id + n_expanded))
+		success = false;
+
+	// Watermark must not be behind appended rows
+	if(success)
+		con.commit();
+	else
+		con.rollback();
+
+	if(stats)
+	{
+		stats->insert.add(stmt);
+		stats->steps = 1;
+	}
+	stmt.finalize();
+
+	if(!success)
+		return fail("[expand_table] Expansion of table '" + spec.read_table + "' failed!");
+
+	n_source = plan.stats.rows;
+	if(opt.verbose)
+		os << "[expand_table] Expanded " << n_source << " rows into " << n_expanded << " rows (in SQLite).\n";
+	return true;
+}
+
+
+} // namespace sqlite
@@ -0,0 +1,111 @@
+/*
+ * expand_job.h
+ *
+ *  Created on: 17.10.2026
+ *      Author: kaisers
+ *
+ *  Complete expansion of a read table (R independent part of the
+ *  expand_table interface, also used by the command line tool):
+ *  Options are checked, weights and PRAGMAs are applied, and rows
+ *  are written into the write table or into a flat file.
+ *
+ *  Functions return false on error. Then last_error() contains the message
+ *  and the caller is responsible for closing the connection.
+ *  Messages are written to the ostream of the connection.
+ */
+
+#ifndef EXPAND_JOB_H_
+#define EXPAND_JOB_H_
+
+#include "sqlite_con.h"
+#include "expander.h"
+#include "expand_stats.h"
+#include "expand_engine.h"
+
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace sqlite {
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
+// Options (see expandTable in R for documentation).
+// Options on columns (refCol, window, distribution, ...) are part of
+// expand_spec.
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
+struct expand_options
+{
+	expand_options() : batch_size(0), n_threads(1), pipeline(false), incremental(false),
+			commit_rows(0), analyze(false), output("table"), engine(ENGINE_AUTO),
+			instrument(false), verbose(false) {}
+
+	int batch_size;				// Rows per INSERT statement (0: default_batch_rows)
+	int n_threads;				// 0: Number of cores
+	bool pipeline;
+	string source_db;			// Pipeline only (empty: database of connection)
+	bool incremental;
+	int commit_rows;
+	vector<string> index_cols;
+	bool analyze;
+	string output;				// "table", "frame", "binary" or "csv"
+	string file;				// "binary" and "csv"
+	string weight_table;		// distribution = "weights"
+	int engine;					// Table output (see expand_engine.h)
+	sqlite_con::pragma_list pragmas;
+	bool instrument;			// Collect expand_stats (see get_stats())
+	bool verbose;
+};
+
+
+class expand_job {
+public:
+	expand_job(sqlite_con &c, expand_spec &s, const expand_options &o) :
+		con(c), spec(s), opt(o), n_source(0), n_expanded(0),
+		stats(o.instrument ? &job_stats : 0) {}
+
+	// Checks combination of options (before connection is opened).
+	// Sets n_threads = 0 to number of cores.
+	static bool check(const expand_spec &spec, expand_options &opt, string &error_msg);
+
+	// Loads weight table and applies PRAGMAs (restored when
+	// connection is closed)
+	bool prepare();
+
+	// Expansion into table or file (output "frame" is not supported)
+	bool run();
+
+	const string & last_error() const { return err; }
+	long source_rows() const { return n_source; }
+	unsigned long expanded_rows() const { return n_expanded; }
+
+	// Valid after run() when option instrument is set
+	const expand_stats & get_stats() const { return job_stats; }
+
+private:
+	expand_job(const expand_job &rhs);
+
+	bool fail(const string &msg) { err = msg; return false; }
+
+	bool create_output_table();
+	bool create_output_indexes();
+	bool prepare_insert_statement(sqlite_batch_stmt &stmt);
+	bool choose_engine(expand_plan &plan);
+	bool run_table();
+	bool run_sql(const expand_plan &plan, sqlite3_int64 high_mark, unsigned long first_id);
+
+	sqlite_con &con;
+	expand_spec &spec;
+	const expand_options &opt;
+
+	long n_source;
+	unsigned long n_expanded;
+	string err;
+
+	expand_stats job_stats;
+	expand_stats *stats;		// 0: Instrumentation disabled
+};
+
+
+} // namespace sqlite
+#endif /* EXPAND_JOB_H_ */
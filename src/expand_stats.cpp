@@ -0,0 +1,119 @@
+/*
+ * expand_stats.cpp
+ *
+ *  Created on: 17.10.2026
+ *      Author: kaisers
+ */
+
+#include "expand_stats.h"
+
+namespace sqlite {
+
+
+// Counters of older SQLite versions are reported as 0
+#ifndef SQLITE_STMTSTATUS_VM_STEP
+#define SQLITE_STMTSTATUS_VM_STEP -1
+#endif
+
+#ifndef SQLITE_DBSTATUS_CACHE_SPILL
+#define SQLITE_DBSTATUS_CACHE_SPILL -1
+#endif
+
+void stmt_counters::add(const sqlite_stmt &stmt)
+{
+	if(SQLITE_STMTSTATUS_VM_STEP >= 0)
+		vm_steps += stmt.status(SQLITE_STMTSTATUS_VM_STEP);
+	sorts += stmt.status(SQLITE_STMTSTATUS_SORT);
+	fullscan_steps += stmt.status(SQLITE_STMTSTATUS_FULLSCAN_STEP);
+	autoindex += stmt.status(SQLITE_STMTSTATUS_AUTOINDEX);
+}
+
+
+expand_stats::expand_stats() : total(0), source_rows(0), expanded_rows(0),
+		steps(0), bytes_bound(0), cache_hit(0), cache_miss(0), cache_write(0), cache_spill(0)
+{
+	int i;
+	for(i = 0; i < N_EXPAND_PHASES; ++i)
+		phase_time[i] = 0;
+	t_start = last = clock::now();
+}
+
+// hit, miss, write, spill
+bool expand_stats::get_cache_counters(sqlite_con &con, sqlite3_int64 *values)
+{
+	static const int ops[] = { SQLITE_DBSTATUS_CACHE_HIT, SQLITE_DBSTATUS_CACHE_MISS,
+			SQLITE_DBSTATUS_CACHE_WRITE, SQLITE_DBSTATUS_CACHE_SPILL };
+
+	int i, value;
+	for(i = 0; i < 4; ++i)
+	{
+		value = 0;
+		if(ops[i] >= 0 && !con.get_db_status(ops[i], value))
+			return false;
+		values[i] = value;
+	}
+	return true;
+}
+
+void expand_stats::start(sqlite_con &con)
+{
+	sqlite3_int64 values[4];
+	if(get_cache_counters(con, values))
+	{
+		cache_hit = -values[0];
+		cache_miss = -values[1];
+		cache_write = -values[2];
+		cache_spill = -values[3];
+	}
+	t_start = last = clock::now();
+}
+
+void expand_stats::finish(sqlite_con &con)
+{
+	total = chrono::duration<double>(clock::now() - t_start).count();
+
+	sqlite3_int64 values[4];
+	if(get_cache_counters(con, values))
+	{
+		cache_hit += values[0];
+		cache_miss += values[1];
+		cache_write += values[2];
+		cache_spill += values[3];
+	}
+	else
+		cache_hit = cache_miss = cache_write = cache_spill = 0;
+}
+
+const char * expand_stats::phase_name(int phase)
+{
+	static const char * const names[N_EXPAND_PHASES] =
+		{ "prepare", "scan", "expand", "bind", "step", "commit", "index" };
+
+	if(phase < 0 || phase >= N_EXPAND_PHASES)
+		return "";
+	return names[phase];
+}
+
+void expand_stats::print(ostream &os) const
+{
+	int i;
+	os << "[expand_stats] Time (s):";
+	for(i = 0; i < N_EXPAND_PHASES; ++i)
+		os << " " << phase_name(i) << "=" << phase_time[i];
+	os << " total=" << total << "\n";
+
+	os << "[expand_stats] Rows: source=" << source_rows << " expanded=" << expanded_rows
+		<< " steps=" << steps << " bytes_bound=" << bytes_bound << "\n";
+
+	os << "[expand_stats] SELECT: vm_steps=" << read.vm_steps << " sorts=" << read.sorts
+		<< " fullscan_steps=" << read.fullscan_steps << " autoindex=" << read.autoindex << "\n";
+
+	os << "[expand_stats] INSERT: vm_steps=" << insert.vm_steps << " sorts=" << insert.sorts
+		<< " fullscan_steps=" << insert.fullscan_steps << " autoindex=" << insert.autoindex << "\n";
+
+	os << "[expand_stats] Cache: hit=" << cache_hit << " miss=" << cache_miss
+		<< " write=" << cache_write << " spill=" << cache_spill << "\n";
+}
+
+
+} // namespace sqlite
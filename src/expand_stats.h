@@ -0,0 +1,107 @@
+/*
+ * expand_stats.h
+ *
+ *  Created on: 17.10.2026
+ *      Author: kaisers
+ *
+ *  Optional instrumentation of expand_table:
+ *  Time per phase (monotonic clock), row and byte counters, counters of
+ *  prepared statements (sqlite3_stmt_status) and page cache counters of
+ *  the connection (sqlite3_db_status).
+ *
+ *  Instrumented code receives a pointer to expand_stats which is 0 when
+ *  instrumentation is disabled (one branch per row or batch).
+ *  lap(phase) adds the time since the previous lap to phase. Nested
+ *  code (e.g. the INSERT of a full batch inside expansion of a row)
+ *  thereby takes its share out of the enclosing phase.
+ */
+
+#ifndef EXPAND_STATS_H_
+#define EXPAND_STATS_H_
+
+#include "sqlite_stmt.h"
+#include <chrono>
+#include <ostream>
+
+using namespace std;
+
+namespace sqlite {
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
+// prepare	: Create write table, prepare statements
+// scan		: Step of SELECT statement on read table (pipeline: waiting
+//			  for decoded rows of reader thread)
+// expand	: Distribution of values and copy of cells into batch
+//			  (threads: complete parallel expansion and merge)
+// bind		: Binding of batch values to INSERT statement
+// step		: Execution of INSERT statement
+// commit	: COMMIT (chunked: all intermediate commits)
+// index	: Creation of indexes and ANALYZE
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
+enum expand_phase { PHASE_PREPARE, PHASE_SCAN, PHASE_EXPAND, PHASE_BIND,
+	PHASE_STEP, PHASE_COMMIT, PHASE_INDEX, N_EXPAND_PHASES };
+
+
+// Summed sqlite3_stmt_status counters of finalized statements
+struct stmt_counters
+{
+	stmt_counters() : vm_steps(0), sorts(0), fullscan_steps(0), autoindex(0) {}
+
+	void add(const sqlite_stmt &stmt);
+
+	sqlite3_int64 vm_steps;
+	sqlite3_int64 sorts;
+	sqlite3_int64 fullscan_steps;
+	sqlite3_int64 autoindex;
+};
+
+
+struct expand_stats
+{
+	expand_stats();
+
+	// Records page cache counters and starts the clock
+	void start(sqlite_con &con);
+
+	// Total time and page cache counters since start
+	void finish(sqlite_con &con);
+
+	void lap(int phase)
+	{
+		clock::time_point now = clock::now();
+		phase_time[phase] += chrono::duration<double>(now - last).count();
+		last = now;
+	}
+
+	static const char * phase_name(int phase);
+	void print(ostream &os) const;
+
+	double phase_time[N_EXPAND_PHASES];		// Seconds
+	double total;
+
+	sqlite3_int64 source_rows;
+	sqlite3_int64 expanded_rows;
+	sqlite3_int64 steps;					// Executed INSERT statements
+	sqlite3_int64 bytes_bound;				// Bound INSERT values
+
+	stmt_counters read;						// SELECT on read table
+	stmt_counters insert;					// INSERT into write table
+
+	// Connection of write table (threads: without workers)
+	sqlite3_int64 cache_hit;
+	sqlite3_int64 cache_miss;
+	sqlite3_int64 cache_write;
+	sqlite3_int64 cache_spill;
+
+private:
+	typedef chrono::steady_clock clock;
+
+	bool get_cache_counters(sqlite_con &con, sqlite3_int64 *values);
+
+	clock::time_point t_start;
+	clock::time_point last;
+};
+
+
+} // namespace sqlite
+#endif /* EXPAND_STATS_H_ */
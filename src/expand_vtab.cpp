@@ -0,0 +1,500 @@
+/*
+ * expand_vtab.cpp
+ *
+ *  Created on: 17.10.2026
+ *      Author: kaisers
+ */
+
+#include "expand_vtab.h"
+#include "expander.h"
+
+#include <cstring>
+#include <climits>
+#include <cmath>
+#include <algorithm>
+
+namespace sqlite {
+
+struct expand_vtab
+{
+	sqlite3_vtab base;		// Must be first member
+	sqlite3 *db;
+	expand_spec spec;
+	sqlite3_int64 n_source;	// Number of source rows (cost estimation)
+};
+
+struct expand_vtab_cursor
+{
+	sqlite3_vtab_cursor base;	// Must be first member
+	sqlite3_stmt *stmt;			// Scan of source table
+	bool eof;
+	sqlite3_int64 rowid;
+
+	// Bounds for index column (from constraints)
+	sqlite3_int64 idx_min;
+	sqlite3_int64 idx_max;
+
+	// Current source row
+	sqlite3_int64 index;
+	sqlite3_int64 index_end;
+	double n_expand;
+};
+
+
+// Column positions inside virtual table
+static const int VTAB_COL_RID = 0;
+static const int VTAB_COL_INDEX = 1;
+static const int VTAB_COL_COPY = 2;
+
+// Pushed down constraints (encoded as characters in idxStr)
+static const char VTAB_RID_EQ = 'a';
+static const char VTAB_RID_GE = 'b';
+static const char VTAB_RID_LE = 'c';
+static const char VTAB_IDX_EQ = 'd';
+static const char VTAB_IDX_GE = 'e';
+static const char VTAB_IDX_GT = 'f';
+static const char VTAB_IDX_LE = 'g';
+static const char VTAB_IDX_LT = 'h';
+
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
+// Argument parsing
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
+static string expand_vtab_trim(const char *arg)
+{
+	string s(arg);
+	size_t first = s.find_first_not_of(" \t\n'\"");
+	size_t last = s.find_last_not_of(" \t\n'\"");
+	if(first == string::npos)
+		return string();
+	return s.substr(first, last - first + 1);
+}
+
+static int expand_vtab_connect(sqlite3 *db, void *pAux, int argc, const char *const*argv,
+		sqlite3_vtab **ppVtab, char **pzErr)
+{
+	// argv[0]: module name, argv[1]: database name, argv[2]: table name
+	// argv[3..6]: read table, lower bound, upper bound, index column
+	if(argc < 7)
+	{
+		*pzErr = sqlite3_mprintf("expand: Arguments (read_table, lo_bound, hi_bound, index_column, "
+				"copy=col, ..., expand=col, ...) required");
+		return SQLITE_ERROR;
+	}
+
+	expand_vtab *vtab = new expand_vtab;
+	memset(&vtab->base, 0, sizeof(sqlite3_vtab));
+	vtab->db = db;
+	vtab->n_source = 0;
+
+	expand_spec &spec = vtab->spec;
+	spec.read_table = expand_vtab_trim(argv[3]);
+	spec.lo_bound_col = expand_vtab_trim(argv[4]);
+	spec.up_bound_col = expand_vtab_trim(argv[5]);
+	spec.index_column = expand_vtab_trim(argv[6]);
+	spec.write_table = expand_vtab_trim(argv[2]);
+
+	int i;
+	for(i = 7; i < argc; ++i)
+	{
+		string arg = expand_vtab_trim(argv[i]);
+		size_t eq = arg.find('=');
+		string key = expand_vtab_trim(arg.substr(0, eq).c_str());
+		string val = (eq == string::npos) ? string() : expand_vtab_trim(arg.substr(eq + 1).c_str());
+
+		if(key == "copy" && val.size())
+			spec.copyCols.push_back(val);
+		else if(key == "expand" && val.size())
+			spec.expandCols.push_back(val);
+		else
+		{
+			*pzErr = sqlite3_mprintf("expand: Invalid argument '%s'", argv[i]);
+			delete vtab;
+			return SQLITE_ERROR;
+		}
+	}
+
+	// - - - - - - - - - - - - - - - - - - - - - - - - - //
+	// Declared types of copied columns are taken from source table
+	// - - - - - - - - - - - - - - - - - - - - - - - - - //
+	stringstream sql;
+	sqlite3_stmt *stmt = 0;
+	list<string>::const_iterator iter;
+
+	sql << "PRAGMA table_info(" << spec.read_table << ");";
+	int rc = sqlite3_prepare_v2(db, sql.str().c_str(), -1, &stmt, 0);
+	for(iter = spec.copyCols.begin(); iter != spec.copyCols.end(); ++iter)
+	{
+		string type;
+		while(rc == SQLITE_OK && sqlite3_step(stmt) == SQLITE_ROW)
+		{
+			// cid, name, type, ...
+			if(*iter == (const char*) sqlite3_column_text(stmt, 1))
+			{
+				type = (const char*) sqlite3_column_text(stmt, 2);
+				break;
+			}
+		}
+		sqlite3_reset(stmt);
+		spec.copyColTypes.push_back(type);
+	}
+	sqlite3_finalize(stmt);
+
+	sql.str("");
+	sql << "CREATE TABLE x(rid INTEGER, " << spec.index_column << " INTEGER";
+	list<string>::const_iterator iter2 = spec.copyColTypes.begin();
+	for(iter = spec.copyCols.begin(); iter != spec.copyCols.end(); ++iter, ++iter2)
+		sql << ", " << *iter << " " << *iter2;
+	for(iter = spec.expandCols.begin(); iter != spec.expandCols.end(); ++iter)
+		sql << ", " << *iter << " REAL";
+	sql << ");";
+
+	rc = sqlite3_declare_vtab(db, sql.str().c_str());
+	if(rc != SQLITE_OK)
+	{
+		*pzErr = sqlite3_mprintf("expand: %s", sqlite3_errmsg(db));
+		delete vtab;
+		return rc;
+	}
+
+	// Size of source table (for cost estimation). Also checks column names.
+	sql.str("");
+	sql << "SELECT COUNT(*) FROM " << spec.read_table << ";";
+	rc = sqlite3_prepare_v2(db, sql.str().c_str(), -1, &stmt, 0);
+	if(rc == SQLITE_OK && sqlite3_step(stmt) == SQLITE_ROW)
+		vtab->n_source = sqlite3_column_int64(stmt, 0);
+	sqlite3_finalize(stmt);
+
+	rc = sqlite3_prepare_v2(db, spec.select_sql("LIMIT 0").c_str(), -1, &stmt, 0);
+	sqlite3_finalize(stmt);
+	if(rc != SQLITE_OK)
+	{
+		*pzErr = sqlite3_mprintf("expand: %s", sqlite3_errmsg(db));
+		delete vtab;
+		return rc;
+	}
+
+	*ppVtab = &vtab->base;
+	return SQLITE_OK;
+}
+
+static int expand_vtab_disconnect(sqlite3_vtab *pVtab)
+{
+	delete (expand_vtab*) pVtab;
+	return SQLITE_OK;
+}
+
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
+// Query planning
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
+static int expand_vtab_best_index(sqlite3_vtab *pVtab, sqlite3_index_info *info)
+{
+	expand_vtab *vtab = (expand_vtab*) pVtab;
+	string idx;
+	int i, argv_index = 0;
+	double cost = 10.0 * (vtab->n_source + 1);
+
+	for(i = 0; i < info->nConstraint; ++i)
+	{
+		const sqlite3_index_info::sqlite3_index_constraint &c = info->aConstraint[i];
+		if(!c.usable)
+			continue;
+
+		char code = 0;
+		if(c.iColumn == VTAB_COL_RID)
+		{
+			switch(c.op)
+			{
+				case SQLITE_INDEX_CONSTRAINT_EQ: code = VTAB_RID_EQ; cost /= 100; break;
+				case SQLITE_INDEX_CONSTRAINT_GT:
+				case SQLITE_INDEX_CONSTRAINT_GE: code = VTAB_RID_GE; cost /= 2; break;
+				case SQLITE_INDEX_CONSTRAINT_LT:
+				case SQLITE_INDEX_CONSTRAINT_LE: code = VTAB_RID_LE; cost /= 2; break;
+			}
+		}
+		else if(c.iColumn == VTAB_COL_INDEX)
+		{
+			switch(c.op)
+			{
+				case SQLITE_INDEX_CONSTRAINT_EQ: code = VTAB_IDX_EQ; cost /= 20; break;
+				case SQLITE_INDEX_CONSTRAINT_GT: code = VTAB_IDX_GT; cost /= 2; break;
+				case SQLITE_INDEX_CONSTRAINT_GE: code = VTAB_IDX_GE; cost /= 2; break;
+				case SQLITE_INDEX_CONSTRAINT_LT: code = VTAB_IDX_LT; cost /= 2; break;
+				case SQLITE_INDEX_CONSTRAINT_LE: code = VTAB_IDX_LE; cost /= 2; break;
+			}
+		}
+
+		if(code)
+		{
+			idx.push_back(code);
+			info->aConstraintUsage[i].argvIndex = ++argv_index;
+			// Constraints are re-checked by SQLite (values may be non-integer)
+			info->aConstraintUsage[i].omit = 0;
+		}
+	}
+
+	info->idxNum = argv_index;
+	info->idxStr = sqlite3_mprintf("%s", idx.c_str());
+	info->needToFreeIdxStr = 1;
+	info->estimatedCost = cost;
+	return SQLITE_OK;
+}
+
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
+// Cursor
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
+static int expand_vtab_open(sqlite3_vtab *pVtab, sqlite3_vtab_cursor **ppCursor)
+{
+	expand_vtab_cursor *cur = new expand_vtab_cursor;
+	memset(cur, 0, sizeof(expand_vtab_cursor));
+	cur->eof = true;
+	*ppCursor = &cur->base;
+	return SQLITE_OK;
+}
+
+static int expand_vtab_close(sqlite3_vtab_cursor *pCursor)
+{
+	expand_vtab_cursor *cur = (expand_vtab_cursor*) pCursor;
+	sqlite3_finalize(cur->stmt);
+	delete cur;
+	return SQLITE_OK;
+}
+
+// Moves to next source row which overlaps [idx_min, idx_max]
+static int expand_vtab_next_source(expand_vtab_cursor *cur)
+{
+	for(;;)
+	{
+		int rc = sqlite3_step(cur->stmt);
+		if(rc == SQLITE_DONE)
+		{
+			cur->eof = true;
+			return SQLITE_OK;
+		}
+		if(rc != SQLITE_ROW)
+			return rc;
+
+		// SELECT id, lo, hi, ...
+		if(sqlite3_column_type(cur->stmt, 1) == SQLITE_NULL || sqlite3_column_type(cur->stmt, 2) == SQLITE_NULL)
+			continue;
+
+		sqlite3_int64 lo = sqlite3_column_int64(cur->stmt, 1);
+		sqlite3_int64 hi = sqlite3_column_int64(cur->stmt, 2);
+		if(hi < lo)
+			continue;
+
+		cur->n_expand = (double) (hi - lo + 1);
+		cur->index = lo > cur->idx_min ? lo : cur->idx_min;
+		cur->index_end = hi < cur->idx_max ? hi : cur->idx_max;
+		if(cur->index <= cur->index_end)
+			return SQLITE_OK;
+	}
+}
+
+// Integers lo <= value <= hi (lowest and highest integer in range of a REAL
+// value, clamped to int64). Returns false for text and blob values.
+static bool integer_bounds(sqlite3_value *v, sqlite3_int64 &lo, sqlite3_int64 &hi)
+{
+	switch(sqlite3_value_numeric_type(v))
+	{
+		case SQLITE_INTEGER:
+			lo = hi = sqlite3_value_int64(v);
+			return true;
+
+		case SQLITE_FLOAT:
+		{
+			// 2^63 is exactly representable as double
+			const double limit = 9223372036854775808.0;
+			double d = sqlite3_value_double(v);
+			lo = (d >= limit) ? LLONG_MAX : (d < -limit) ? LLONG_MIN : (sqlite3_int64) ceil(d);
+			hi = (d >= limit) ? LLONG_MAX : (d < -limit) ? LLONG_MIN : (sqlite3_int64) floor(d);
+			return true;
+		}
+	}
+	return false;
+}
+
+static int expand_vtab_filter(sqlite3_vtab_cursor *pCursor, int idxNum, const char *idxStr,
+		int argc, sqlite3_value **argv)
+{
+	expand_vtab_cursor *cur = (expand_vtab_cursor*) pCursor;
+	expand_vtab *vtab = (expand_vtab*) pCursor->pVtab;
+	const expand_spec &spec = vtab->spec;
+
+	sqlite3_finalize(cur->stmt);
+	cur->stmt = 0;
+	cur->eof = false;
+	cur->rowid = 0;
+	cur->idx_min = LLONG_MIN;
+	cur->idx_max = LLONG_MAX;
+
+	// - - - - - - - - - - - - - - - - - - - - - - - - - //
+	// Translate constraints into WHERE clause of source scan
+	// - - - - - - - - - - - - - - - - - - - - - - - - - //
+	stringstream where;
+	const char *delim = "WHERE ";
+	int i;
+
+	for(i = 0; i < argc && idxStr && idxStr[i]; ++i)
+	{
+		sqlite3_value *v = argv[i];
+		if(sqlite3_value_type(v) == SQLITE_NULL)
+		{
+			// Comparison with NULL never matches
+			cur->eof = true;
+			return SQLITE_OK;
+		}
+
+		// Index bounds: Only numeric values are pushed down (text and
+		// blob values compare greater than all numbers, SQLite rechecks)
+		sqlite3_int64 lo = LLONG_MIN, hi = LLONG_MAX;
+		bool numeric = (idxStr[i] > VTAB_RID_LE) && integer_bounds(v, lo, hi);
+
+		switch(idxStr[i])
+		{
+			case VTAB_RID_EQ:
+				where << delim << "id = ?" << (i + 1);
+				break;
+			case VTAB_RID_GE:
+				where << delim << "id >= ?" << (i + 1);
+				break;
+			case VTAB_RID_LE:
+				where << delim << "id <= ?" << (i + 1);
+				break;
+			case VTAB_IDX_EQ:
+				if(numeric)
+				{
+					cur->idx_min = std::max(cur->idx_min, lo);
+					cur->idx_max = std::min(cur->idx_max, hi);
+				}
+				break;
+			case VTAB_IDX_GE:
+				if(numeric)
+					cur->idx_min = std::max(cur->idx_min, lo);
+				break;
+			case VTAB_IDX_GT:
+				if(numeric && hi == LLONG_MAX)
+					cur->eof = true;
+				else if(numeric)
+					cur->idx_min = std::max(cur->idx_min, hi + 1);
+				break;
+			case VTAB_IDX_LE:
+				if(numeric)
+					cur->idx_max = std::min(cur->idx_max, hi);
+				break;
+			case VTAB_IDX_LT:
+				if(numeric && lo == LLONG_MIN)
+					cur->eof = true;
+				else if(numeric)
+					cur->idx_max = std::min(cur->idx_max, lo - 1);
+				break;
+		}
+		if(cur->eof)
+			return SQLITE_OK;
+		if(idxStr[i] <= VTAB_RID_LE)
+			delim = " AND ";
+	}
+
+	// Only source rows which overlap index range
+	if(cur->idx_min != LLONG_MIN)
+	{
+		where << delim << spec.up_bound_col << " >= " << cur->idx_min;
+		delim = " AND ";
+	}
+	if(cur->idx_max != LLONG_MAX)
+		where << delim << spec.lo_bound_col << " <= " << cur->idx_max;
+
+	int rc = sqlite3_prepare_v2(vtab->db, spec.select_sql(where.str()).c_str(), -1, &cur->stmt, 0);
+	if(rc != SQLITE_OK)
+	{
+		sqlite3_free(pCursor->pVtab->zErrMsg);
+		pCursor->pVtab->zErrMsg = sqlite3_mprintf("expand: %s", sqlite3_errmsg(vtab->db));
+		return rc;
+	}
+
+	// Bind rid constraints (parameter numbers match argv positions)
+	for(i = 0; i < argc && idxStr && idxStr[i]; ++i)
+	{
+		if(idxStr[i] <= VTAB_RID_LE)
+			sqlite3_bind_value(cur->stmt, i + 1, argv[i]);
+	}
+
+	return expand_vtab_next_source(cur);
+}
+
+static int expand_vtab_next(sqlite3_vtab_cursor *pCursor)
+{
+	expand_vtab_cursor *cur = (expand_vtab_cursor*) pCursor;
+	++cur->rowid;
+	if(++cur->index <= cur->index_end)
+		return SQLITE_OK;
+	return expand_vtab_next_source(cur);
+}
+
+static int expand_vtab_eof(sqlite3_vtab_cursor *pCursor)
+{
+	return ((expand_vtab_cursor*) pCursor)->eof;
+}
+
+static int expand_vtab_column(sqlite3_vtab_cursor *pCursor, sqlite3_context *ctx, int col)
+{
+	expand_vtab_cursor *cur = (expand_vtab_cursor*) pCursor;
+	const expand_spec &spec = ((expand_vtab*) pCursor->pVtab)->spec;
+
+	if(col == VTAB_COL_RID)
+		sqlite3_result_value(ctx, sqlite3_column_value(cur->stmt, 0));
+	else if(col == VTAB_COL_INDEX)
+		sqlite3_result_int64(ctx, cur->index);
+	else if(col < (int) (VTAB_COL_COPY + spec.copyCols.size()))
+	{
+		// Select columns: id, lo, hi, copy..., expand...
+		sqlite3_result_value(ctx, sqlite3_column_value(cur->stmt, col + 1));
+	}
+	else
+	{
+		sqlite3_value *v = sqlite3_column_value(cur->stmt, col + 1);
+		if(sqlite3_value_type(v) == SQLITE_NULL)
+			sqlite3_result_null(ctx);
+		else
+			sqlite3_result_double(ctx, sqlite3_value_double(v) / cur->n_expand);
+	}
+	return SQLITE_OK;
+}
+
+static int expand_vtab_rowid(sqlite3_vtab_cursor *pCursor, sqlite3_int64 *pRowid)
+{
+	*pRowid = ((expand_vtab_cursor*) pCursor)->rowid;
+	return SQLITE_OK;
+}
+
+
+sqlite3_module expand_module = {
+	0,							// iVersion
+	expand_vtab_connect,		// xCreate
+	expand_vtab_connect,		// xConnect
+	expand_vtab_best_index,		// xBestIndex
+	expand_vtab_disconnect,		// xDisconnect
+	expand_vtab_disconnect,		// xDestroy
+	expand_vtab_open,			// xOpen
+	expand_vtab_close,			// xClose
+	expand_vtab_filter,			// xFilter
+	expand_vtab_next,			// xNext
+	expand_vtab_eof,			// xEof
+	expand_vtab_column,			// xColumn
+	expand_vtab_rowid,			// xRowid
+	0,							// xUpdate (read only)
+	0,							// xBegin
+	0,							// xSync
+	0,							// xCommit
+	0,							// xRollback
+	0,							// xFindFunction
+	0,							// xRename
+	0,							// xSavepoint
+	0,							// xRelease
+	0							// xRollbackTo
+};
+
+
+} // namespace sqlite
@@ -0,0 +1,33 @@
+/*
+ * expand_vtab.h
+ *
+ *  Created on: 17.10.2026
+ *      Author: kaisers
+ *
+ *  Virtual table module 'expand': Produces expanded rows lazily
+ *  (without materializing the write table):
+ *
+ *  CREATE VIRTUAL TABLE temp.rtbl USING expand(tbl, min_woche, max_woche, woche,
+ *  		copy=cpy1, copy=cpy2, expand=exp1, expand=exp2);
+ *  SELECT * FROM temp.rtbl WHERE woche BETWEEN 100 AND 120;
+ *
+ *  Columns: rid, <index column>, <copy columns>, <expand columns>
+ *
+ *  Constraints on the index column and on rid are pushed down into the
+ *  scan of the source table, so only overlapping source rows are read.
+ *  Expanded values are always calculated from the full span (hi-lo+1).
+ */
+
+#ifndef EXPAND_VTAB_H_
+#define EXPAND_VTAB_H_
+
+#include <sqlite3.h>
+
+namespace sqlite {
+
+// Registered by sqlite_con::create_module("expand", &expand_module)
+extern sqlite3_module expand_module;
+
+
+} // namespace sqlite
+#endif /* EXPAND_VTAB_H_ */
@@ -0,0 +1,715 @@
+/*
+ * expander.cpp
+ *
+ *  Created on: 17.10.2026
+ *      Author: kaisers
+ */
+
+#include "expander.h"
+
+#include <atomic>
+#include <chrono>
+
+#ifdef _WIN32
+#include <process.h>
+#define stage_pid _getpid
+#else
+#include <unistd.h>
+#define stage_pid getpid
+#endif
+
+namespace sqlite {
+
+
+// CREATE TABLE IF NOT EXISTS rtbl (id INTEGER, rid INTEGER, woche TEXT, cpy1 TEXT, exp1 REAL, PRIMARY KEY(id));
+// Bulk schema:
+// CREATE TABLE IF NOT EXISTS rtbl (id INTEGER PRIMARY KEY, rid INTEGER, woche INTEGER, cpy1 TEXT, exp1 REAL);
+string expand_spec::create_sql(const string &table) const
+{
+	stringstream sql;
+	list<string>::const_iterator iter1, iter2;
+	const char * delim = ", ";
+
+	sql << "CREATE TABLE IF NOT EXISTS "	<< table << " (";
+	if(bulk_schema)
+		sql << "id INTEGER PRIMARY KEY"		<< delim;
+	else
+		sql << "id INTEGER "				<< delim;
+	sql << "rid INTEGER"					<< delim;
+
+	// Index column (bulk schema: Index values are stored without
+	// conversion into text)
+	if(bulk_schema)
+		sql << index_column << " INTEGER"	<< delim;
+	else
+		sql << index_column << " TEXT"		<< delim;
+
+	// Names and types for columns which are copied
+	iter1 = copyCols.begin();
+	iter2 = copyColTypes.begin();
+
+	for(; iter1!=copyCols.end(); ++iter1, ++iter2)
+		sql << *iter1 << " " << *iter2 		<< delim;
+
+	// Names for columns which are expanded
+	for(iter1 = expandCols.begin(); iter1 != expandCols.end(); ++iter1)
+		sql << *iter1 << " REAL"			<< delim;
+
+	if(bulk_schema)
+	{
+		// Remove last delimiter
+		string res = sql.str();
+		return res.substr(0, res.size() - 2) + ");";
+	}
+
+	sql << "PRIMARY KEY(id));";
+	return sql.str();
+}
+
+// INSERT INTO rtbl (id, rid, woche, cpy1, exp1) VALUES
+// (Value tuples are appended by sqlite_batch_stmt)
+string expand_spec::insert_sql(const string &table) const
+{
+	stringstream sql;
+	list<string>::const_iterator iter;
+
+	sql << "INSERT INTO " << table << " (id, rid, " << index_column;
+
+	// Copied columns
+	for(iter = copyCols.begin(); iter != copyCols.end(); ++iter)
+		sql << ", " << *iter ;
+
+	// Expanded columns
+	for(iter = expandCols.begin(); iter != expandCols.end(); ++iter)
+		sql << ", " << *iter;
+
+	sql << ") VALUES ";
+	return sql.str();
+}
+
+// SELECT id, min_woche, max_woche, cpy1, exp1 [, woche_index] [, start_day, end_day] FROM tbl [WHERE ...];
+string expand_spec::select_sql(const string &where) const
+{
+	stringstream sql;
+	list<string>::const_iterator iter;
+
+	sql << "SELECT id, " << lo_bound_col << ", " << up_bound_col;
+
+	// Copied columns
+	for(iter = copyCols.begin(); iter != copyCols.end(); ++iter)
+		sql << ", " << *iter;
+
+	// Expanded columns
+	for(iter = expandCols.begin(); iter != expandCols.end(); ++iter)
+		sql << ", " << *iter;
+
+	// Reference column (last position)
+	if(ref_col.size())
+		sql << ", " << ref_col;
+
+	// Day range (distribution by day overlap)
+	if(dist.kernel == DIST_DAYS)
+		sql << ", " << dist.start_day_col << ", " << dist.end_day_col;
+
+	sql << " FROM " << read_table;
+	if(where.size())
+		sql << " " << where;
+	sql << ";";
+	return sql.str();
+}
+
+string expand_spec::where_sql(const string &cond) const
+{
+	if(filter.empty() && cond.empty())
+		return string();
+
+	if(filter.empty())
+		return "WHERE " + cond;
+
+	if(cond.empty())
+		return "WHERE " + filter;
+
+	return "WHERE (" + filter + ") AND " + cond;
+}
+
+// Index values are written from first to last (bounds clipped to window)
+string expand_spec::first_sql() const
+{
+	string lo = "CAST(" + lo_bound_col + " AS INTEGER)";
+	if(ref_col.empty())
+		return lo;
+
+	stringstream sql;
+	sql << "MAX(" << lo << ", CAST(" << ref_col << " AS INTEGER) + (" << window_lo << "))";
+	return sql.str();
+}
+
+string expand_spec::last_sql() const
+{
+	string hi = "CAST(" + up_bound_col + " AS INTEGER)";
+	if(ref_col.empty())
+		return hi;
+
+	stringstream sql;
+	sql << "MIN(" << hi << ", CAST(" << ref_col << " AS INTEGER) + (" << window_hi << "))";
+	return sql.str();
+}
+
+// Skipped rows (NULL or inverted bounds, empty window) are excluded like in expand_row
+string expand_spec::valid_sql() const
+{
+	stringstream sql;
+	sql << lo_bound_col << " IS NOT NULL AND " << up_bound_col << " IS NOT NULL";
+	if(ref_col.size())
+		sql << " AND " << ref_col << " IS NOT NULL";
+	sql << " AND " << last_sql() << " >= " << first_sql();
+	return sql.str();
+}
+
+string expand_spec::span_sql(const string &where) const
+{
+	stringstream sql;
+	sql << "SELECT COALESCE(SUM(" << last_sql() << " - " << first_sql() << " + 1), 0)";
+	sql << " FROM " << read_table;
+	sql << " WHERE " << valid_sql();
+	if(filter.size())
+		sql << " AND (" << filter << ")";
+	if(where.size())
+		sql << " AND " << where;
+	sql << ";";
+	return sql.str();
+}
+
+// WITH RECURSIVE
+// _src AS (SELECT rowid AS _rowid, id AS _rid, <lo> AS _lo, <hi> AS _hi, <first> AS _first,
+// 		<last> AS _last [, <ref> AS _ref], cpy1, exp1 FROM tbl WHERE <valid> [AND (filter)]),
+// _pos AS (SELECT *, SUM(_last - _first + 1) OVER (ORDER BY _rowid ROWS UNBOUNDED PRECEDING)
+// 		- (_last - _first + 1) AS _before FROM _src),
+// _seq(_k) AS (SELECT 0 UNION ALL SELECT _k + 1 FROM _seq WHERE _k < max_span - 1)
+// INSERT INTO rtbl (id, rid, woche, cpy1, exp1)
+// SELECT first_id + _before + _k + 1, _rid, _first + _k, cpy1, <share of exp1>
+// FROM _pos CROSS JOIN _seq WHERE _k <= _last - _first;
+//
+// Ids follow from the prefix sum of row counts in rowid order (as in
+// parallel_expand), values are calculated like in expand_row.
+string expand_spec::expand_sql(const string &table, sqlite3_int64 max_span, unsigned long first_id) const
+{
+	stringstream sql;
+	list<string>::const_iterator iter;
+
+	sql << "WITH RECURSIVE _src AS (SELECT rowid AS _rowid, id AS _rid";
+	sql << ", CAST(" << lo_bound_col << " AS INTEGER) AS _lo";
+	sql << ", CAST(" << up_bound_col << " AS INTEGER) AS _hi";
+	sql << ", " << first_sql() << " AS _first, " << last_sql() << " AS _last";
+	if(ref_col.size())
+		sql << ", CAST(" << ref_col << " AS INTEGER) AS _ref";
+	for(iter = copyCols.begin(); iter != copyCols.end(); ++iter)
+		sql << ", " << *iter;
+	for(iter = expandCols.begin(); iter != expandCols.end(); ++iter)
+		sql << ", " << *iter;
+	sql << " FROM " << read_table << " WHERE " << valid_sql();
+	if(filter.size())
+		sql << " AND (" << filter << ")";
+	sql << "), ";
+
+	sql << "_pos AS (SELECT *, SUM(_last - _first + 1) OVER (ORDER BY _rowid ROWS UNBOUNDED PRECEDING)"
+		<< " - (_last - _first + 1) AS _before FROM _src), ";
+	sql << "_seq(_k) AS (SELECT 0 UNION ALL SELECT _k + 1 FROM _seq WHERE _k < " << max_span - 1 << ") ";
+
+	sql << "INSERT INTO " << table << " (id, rid, " << index_column;
+	for(iter = copyCols.begin(); iter != copyCols.end(); ++iter)
+		sql << ", " << *iter;
+	for(iter = expandCols.begin(); iter != expandCols.end(); ++iter)
+		sql << ", " << *iter;
+
+	sql << ") SELECT " << first_id << " + _before + _k + 1, _rid, _first + _k";
+	if(rel_index)
+		sql << " - _ref";
+
+	for(iter = copyCols.begin(); iter != copyCols.end(); ++iter)
+		sql << ", " << *iter;
+
+	// Values are multiplied with shares (as in outer_product),
+	// even distribution divides by span (as in expand_row)
+	for(iter = expandCols.begin(); iter != expandCols.end(); ++iter)
+	{
+		sql << ", CAST(" << *iter << " AS REAL)";
+		if(dist.kernel == DIST_FIRST)
+			sql << " * (CASE WHEN _first + _k = _lo THEN 1.0 ELSE 0.0 END)";
+		else if(dist.kernel == DIST_LAST)
+			sql << " * (CASE WHEN _first + _k = _hi THEN 1.0 ELSE 0.0 END)";
+		else
+			sql << " / (_hi - _lo + 1)";
+	}
+
+	sql << " FROM _pos CROSS JOIN _seq WHERE _k <= _last - _first;";
+	return sql.str();
+}
+
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
+// Parallel expansion (see parallel_expand)
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
+struct expand_partition
+{
+	expand_partition() : first_rowid(0), last_rowid(0), first_id(0), n_rows(0), success(false) {}
+
+	sqlite3_int64 first_rowid;
+	sqlite3_int64 last_rowid;
+	unsigned long first_id;		// Auto id before first created row
+	string stage_file;
+	long n_rows;
+	bool success;
+};
+
+
+// Stage files: <db_file>.<pid>-<run>.part<i>
+// (run: counter of parallel_expand calls in this process)
+static atomic<unsigned> stage_runs(0);
+
+// Creates empty file. Fails when the file exists (is never overwritten).
+static bool create_stage_file(const string &file)
+{
+	FILE *f = fopen(file.c_str(), "wx");
+	if(!f)
+		return false;
+	fclose(f);
+	return true;
+}
+
+// File name is bound (may contain quotes)
+static bool attach_database(sqlite_con &con, const string &file, const string &schema)
+{
+	sqlite_stmt stmt(con);
+	if(!stmt.prepare("ATTACH DATABASE ? AS " + schema + ";"))
+		return false;
+	bool success = stmt.bind_text(1, file) && stmt.step();
+	return stmt.finalize() && success;
+}
+
+
+static void expand_partition_rows(sqlite_con &con, const expand_spec &spec,
+		unsigned int batch_size, expand_partition *part)
+{
+	part->success = false;
+
+	if(!con.open())
+		return;
+
+	// Staging table is created in separate database
+	// (empty file created by parallel_expand)
+	if(!attach_database(con, part->stage_file, "stage"))
+		return;
+
+	stringstream sql;
+	sql << "PRAGMA stage.synchronous=OFF;";
+	sql << "PRAGMA stage.journal_mode=OFF;";
+	if(!con.exec(sql.str()))
+		return;
+
+	if(!con.create_table(spec.create_sql("stage." + spec.write_table)))
+		return;
+
+	sqlite_batch_stmt stmt(con);
+	if(!stmt.prepare(spec.insert_sql("stage." + spec.write_table), spec.n_columns(), batch_size))
+		return;
+	stmt.setAutoId(part->first_id);
+
+	sql.str("");
+	sql << "rowid BETWEEN " << part->first_rowid << " AND " << part->last_rowid;
+
+	sqlite_stmt read_stmt(con);
+	if(!read_stmt.prepare(spec.select_sql(spec.where_sql(sql.str()) + " ORDER BY rowid")))
+		return;
+
+	con.begin();
+	part->n_rows = expand_rows(read_stmt, stmt, spec);
+	con.commit();
+
+	read_stmt.finalize();
+	stmt.finalize();
+	part->success = (part->n_rows >= 0) && con.close();
+}
+
+
+// Messages are passed to the main thread through log (see log_sink.h).
+// n_done is incremented on return.
+static void expand_partition_worker(const string &db_file, const expand_spec &spec,
+		unsigned int batch_size, bool verbose, expand_partition *part,
+		log_queue *log, atomic<unsigned> *n_done)
+{
+	// Stream must outlive connection (messages on destruction)
+	log_stream os(*log);
+	{
+		sqlite_con con(db_file, os, verbose);
+		expand_partition_rows(con, spec, batch_size, part);
+	}
+	os.flush();
+	n_done->fetch_add(1);
+}
+
+
+bool parallel_expand(sqlite_con &con, const expand_spec &spec,
+		unsigned int n_threads, unsigned int batch_size, bool verbose,
+		unsigned long first_id, expand_watermark *wm)
+{
+	ostream &os = con.getos();
+	const string &db_file = con.get_db_name();
+	stringstream sql;
+	unsigned int i;
+
+	sqlite3_int64 min_rowid, max_rowid;
+	sql << "SELECT COALESCE(MIN(rowid), 0), COALESCE(MAX(rowid), -1) FROM " << spec.read_table << " " << spec.where_sql() << ";";
+	{
+		sqlite_stmt s(con);
+		if(!s.prepare(sql.str()) || !s.fetch())
+			return false;
+		min_rowid = s.column_int(0);
+		max_rowid = s.column_int(1);
+		s.finalize();
+	}
+
+	if(max_rowid < min_rowid)
+	{
+		if(!wm)
+			return true;
+		wm->last_id = first_id;
+		return set_watermark(con, spec, *wm);
+	}
+
+	if((sqlite3_uint64) (max_rowid - min_rowid + 1) < n_threads)
+		n_threads = (unsigned int) (max_rowid - min_rowid + 1);
+
+	// All staging databases are attached for the merge
+	long n_attached = con.get_count_value("SELECT COUNT(*) FROM pragma_database_list WHERE name NOT IN ('main', 'temp');");
+	long max_parts = con.get_limit(SQLITE_LIMIT_ATTACHED) - n_attached;
+	if(n_attached < 0 || max_parts < 1)
+	{
+		os << log_error << "[parallel_expand] ERROR: No free slot for ATTACH DATABASE (SQLITE_LIMIT_ATTACHED)!\n";
+		return false;
+	}
+	if((long) n_threads > max_parts)
+	{
+		if(verbose)
+			os << "[parallel_expand] Threads reduced from " << n_threads << " to " << max_parts << " (SQLITE_LIMIT_ATTACHED).\n";
+		n_threads = (unsigned int) max_parts;
+	}
+
+	// - - - - - - - - - - - - - - - - - - - - - - - - - //
+	// Partitions and id offsets (prefix sum of spans)
+	// - - - - - - - - - - - - - - - - - - - - - - - - - //
+	vector<expand_partition> parts(n_threads);
+	unsigned run = stage_runs++;
+	sqlite3_int64 width = (max_rowid - min_rowid) / n_threads + 1;
+	sqlite_stmt span_stmt(con);
+	if(!span_stmt.prepare(spec.span_sql("rowid BETWEEN ? AND ?")))
+		return false;
+
+	for(i = 0; i < n_threads; ++i)
+	{
+		expand_partition &p = parts[i];
+		p.first_rowid = min_rowid + i * width;
+		p.last_rowid = (i == n_threads - 1) ? max_rowid : p.first_rowid + width - 1;
+		p.first_id = first_id;
+
+		stringstream st;
+		st << db_file << "." << stage_pid() << "-" << run << ".part" << i;
+		p.stage_file = st.str();
+
+		span_stmt.bind_int64(1, p.first_rowid);
+		span_stmt.bind_int64(2, p.last_rowid);
+		if(!span_stmt.fetch())
+			return false;
+		first_id += span_stmt.column_int(0);
+		span_stmt.reset();
+	}
+	span_stmt.finalize();
+
+	if(verbose)
+		os << "[parallel_expand] Expanding " << spec.read_table << " with " << n_threads << " threads (last id: " << first_id << ").\n";
+
+	// - - - - - - - - - - - - - - - - - - - - - - - - - //
+	// Stage files (existing files are not touched)
+	// - - - - - - - - - - - - - - - - - - - - - - - - - //
+	unsigned int n_created = 0;
+	while(n_created < n_threads && create_stage_file(parts[n_created].stage_file))
+		++n_created;
+
+	if(n_created < n_threads)
+	{
+		os << log_error << "[parallel_expand] ERROR: Cannot create stage file '"
+				<< parts[n_created].stage_file << "' (file exists?)!\n";
+		for(i = 0; i < n_created; ++i)
+			remove(parts[i].stage_file.c_str());
+		return false;
+	}
+
+	// - - - - - - - - - - - - - - - - - - - - - - - - - //
+	// Expand partitions
+	// - - - - - - - - - - - - - - - - - - - - - - - - - //
+	log_queue log;
+	atomic<unsigned> n_done(0);
+	vector<thread> workers;
+	for(i = 0; i < n_threads; ++i)
+		workers.push_back(thread(expand_partition_worker, db_file, spec, batch_size, verbose, &parts[i], &log, &n_done));
+
+	// Messages of workers are written while waiting
+	while(n_done.load() < n_threads)
+	{
+		log.drain(os);
+		this_thread::sleep_for(chrono::milliseconds(20));
+	}
+
+	for(i = 0; i < n_threads; ++i)
+		workers[i].join();
+	log.drain(os);
+
+	bool success = true;
+	for(i = 0; i < n_threads; ++i)
+	{
+		if(!parts[i].success)
+		{
+			os << "[parallel_expand] Expansion of partition " << i << " failed!\n";
+			success = false;
+		}
+	}
+
+	// - - - - - - - - - - - - - - - - - - - - - - - - - //
+	// Merge staging tables in partition order in one
+	// transaction (ATTACH is not allowed inside transaction):
+	// The write table gets all partitions or none.
+	// - - - - - - - - - - - - - - - - - - - - - - - - - //
+	unsigned int n_parts = 0;
+	while(success && n_parts < n_threads)
+	{
+		sql.str("");
+		sql << "part" << n_parts;
+		success = attach_database(con, parts[n_parts].stage_file, sql.str());
+		if(success)
+			++n_parts;
+	}
+
+	if(success)
+	{
+		con.begin();
+		for(i = 0; success && i < n_threads; ++i)
+		{
+			sql.str("");
+			sql << "INSERT INTO " << spec.write_table << " SELECT * FROM part" << i << "." << spec.write_table << ";";
+			success = con.exec(sql.str());
+		}
+
+		// Watermark is never behind the appended rows
+		if(success && wm)
+		{
+			wm->last_id = first_id;
+			success = set_watermark(con, spec, *wm);
+		}
+
+		if(success)
+			con.commit();
+		else
+		{
+			con.rollback();
+			os << log_error << "[parallel_expand] Merge into " << spec.write_table << " failed (rolled back)!\n";
+		}
+	}
+
+	for(i = 0; i < n_parts; ++i)
+	{
+		sql.str("");
+		sql << "DETACH DATABASE part" << i << ";";
+		con.exec(sql.str());
+	}
+
+	for(i = 0; i < n_threads; ++i)
+		remove(parts[i].stage_file.c_str());
+
+	if(success && verbose)
+		os << "[parallel_expand] Merged " << n_threads << " partitions into " << spec.write_table << ".\n";
+
+	return success;
+}
+
+bool create_expand_meta(sqlite_con &con)
+{
+	stringstream sql;
+	sql << "CREATE TABLE IF NOT EXISTS " << expand_meta_table << " (";
+	sql << "write_table TEXT PRIMARY KEY, read_table TEXT, watermark INTEGER, last_id INTEGER, complete INTEGER);";
+	return con.create_table(sql.str());
+}
+
+bool get_watermark(sqlite_con &con, const expand_spec &spec, expand_watermark &wm)
+{
+	stringstream sql;
+	sql << "SELECT m.read_table, m.watermark, m.last_id, m.complete FROM " << expand_meta_table << " m";
+	sql << " WHERE m.write_table = ? AND EXISTS";
+	sql << " (SELECT 1 FROM sqlite_master WHERE type = 'table' AND name = m.write_table);";
+
+	wm = expand_watermark();
+
+	sqlite_stmt s(con);
+	if(!s.prepare(sql.str()) || !s.bind_text(1, spec.write_table))
+		return false;
+
+	if(s.fetch())
+	{
+		wm.found = !s.column_is_null(0) && !s.column_is_null(1) && (spec.read_table == s.column_text(0));
+		wm.rowid = s.column_int(1);
+		wm.last_id = (unsigned long) s.column_int(2);
+		wm.complete = (s.column_int(3) != 0);
+		s.reset();
+	}
+	else if(!s.is_done())
+		return false;
+
+	return s.finalize();
+}
+
+bool set_watermark(sqlite_con &con, const expand_spec &spec, const expand_watermark &wm)
+{
+	stringstream sql;
+	sql << "INSERT OR REPLACE INTO " << expand_meta_table;
+	sql << " (write_table, read_table, watermark, last_id, complete) VALUES (?, ?, ?, ?, ?);";
+
+	sqlite_stmt s(con);
+	if(!s.prepare(sql.str()))
+		return false;
+
+	bool success = s.bind_text(1, spec.write_table) && s.bind_text(2, spec.read_table)
+			&& s.bind_int64(3, wm.rowid) && s.bind_int64(4, (sqlite3_int64) wm.last_id)
+			&& s.bind_int(5, wm.complete ? 1 : 0) && s.step();
+
+	s.finalize();
+	return success;
+}
+
+bool set_watermark(sqlite_con &con, const expand_spec &spec, sqlite3_int64 rowid, unsigned long last_id)
+{
+	expand_watermark wm;
+	wm.rowid = rowid;
+	wm.last_id = last_id;
+	return set_watermark(con, spec, wm);
+}
+
+bool get_max_rowid(sqlite_con &con, const string &table, sqlite3_int64 &max_rowid)
+{
+	sqlite_stmt s(con);
+	if(!s.prepare("SELECT COALESCE(MAX(rowid), 0) FROM " + table + ";") || !s.fetch())
+		return false;
+
+	max_rowid = s.column_int(0);
+	s.reset();
+	return s.finalize();
+}
+
+bool get_column_decltype(sqlite_con &con, const string &table, const string &column,
+		bool &found, string &decl)
+{
+	sqlite_stmt s(con);
+	if(!s.prepare("PRAGMA table_info(" + table + ");"))
+		return false;
+
+	found = false;
+	while(s.fetch())
+	{
+		if(sqlite3_stricmp(s.column_text(1), column.c_str()) == 0)
+		{
+			found = true;
+			decl = s.column_text(2) ? s.column_text(2) : "";
+		}
+	}
+	if(!s.is_done())
+		return false;
+	return s.finalize();
+}
+
+
+long expand_chunked(sqlite_batch_stmt &stmt, const expand_spec &spec,
+		expand_watermark &wm, sqlite3_int64 high_mark, unsigned long commit_rows, bool verbose)
+{
+	sqlite_con &con = stmt.get_con();
+	ostream &os = con.getos();
+
+	// Last rowid of next chunk
+	stringstream sql;
+	sql << "SELECT rowid FROM " << spec.read_table << " " << spec.where_sql("rowid > ?");
+	sql << " ORDER BY rowid LIMIT 1 OFFSET ?;";
+
+	sqlite_stmt end_stmt(con);
+	if(!end_stmt.prepare(sql.str()))
+		return -1;
+
+	sqlite_stmt read_stmt(con);
+	if(!read_stmt.prepare(spec.select_sql(spec.where_sql("rowid > ? AND rowid <= ?") + " ORDER BY rowid")))
+		return -1;
+
+	long nRows = 0, nChunk;
+	sqlite3_int64 chunk_end;
+	stmt.setAutoId(wm.last_id);
+	expand_stats *stats = stmt.get_stats();
+
+	while(wm.rowid < high_mark)
+	{
+		end_stmt.bind_int64(1, wm.rowid);
+		end_stmt.bind_int(2, commit_rows - 1);
+		if(end_stmt.fetch())
+		{
+			chunk_end = std::min(end_stmt.column_int(0), high_mark);
+			end_stmt.reset();
+		}
+		else if(end_stmt.is_done())
+			chunk_end = high_mark;
+		else
+			return -1;
+
+		con.begin();
+		read_stmt.bind_int64(1, wm.rowid);
+		read_stmt.bind_int64(2, chunk_end);
+		nChunk = expand_rows(read_stmt, stmt, spec, stats);
+		if(nChunk < 0)
+		{
+			con.rollback();
+			return -1;
+		}
+
+		expand_watermark next;
+		next.rowid = chunk_end;
+		next.last_id = stmt.lastAutoId();
+		next.complete = (chunk_end >= high_mark);
+		if(!set_watermark(con, spec, next))
+		{
+			con.rollback();
+			stmt.setAutoId(wm.last_id);
+			return -1;
+		}
+		con.commit();
+		if(stats)
+			stats->lap(PHASE_COMMIT);
+
+		wm = next;
+		nRows += nChunk;
+		if(verbose)
+			os << "[expand_chunked] Checkpoint: rowid " << wm.rowid << ", id " << wm.last_id << ".\n";
+	}
+
+	// Empty range: Mark run as complete
+	if(!wm.complete)
+	{
+		wm.complete = true;
+		if(!set_watermark(con, spec, wm))
+			return -1;
+	}
+
+	if(stats)
+	{
+		stats->read.add(end_stmt);
+		stats->read.add(read_stmt);
+	}
+	end_stmt.finalize();
+	read_stmt.finalize();
+	return nRows;
+}
+
+
+} // namespace sqlite
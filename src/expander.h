@@ -0,0 +1,371 @@
+/*
+ * expander.h
+ *
+ *  Created on: 17.10.2026
+ *      Author: kaisers
+ *
+ *  Expansion of table rows (R independent part of expand_table):
+ *  Each row of the read table is replicated for all index values
+ *  between lower and upper bound. Values of expanded columns are
+ *  equally distributed over the created rows.
+ *
+ *  Messages are written to the ostream of the used sqlite_con.
+ *  No R functions are called, so workers can run in separate threads.
+ */
+
+#ifndef EXPANDER_H_
+#define EXPANDER_H_
+
+#include "sqlite_con.h"
+#include "sqlite_stmt.h"
+#include "sqlite_cursor.h"
+#include "sqlite_batch.h"
+#include "expand_stats.h"
+#include "distribution.h"
+
+#include <string>
+#include <sstream>
+#include <list>
+#include <vector>
+#include <thread>
+#include <cstdio>
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+namespace sqlite {
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
+// Table and column names for expansion
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
+struct expand_spec
+{
+	expand_spec() : bulk_schema(false), window_lo(0), window_hi(0), rel_index(false) {}
+
+	string read_table;
+	string write_table;
+	string lo_bound_col;
+	string up_bound_col;
+	string index_column;		// Values vary from lower to upper bound
+	list<string> copyCols;
+	list<string> copyColTypes;
+	list<string> expandCols;
+	string filter;				// Condition on read table (e.g. rowid range
+								// for incremental expansion). Empty: all rows
+	bool bulk_schema;			// id INTEGER PRIMARY KEY, integer index column
+
+	// Window around reference column: Index values are restricted to
+	// [ref + window_lo, ref + window_hi]. Shares of expanded columns
+	// are still calculated from the full span [lo, hi].
+	string ref_col;				// Empty: No window
+	int window_lo;
+	int window_hi;
+	bool rel_index;				// Write index - ref instead of index
+
+	distribution dist;			// Shares of expanded columns (default: even)
+
+	unsigned int n_columns() const { return 3 + copyCols.size() + expandCols.size(); }
+
+	// Columns returned by select_sql (including reference column)
+	unsigned int n_select_columns() const
+	{
+		return n_columns() + (ref_col.size() ? 1 : 0) + (dist.kernel == DIST_DAYS ? 2 : 0);
+	}
+
+	string create_sql(const string &table) const;
+	string insert_sql(const string &table) const;
+	string select_sql(const string &where = string()) const;
+
+	// "WHERE filter AND cond" (empty string when there is no condition)
+	string where_sql(const string &cond = string()) const;
+
+	// Number of created rows: sum of (hi-lo+1) over all valid rows
+	string span_sql(const string &where = string()) const;
+
+	// Expressions on read table: First and last written index value
+	// and condition for expanded rows (see expand_row)
+	string first_sql() const;
+	string last_sql() const;
+	string valid_sql() const;
+
+	// Expansion inside SQLite (INSERT INTO table SELECT ..., see
+	// expand_engine.h). max_span: Maximal number of rows per source row
+	string expand_sql(const string &table, sqlite3_int64 max_span, unsigned long first_id) const;
+};
+
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
+// Expansion of single source row
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
+// SINK: sqlite_batch_stmt or target with same bind/step interface
+// (see frame_sink.h)
+template<class SINK = sqlite_batch_stmt>
+struct expand_data
+{
+	expand_data(SINK *s, const expand_spec &spec) : stmt(s),
+		expand_start(3 + spec.copyCols.size()),
+		expand_end(3 + spec.copyCols.size() + spec.expandCols.size() - 1),
+		ref_pos(spec.ref_col.size() ? (int) spec.n_columns() : -1),
+		window_lo(spec.window_lo), window_hi(spec.window_hi), rel_index(spec.rel_index),
+		dist(spec.dist), day_pos(spec.n_columns() + (spec.ref_col.size() ? 1 : 0)),
+		values(spec.expandCols.size()) {}
+
+	SINK * stmt;
+	unsigned int expand_start;	// = 3 + n_copy_columns
+	unsigned int expand_end;	// = expand_start + n_expand - 1
+	int ref_pos;				// Position of reference column (-1: No window)
+	int window_lo;
+	int window_hi;
+	bool rel_index;
+
+	// Distribution kernel and buffers for shares
+	const distribution &dist;
+	int day_pos;				// Position of start day column (DIST_DAYS)
+	vector<double> values;		// Values of expanded columns (NaN: NULL)
+	vector<double> shares;		// Share per index value in [lo, hi]
+	vector<double> out;			// values x shares (column major)
+};
+
+
+// Binds value of source column with its storage class (numbers are not
+// converted into text, text and blobs are passed with their size).
+// Called once per source row: Copied columns stay bound for all
+// expanded rows.
+// ROW: sqlite_row or decoded row (see pipeline.h)
+template<class SINK, class ROW>
+inline void bind_column(SINK *stmt, unsigned int pos, const ROW &row, int col)
+{
+	const char *text;
+	switch(row.type(col))
+	{
+		case SQLITE_INTEGER:
+			stmt->bind_int(pos, row.get_int(col));
+			break;
+		case SQLITE_FLOAT:
+			stmt->bind_double(pos, row.get_double(col));
+			break;
+		case SQLITE_NULL:
+			stmt->bind_null(pos);
+			break;
+		case SQLITE_BLOB:
+			stmt->bind_blob(pos, row.get_blob(col), row.get_bytes(col));
+			break;
+		default:
+			// Size is valid after text conversion
+			text = row.get_text(col);
+			stmt->bind_text(pos, text, row.get_bytes(col));
+	}
+}
+
+
+template<class ROW, class SINK>
+bool expand_row(const ROW &row, expand_data<SINK> &ed)
+{
+	SINK * stmt = ed.stmt;
+	unsigned int i, n_expand;
+	int index, lo_bound, hi_bound, first, last, ref = 0;
+
+	ostream & os = stmt->getos();
+
+	// SELECT id, min_woche, max_woche, cpy1, cpy2, exp1, exp2 FROM tbl;
+	if(row.is_null(1) || row.is_null(2))
+		return true;
+
+	lo_bound = (int) row.get_int(1);
+	hi_bound = (int) row.get_int(2);
+	if(hi_bound < lo_bound)
+		return true;
+
+	n_expand = hi_bound - lo_bound + 1;
+	first = lo_bound;
+	last = hi_bound;
+
+	// Clip range to window around reference value
+	if(ed.ref_pos >= 0)
+	{
+		if(row.is_null(ed.ref_pos))
+			return true;
+
+		ref = (int) row.get_int(ed.ref_pos);
+		first = std::max(lo_bound, ref + ed.window_lo);
+		last = std::min(hi_bound, ref + ed.window_hi);
+		if(last < first)
+			return true;
+	}
+
+	// INSERT INTO rtbl (id, rid, woche, cpy1, cpy2, exp1, exp2) VALUES (?, ?, ?, ?, ?, ?, ?)
+	stmt->bind_int(2, row.get_int(0));	// rid
+
+	// Bind values for copied columns
+	for(i = 3; i < ed.expand_start; ++i)
+		bind_column(stmt, i + 1, row, i);
+
+	if(ed.dist.kernel == DIST_EVEN)
+	{
+		// Bind values for expanded columns
+		for(i = ed.expand_start; i <= ed.expand_end; ++i)
+		{
+			if(row.is_null(i))
+				stmt->bind_null(i + 1);
+			else
+				stmt->bind_double(i + 1, row.get_double(i) / n_expand);
+		}
+
+		for(index = first; index <= last; ++index)
+		{
+			stmt->bind_int(1, stmt->getAutoId());
+			stmt->bind_int(3, ed.rel_index ? index - ref : index);
+			if(!stmt->step())
+			{
+				os << log_error << "[expand_table.expand_row] Step error!\n";
+				return false;
+			}
+		}
+		return true;
+	}
+
+	// - - - - - - - - - - - - - - - - - - - - - - - - - //
+	// Distribution kernel: Values for all expanded columns
+	// and index values are calculated at once
+	// - - - - - - - - - - - - - - - - - - - - - - - - - //
+	unsigned int n_values = ed.values.size(), n_index = last - first + 1, j;
+	for(i = 0; i < n_values; ++i)
+	{
+		j = ed.expand_start + i;
+		ed.values[i] = row.is_null(j) ? NAN : row.get_double(j);
+	}
+
+	bool has_days = (ed.dist.kernel == DIST_DAYS) && !row.is_null(ed.day_pos) && !row.is_null(ed.day_pos + 1);
+	period_shares(ed.dist, lo_bound, hi_bound, has_days,
+			has_days ? row.get_int(ed.day_pos) : 0, has_days ? row.get_int(ed.day_pos + 1) : 0, ed.shares);
+
+	ed.out.resize((size_t) n_values * n_index);
+	outer_product(&ed.values[0], n_values, &ed.shares[first - lo_bound], n_index, &ed.out[0]);
+
+	for(index = first; index <= last; ++index)
+	{
+		stmt->bind_int(1, stmt->getAutoId());
+		stmt->bind_int(3, ed.rel_index ? index - ref : index);
+
+		for(i = 0; i < n_values; ++i)
+		{
+			double v = ed.out[(size_t) i * n_index + (index - first)];
+			if(std::isnan(v))
+				stmt->bind_null(ed.expand_start + i + 1);
+			else
+				stmt->bind_double(ed.expand_start + i + 1, v);
+		}
+
+		if(!stmt->step())
+		{
+			os << log_error << "[expand_table.expand_row] Step error!\n";
+			return false;
+		}
+	}
+	return true;
+}
+
+// Expands all rows returned by prepared SELECT statement (see select_sql).
+// stats: Optional instrumentation (scan and expand time, see expand_stats.h)
+// Returns number of source rows or -1 on error.
+template<class SINK>
+long expand_rows(sqlite_stmt &read_stmt, SINK &stmt, const expand_spec &spec, expand_stats *stats = 0)
+{
+	expand_data<SINK> ed(&stmt, spec);
+
+	long nRows = 0;
+	for(const sqlite_row &row : sqlite_cursor(read_stmt))
+	{
+		if(stats)
+			stats->lap(PHASE_SCAN);
+		if(!expand_row(row, ed))
+			return -1;
+		if(stats)
+			stats->lap(PHASE_EXPAND);
+		++nRows;
+	}
+	if(stats)
+		stats->lap(PHASE_SCAN);
+
+	if(!read_stmt.is_done() || !stmt.flush())
+		return -1;
+
+	return nRows;
+}
+
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
+// Parallel expansion:
+// The read table is split into rowid ranges. Each range is expanded by a
+// separate thread (with separate connection) into a staging database
+// (new file <db_file>.<pid>-<run>.part<i>, the expansion fails when the
+// file exists). Afterwards, all staging databases are attached and copied into the
+// write table in one transaction (rolled back on error). The number of
+// threads is limited by SQLITE_LIMIT_ATTACHED.
+//
+// Ids are calculated from a prefix sum of (hi-lo+1) spans, so the
+// output is identical to serial expansion (in rowid order).
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
+// first_id: Auto id before first created row (max id of write table when appending)
+// wm: Incremental expansion (optional): wm->last_id is set to the last
+// written id and the watermark is written in the merge transaction.
+struct expand_watermark;
+bool parallel_expand(sqlite_con &con, const expand_spec &spec,
+		unsigned int n_threads, unsigned int batch_size, bool verbose,
+		unsigned long first_id = 0, expand_watermark *wm = 0);
+
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
+// Incremental expansion and checkpoints:
+// Table expand_meta contains one row per write table with the highest
+// expanded rowid of the read table (watermark) and the last written id.
+// Subsequent runs only expand source rows above the watermark and append
+// them to the write table.
+// Chunked expansion (see expand_chunked) writes the watermark with each
+// commit and marks it as incomplete until the last chunk is written.
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
+const char * const expand_meta_table = "expand_meta";
+
+struct expand_watermark
+{
+	expand_watermark() : found(false), rowid(0), last_id(0), complete(true) {}
+
+	bool found;
+	sqlite3_int64 rowid;		// Highest expanded rowid of read table
+	unsigned long last_id;		// Highest written id
+	bool complete;				// false: Checkpoint of interrupted run
+};
+
+bool create_expand_meta(sqlite_con &con);
+
+// wm.found = false when no watermark is recorded for the write table,
+// when the write table does not exist or when the watermark
+// belongs to a different read table.
+// Returns false on error.
+bool get_watermark(sqlite_con &con, const expand_spec &spec, expand_watermark &wm);
+
+bool set_watermark(sqlite_con &con, const expand_spec &spec, const expand_watermark &wm);
+
+// Complete watermark (end of run)
+bool set_watermark(sqlite_con &con, const expand_spec &spec, sqlite3_int64 rowid, unsigned long last_id);
+
+// Highest rowid of table (0 for empty table)
+bool get_max_rowid(sqlite_con &con, const string &table, sqlite3_int64 &max_rowid);
+
+// Declared type of column (found = false when table has no such column)
+bool get_column_decltype(sqlite_con &con, const string &table, const string &column,
+		bool &found, string &decl);
+
+
+// Expands source rows in rowid order and commits every commit_rows source
+// rows. The watermark (checkpoint) is written in the same transaction,
+// so an interrupted run can be resumed from the last commit.
+// wm: Checkpoint to start from (updated while running).
+// Returns number of source rows or -1 on error.
+long expand_chunked(sqlite_batch_stmt &stmt, const expand_spec &spec,
+		expand_watermark &wm, sqlite3_int64 high_mark, unsigned long commit_rows, bool verbose);
+
+
+} // namespace sqlite
+#endif /* EXPANDER_H_ */
@@ -0,0 +1,166 @@
+/*
+ * frame_sink.cpp
+ *
+ *  Created on: 17.10.2026
+ *      Author: kaisers
+ */
+
+#include "frame_sink.h"
+
+namespace sqlite {
+
+
+int decltype_to_sexptype(const char *decl)
+{
+	if(decl == 0 || *decl == 0)
+		return NILSXP;
+
+	string type(decl);
+	transform(type.begin(), type.end(), type.begin(), ::toupper);
+
+	if(type.find("INT") != string::npos)
+		return INTSXP;
+	if(type.find("CHAR") != string::npos || type.find("CLOB") != string::npos
+			|| type.find("TEXT") != string::npos || type.find("BLOB") != string::npos)
+		return STRSXP;
+	return REALSXP;
+}
+
+void set_data_frame_attributes(SEXP pDf, R_xlen_t n_rows)
+{
+	SEXP pRowNames = PROTECT(allocVector(INTSXP, 2));
+	INTEGER(pRowNames)[0] = NA_INTEGER;
+	INTEGER(pRowNames)[1] = -((int) n_rows);
+	setAttrib(pDf, R_RowNamesSymbol, pRowNames);
+	setAttrib(pDf, R_ClassSymbol, mkString("data.frame"));
+	UNPROTECT(1);
+}
+
+
+SEXP frame_sink::alloc_frame(const expand_spec &spec, R_xlen_t n_rows)
+{
+	list<string>::const_iterator iter, titer;
+	int n_cols = spec.n_columns(), j = 0;
+
+	SEXP pDf = PROTECT(allocVector(VECSXP, n_cols));
+	SEXP pNames = PROTECT(allocVector(STRSXP, n_cols));
+
+	SET_VECTOR_ELT(pDf, j, allocVector(INTSXP, n_rows));
+	SET_STRING_ELT(pNames, j++, mkChar("id"));
+	SET_VECTOR_ELT(pDf, j, allocVector(INTSXP, n_rows));
+	SET_STRING_ELT(pNames, j++, mkChar("rid"));
+	SET_VECTOR_ELT(pDf, j, allocVector(INTSXP, n_rows));
+	SET_STRING_ELT(pNames, j++, mkChar(spec.index_column.c_str()));
+
+	for(iter = spec.copyCols.begin(), titer = spec.copyColTypes.begin(); iter != spec.copyCols.end(); ++iter, ++titer)
+	{
+		int type = decltype_to_sexptype(titer->c_str());
+		SET_VECTOR_ELT(pDf, j, allocVector(type == NILSXP ? STRSXP : type, n_rows));
+		SET_STRING_ELT(pNames, j++, mkChar(iter->c_str()));
+	}
+
+	for(iter = spec.expandCols.begin(); iter != spec.expandCols.end(); ++iter)
+	{
+		SET_VECTOR_ELT(pDf, j, allocVector(REALSXP, n_rows));
+		SET_STRING_ELT(pNames, j++, mkChar(iter->c_str()));
+	}
+
+	setAttrib(pDf, R_NamesSymbol, pNames);
+	set_data_frame_attributes(pDf, n_rows);
+	UNPROTECT(2);
+	return pDf;
+}
+
+
+// The CHARSXP is written into the current (not yet stepped) row,
+// so it is protected by the column vector until step() is called.
+void frame_sink::cache_string(unsigned col)
+{
+	if(chars.size() != row.size())
+		chars.assign(row.size(), NA_STRING);
+
+	if(types[col] != STRSXP)
+		return;
+
+	// Text of the source table is UTF-8
+	chars[col] = mkCharLenCE(row[col].text.c_str(), row[col].text.size(), CE_UTF8);
+	if(n_rows < capacity)
+		SET_STRING_ELT(cols[col], n_rows, chars[col]);
+}
+
+
+bool frame_sink::step()
+{
+	if(n_rows >= capacity)
+	{
+		os << "[frame_sink] step ERROR: Capacity (" << (long) capacity << " rows) exceeded!\n";
+		return false;
+	}
+
+	char buf[32];
+	unsigned j, n_cols = row.size();
+	for(j = 0; j < n_cols; ++j)
+	{
+		const sqlite_cell &c = row[j];
+		SEXP pCol = cols[j];
+
+		switch(types[j])
+		{
+			case INTSXP:
+				if(c.type == SQLITE_NULL)
+					INTEGER(pCol)[n_rows] = NA_INTEGER;
+				else
+				{
+					sqlite3_int64 v = (c.type == SQLITE_INTEGER) ? c.ival :
+							((c.type == SQLITE_FLOAT) ? (sqlite3_int64) c.dval : atoll(c.text.c_str()));
+					if(v > INT_MAX || v <= INT_MIN)
+					{
+						os << "[frame_sink] step ERROR: Value " << v << " out of integer range!\n";
+						return false;
+					}
+					INTEGER(pCol)[n_rows] = (int) v;
+				}
+				break;
+
+			case REALSXP:
+				switch(c.type)
+				{
+					case SQLITE_NULL:		REAL(pCol)[n_rows] = NA_REAL; break;
+					case SQLITE_INTEGER:	REAL(pCol)[n_rows] = (double) c.ival; break;
+					case SQLITE_FLOAT:		REAL(pCol)[n_rows] = c.dval; break;
+					default:				REAL(pCol)[n_rows] = strtod(c.text.c_str(), NULL);
+				}
+				break;
+
+			default:
+				switch(c.type)
+				{
+					case SQLITE_NULL:
+						SET_STRING_ELT(pCol, n_rows, NA_STRING);
+						break;
+					case SQLITE_TEXT:
+						SET_STRING_ELT(pCol, n_rows, chars[j]);
+						break;
+					case SQLITE_INTEGER:
+						snprintf(buf, sizeof(buf), "%lld", (long long) c.ival);
+						SET_STRING_ELT(pCol, n_rows, mkChar(buf));
+						break;
+					default:
+						snprintf(buf, sizeof(buf), "%.15g", c.dval);
+						SET_STRING_ELT(pCol, n_rows, mkChar(buf));
+				}
+		}
+	}
+	++n_rows;
+
+	// Keep CHARSXP of current row protected
+	for(j = 0; j < n_cols; ++j)
+	{
+		if(types[j] == STRSXP && row[j].type == SQLITE_TEXT && n_rows < capacity)
+			SET_STRING_ELT(cols[j], n_rows, chars[j]);
+	}
+	return true;
+}
+
+
+} // namespace sqlite
@@ -0,0 +1,137 @@
+/*
+ * frame_sink.h
+ *
+ *  Created on: 17.10.2026
+ *      Author: kaisers
+ *
+ *  Expansion target which writes rows into preallocated R vectors
+ *  (columns of a data.frame) instead of an SQLite table.
+ *  frame_sink has the same bind/step interface as sqlite_batch_stmt,
+ *  so it can be used with expand_row and expand_rows (see expander.h).
+ *
+ *  R functions are called inside bind and step:
+ *  Only to be used from the main thread.
+ */
+
+#ifndef FRAME_SINK_H_
+#define FRAME_SINK_H_
+
+#include "expander.h"
+
+#include <string>
+#include <vector>
+#include <sstream>
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <climits>
+
+#include <R.h>
+#include <Rinternals.h>
+
+using namespace std;
+
+namespace sqlite {
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
+// R type for declared SQLite column type (affinity rules).
+// Returns NILSXP for empty declaration.
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
+int decltype_to_sexptype(const char *decl);
+
+// Sets class and compact row names: c(NA, -n_rows)
+void set_data_frame_attributes(SEXP pDf, R_xlen_t n_rows);
+
+
+class frame_sink {
+public:
+	// pDf: Allocated with alloc_frame (protected by caller)
+	frame_sink(SEXP pDf, ostream &o) : df(pDf), os(o), n_rows(0), auto_id(0)
+	{
+		int j, n_cols = length(df);
+		for(j = 0; j < n_cols; ++j)
+		{
+			SEXP pCol = VECTOR_ELT(df, j);
+			cols.push_back(pCol);
+			types.push_back(TYPEOF(pCol));
+		}
+		capacity = n_cols ? XLENGTH(cols[0]) : 0;
+		row.assign(n_cols, sqlite_cell());
+	}
+
+	// Columns as created by create_output_table:
+	// id, rid, index column, copied columns (copyColTypes), expanded columns
+	static SEXP alloc_frame(const expand_spec &spec, R_xlen_t n_rows);
+
+	ostream & getos() const { return os; }
+
+	unsigned long getAutoId() { return ++auto_id; }
+	void setAutoId(unsigned long id) { auto_id = id; }
+	unsigned long lastAutoId() const { return auto_id; }
+
+	// Number of written rows
+	R_xlen_t size() const { return n_rows; }
+
+	///////////////////////////////////////////////////////////////////////////////////////////////
+	// Same semantics as sqlite_batch_stmt (pos is 1-based position inside row)
+	void bind_int(unsigned pos, const sqlite3_int64 &value)
+	{
+		sqlite_cell &c = row[pos - 1];
+		c.type = SQLITE_INTEGER;
+		c.ival = value;
+	}
+
+	void bind_double(unsigned pos, const double &value)
+	{
+		sqlite_cell &c = row[pos - 1];
+		c.type = SQLITE_FLOAT;
+		c.dval = value;
+	}
+
+	void bind_text(unsigned pos, const char *text)
+	{
+		bind_text(pos, text, strlen(text));
+	}
+
+	void bind_text(unsigned pos, const char *text, int n)
+	{
+		sqlite_cell &c = row[pos - 1];
+		c.type = SQLITE_TEXT;
+		c.text.assign(text, n);
+		cache_string(pos - 1);
+	}
+
+	// Character column (as text)
+	void bind_blob(unsigned pos, const void *data, int n)
+	{
+		bind_text(pos, (const char*) data, n);
+	}
+
+	void bind_null(unsigned pos)
+	{
+		row[pos - 1].type = SQLITE_NULL;
+	}
+
+	bool step();
+	bool flush() { return true; }
+
+private:
+	frame_sink(const frame_sink &rhs);
+
+	void cache_string(unsigned col);
+
+	SEXP df;
+	ostream &os;
+	vector<SEXP> cols;
+	vector<int> types;
+	vector<sqlite_cell> row;		// Current row
+	vector<SEXP> chars;				// CHARSXP of current row (STRSXP columns)
+	R_xlen_t capacity;
+	R_xlen_t n_rows;
+	unsigned long int auto_id;
+};
+
+
+} // namespace sqlite
+#endif /* FRAME_SINK_H_ */
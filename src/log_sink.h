@@ -0,0 +1,253 @@
+/*
+ * log_sink.h
+ *
+ *  Created on: 17.10.2026
+ *      Author: kaisers
+ *
+ *  Logging interface of the R independent core:
+ *  Messages are written to an ostream (see sqlite_con::getos), which
+ *  collects text and passes complete lines to a log_sink.
+ *
+ *  log_sink	: Destination of messages (R console: see rostream.h)
+ *  log_stream	: ostream which writes into a log_sink
+ *  stderr_sink	: Writes to standard error (command line tools)
+ *  log_queue	: Thread safe sink. Records are collected in a lock-free
+ *  			  list and written by the consuming thread (drain).
+ *  			  Worker threads write into a log_stream on a shared
+ *  			  log_queue; the main thread drains it into its stream.
+ *  log_limit	: Counts repeated messages (e.g. per-row errors) and
+ *  			  admits only the first ones.
+ *
+ *  Level of the next record: os << log_error << "..." (default: level
+ *  of log_stream). Ignored by other ostreams.
+ */
+
+#ifndef LOG_SINK_H_
+#define LOG_SINK_H_
+
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+
+using namespace std;
+
+namespace sqlite {
+
+enum log_level { LOG_ERROR, LOG_WARN, LOG_INFO, LOG_DEBUG };
+
+
+class log_sink {
+public:
+	virtual ~log_sink() {}
+
+	// Text contains one or more lines and is not terminated
+	virtual void write(int level, const char *text, size_t n) = 0;
+};
+
+
+class stderr_sink : public log_sink {
+public:
+	void write(int level, const char *text, size_t n)
+	{
+		fwrite(text, 1, n, stderr);
+		fflush(stderr);
+	}
+};
+
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
+// Collects text and passes complete lines to sink
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
+class log_buf : public streambuf {
+public:
+	log_buf(log_sink &s, int lvl) : sink(s), default_level(lvl), level(lvl) {}
+	virtual ~log_buf() { sync(); }
+
+	// Level of next record (pending text is written with previous level)
+	void set_level(int lvl)
+	{
+		sync();
+		level = lvl;
+	}
+
+protected:
+	int overflow(int c)
+	{
+		if(c != traits_type::eof())
+		{
+			line += (char) c;
+			if(c == '\n')
+				emit(line.size());
+		}
+		return c;
+	}
+
+	streamsize xsputn(const char *s, streamsize n)
+	{
+		line.append(s, n);
+		if(memchr(s, '\n', n))
+			emit(line.rfind('\n') + 1);
+		return n;
+	}
+
+	int sync()
+	{
+		emit(line.size());
+		return 0;
+	}
+
+private:
+	void emit(size_t n)
+	{
+		if(n)
+		{
+			sink.write(level, line.data(), n);
+			line.erase(0, n);
+		}
+		level = default_level;
+	}
+
+	log_sink &sink;
+	int default_level;
+	int level;
+	string line;
+};
+
+
+class log_stream : public ostream {
+public:
+	log_stream(log_sink &s, int level = LOG_INFO) : ostream(&buf), buf(s, level) {}
+	virtual ~log_stream() { flush(); }
+
+private:
+	log_stream(const log_stream &rhs);
+
+	log_buf buf;
+};
+
+
+inline ostream & set_log_level(ostream &os, int level)
+{
+	log_buf *buf = dynamic_cast<log_buf*>(os.rdbuf());
+	if(buf)
+		buf->set_level(level);
+	return os;
+}
+
+inline ostream & log_error(ostream &os)	{ return set_log_level(os, LOG_ERROR); }
+inline ostream & log_warn(ostream &os)	{ return set_log_level(os, LOG_WARN); }
+inline ostream & log_debug(ostream &os)	{ return set_log_level(os, LOG_DEBUG); }
+
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
+// Multiple producers (write), single consumer (drain).
+// Producers push preformatted records onto a lock-free stack; the
+// consumer takes the whole stack at once and writes it in reverse
+// (= writing) order.
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
+class log_queue : public log_sink {
+public:
+	// Records above max_level are only counted
+	log_queue(int max_level = LOG_INFO) : head(0), max_lvl(max_level), n_dropped(0) {}
+	~log_queue() { release(head.exchange(0)); }
+
+	void write(int level, const char *text, size_t n)
+	{
+		if(level > max_lvl)
+		{
+			n_dropped.fetch_add(1, memory_order_relaxed);
+			return;
+		}
+
+		record *r = new record(level, text, n);
+		r->next = head.load(memory_order_relaxed);
+		while(!head.compare_exchange_weak(r->next, r, memory_order_release, memory_order_relaxed))
+			;
+	}
+
+	// Consuming thread only. Returns number of written records.
+	size_t drain(ostream &os)
+	{
+		if(!head.load(memory_order_relaxed))
+			return 0;
+
+		// Reverse into writing order
+		record *r = head.exchange(0, memory_order_acquire), *list = 0, *next;
+		for(; r; r = next)
+		{
+			next = r->next;
+			r->next = list;
+			list = r;
+		}
+
+		size_t n = 0;
+		for(r = list; r; r = r->next, ++n)
+		{
+			set_log_level(os, r->level);
+			os.write(r->text.data(), r->text.size());
+		}
+		os.flush();
+		release(list);
+		return n;
+	}
+
+	unsigned long dropped() const { return n_dropped.load(memory_order_relaxed); }
+
+private:
+	log_queue(const log_queue &rhs);
+
+	struct record
+	{
+		record(int lvl, const char *s, size_t n) : level(lvl), text(s, n), next(0) {}
+		int level;
+		string text;
+		record *next;
+	};
+
+	static void release(record *r)
+	{
+		record *next;
+		for(; r; r = next)
+		{
+			next = r->next;
+			delete r;
+		}
+	}
+
+	atomic<record*> head;
+	int max_lvl;
+	atomic<unsigned long> n_dropped;
+};
+
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
+// Rate limit for repeated messages: admit() returns true for the first
+// max_count calls, further calls are only counted.
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
+class log_limit {
+public:
+	log_limit(unsigned long n = 10) : max_count(n), count(0) {}
+
+	bool admit() { return count.fetch_add(1, memory_order_relaxed) < max_count; }
+
+	unsigned long suppressed() const
+	{
+		unsigned long n = count.load(memory_order_relaxed);
+		return n > max_count ? n - max_count : 0;
+	}
+
+	void reset() { count.store(0, memory_order_relaxed); }
+
+private:
+	log_limit(const log_limit &rhs);
+
+	unsigned long max_count;
+	atomic<unsigned long> count;
+};
+
+
+} // namespace sqlite
+#endif /* LOG_SINK_H_ */
@@ -0,0 +1,170 @@
+/*
+ * pipeline.cpp
+ *
+ *  Created on: 17.10.2026
+ *      Author: kaisers
+ */
+
+#include "pipeline.h"
+
+namespace sqlite {
+
+
+expand_pipeline::expand_pipeline(const expand_spec &s, const string &source, bool verb,
+		unsigned batch_rows, unsigned n_batches) :
+		spec(s), source_db(source), verbose(verb),
+		full(n_batches + 1), empty(n_batches), abort(false), read_success(false), stats(0)
+{
+	unsigned i;
+	for(i = 0; i < n_batches; ++i)
+	{
+		batches.push_back(new row_batch(spec.n_select_columns(), batch_rows));
+		empty.push(batches.back());
+	}
+}
+
+expand_pipeline::~expand_pipeline()
+{
+	unsigned i;
+	for(i = 0; i < batches.size(); ++i)
+		delete batches[i];
+}
+
+
+void expand_pipeline::read()
+{
+	log_stream os(read_log);
+	sqlite_con con(source_db, os, verbose);
+	row_batch *batch = 0;
+	unsigned i, n_cols = spec.n_select_columns();
+	bool success = false;
+
+	if(con.open())
+	{
+		sqlite_stmt read_stmt(con);
+		if(read_stmt.prepare(spec.select_sql(spec.where_sql())))
+		{
+			bool more = true;
+			while(more && !abort.load(std::memory_order_relaxed))
+			{
+				// Wait for empty batch
+				empty_wait.wait([&]() { return empty.pop(batch) || abort.load(); });
+				if(abort.load())
+					break;
+
+				// Decode rows
+				for(batch->n_rows = 0; batch->n_rows < batch->capacity(); ++batch->n_rows)
+				{
+					if(!read_stmt.fetch())
+					{
+						more = false;
+						break;
+					}
+
+					sqlite_cell *cells = &batch->cells[batch->n_rows * n_cols];
+					for(i = 0; i < n_cols; ++i)
+					{
+						sqlite_cell &c = cells[i];
+						c.type = read_stmt.column_type(i);
+						switch(c.type)
+						{
+							case SQLITE_INTEGER:
+								c.ival = read_stmt.column_int(i);
+								break;
+							case SQLITE_FLOAT:
+								c.dval = read_stmt.column_double(i);
+								break;
+							case SQLITE_NULL:
+								break;
+							case SQLITE_BLOB:
+								c.text.assign((const char*) read_stmt.column_blob(i), read_stmt.column_bytes(i));
+								break;
+							default:
+								c.type = SQLITE_TEXT;
+								c.text.assign(read_stmt.column_text(i), read_stmt.column_bytes(i));
+						}
+					}
+				}
+
+				// An unused batch is not returned (the reader must not
+				// push into empty, end of data follows)
+				if(batch->n_rows)
+				{
+					full_wait.wait([&]() { return full.push(batch); });
+					full_wait.notify();
+				}
+			}
+			success = read_stmt.is_done();
+
+			// Writer only reads counters after join
+			if(stats)
+				stats->read.add(read_stmt);
+			read_stmt.finalize();
+		}
+		con.close();
+	}
+	read_success = success;
+
+	// End of data
+	full_wait.wait([&]() { return full.push(0); });
+	full_wait.notify();
+}
+
+
+long expand_pipeline::run(sqlite_batch_stmt &stmt)
+{
+	expand_data<> ed(&stmt, spec);
+
+	long nRows = 0;
+	bool success = true;
+	row_batch *batch;
+	unsigned i;
+
+	stats = stmt.get_stats();
+	thread reader(&expand_pipeline::read, this);
+
+	for(;;)
+	{
+		full_wait.wait([&]() { return full.pop(batch); });
+		full_wait.notify();
+
+		// Waiting for reader
+		if(stats)
+			stats->lap(PHASE_SCAN);
+
+		// Messages of reader
+		read_log.drain(stmt.getos());
+
+		if(batch == 0)
+			break;
+
+		// After an error, remaining batches are only drained
+		for(i = 0; success && i < batch->n_rows; ++i)
+		{
+			if(!expand_row(batch_row(*batch, i), ed))
+			{
+				success = false;
+				abort.store(true);
+			}
+		}
+		nRows += batch->n_rows;
+		empty.push(batch);
+		empty_wait.notify();
+		if(stats)
+			stats->lap(PHASE_EXPAND);
+	}
+	reader.join();
+
+	ostream &os = stmt.get_con().getos();
+	read_log.drain(os);
+	if(!read_success && !abort.load())
+		os << "[expand_pipeline] Reading from '" << source_db << "' failed!\n";
+
+	if(!success || !read_success || !stmt.flush())
+		return -1;
+
+	return nRows;
+}
+
+
+} // namespace sqlite
@@ -0,0 +1,129 @@
+/*
+ * pipeline.h
+ *
+ *  Created on: 17.10.2026
+ *      Author: kaisers
+ *
+ *  Two stage expansion pipeline:
+ *  A reader thread scans the read table (through a separate connection)
+ *  and decodes source rows into fixed size row batches.
+ *  The calling thread (writer) expands the decoded rows and steps the
+ *  INSERT statements.
+ *  Batches are passed through lock-free single producer/single consumer
+ *  queues, so scanning and B-tree writes overlap. Empty batches are
+ *  returned to the reader, so no memory is allocated while running.
+ *  A side which waits for the other side sleeps after a short spin
+ *  (see spsc_waiter).
+ *
+ *  The reader connection either opens a separate source database
+ *  (which may be ATTACHed elsewhere) or the write database itself.
+ *  In the latter case, the write database must be in WAL mode
+ *  so that the reader is not blocked by the writer.
+ */
+
+#ifndef PIPELINE_H_
+#define PIPELINE_H_
+
+#include "expander.h"
+#include "spsc_queue.h"
+
+#include <atomic>
+#include <thread>
+#include <cstdlib>
+
+namespace sqlite {
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
+// Decoded source rows
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
+struct row_batch
+{
+	row_batch(unsigned ncols, unsigned nrows) : n_cols(ncols), n_rows(0), cells(ncols * nrows) {}
+
+	unsigned capacity() const { return cells.size() / n_cols; }
+
+	unsigned n_cols;
+	unsigned n_rows;
+	vector<sqlite_cell> cells;
+};
+
+
+// Row view with the same interface as sqlite_row (used by expand_row).
+// Conversions follow the SQLite rules for sqlite3_column_*.
+class batch_row {
+public:
+	batch_row(const row_batch &b, unsigned r) : cells(&b.cells[r * b.n_cols]) {}
+
+	int type(int col) const { return cells[col].type; }
+	bool is_null(int col) const { return cells[col].type == SQLITE_NULL; }
+
+	sqlite3_int64 get_int(int col) const
+	{
+		const sqlite_cell &c = cells[col];
+		switch(c.type)
+		{
+			case SQLITE_INTEGER:	return c.ival;
+			case SQLITE_FLOAT:		return (sqlite3_int64) c.dval;
+			case SQLITE_TEXT:		return atoll(c.text.c_str());
+			default:				return 0;
+		}
+	}
+
+	double get_double(int col) const
+	{
+		const sqlite_cell &c = cells[col];
+		switch(c.type)
+		{
+			case SQLITE_INTEGER:	return (double) c.ival;
+			case SQLITE_FLOAT:		return c.dval;
+			case SQLITE_TEXT:		return strtod(c.text.c_str(), NULL);
+			default:				return 0;
+		}
+	}
+
+	const char * get_text(int col) const { return cells[col].text.c_str(); }
+	const void * get_blob(int col) const { return cells[col].text.data(); }
+	int get_bytes(int col) const { return (int) cells[col].text.size(); }
+
+private:
+	const sqlite_cell *cells;
+};
+
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
+// Reader/writer pipeline
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
+class expand_pipeline {
+public:
+	expand_pipeline(const expand_spec &s, const string &source, bool verb,
+			unsigned batch_rows = 1024, unsigned n_batches = 8);
+	~expand_pipeline();
+
+	// Expands all source rows into stmt (writer runs in calling thread).
+	// Returns number of source rows or -1 on error.
+	long run(sqlite_batch_stmt &stmt);
+
+private:
+	expand_pipeline(const expand_pipeline &rhs);
+
+	void read();
+
+	const expand_spec &spec;
+	string source_db;
+	bool verbose;
+
+	vector<row_batch*> batches;
+	spsc_queue<row_batch*> full;	// reader -> writer (0 = end of data)
+	spsc_queue<row_batch*> empty;	// writer -> reader
+	spsc_waiter full_wait;			// Notified on push to and pop from full
+	spsc_waiter empty_wait;			// Notified on push to and pop from empty
+	atomic<bool> abort;
+
+	bool read_success;
+	log_queue read_log;				// Reader must not write to R console
+	expand_stats *stats;			// Instrumentation of writer (see sqlite_batch_stmt)
+};
+
+
+} // namespace sqlite
+#endif /* PIPELINE_H_ */
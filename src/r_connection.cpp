@@ -0,0 +1,53 @@
+/*
+ * r_connection.cpp
+ *
+ *  Created on: 17.10.2026
+ *      Author: kaisers
+ */
+
+#include "r_connection.h"
+
+namespace sqlite {
+
+
+void r_connection_finalizer(SEXP pCon)
+{
+	r_connection *rc = (r_connection*) R_ExternalPtrAddr(pCon);
+	if(rc)
+	{
+		delete rc;
+		R_ClearExternalPtr(pCon);
+	}
+}
+
+bool is_r_connection(SEXP pCon)
+{
+	return TYPEOF(pCon) == EXTPTRSXP && inherits(pCon, r_connection_class);
+}
+
+r_connection * get_r_connection(SEXP pCon)
+{
+	if(!is_r_connection(pCon))
+		return 0;
+	return (r_connection*) R_ExternalPtrAddr(pCon);
+}
+
+SEXP new_r_connection(const string &db_file, int verbose)
+{
+	r_connection *rc = new r_connection(db_file, verbose);
+	if(!rc->con.open())
+	{
+		delete rc;
+		error("[sqliteToolsConnect] Could not open SQLite database '%s'.", db_file.c_str());
+	}
+
+	SEXP pCon = PROTECT(R_MakeExternalPtr(rc, R_NilValue, R_NilValue));
+	R_RegisterCFinalizerEx(pCon, r_connection_finalizer, TRUE);
+	setAttrib(pCon, R_ClassSymbol, mkString(r_connection_class));
+	setAttrib(pCon, install("dbfile"), mkString(db_file.c_str()));
+	UNPROTECT(1);
+	return pCon;
+}
+
+
+} // namespace sqlite
@@ -0,0 +1,131 @@
+/*
+ * r_connection.h
+ *
+ *  Created on: 17.10.2026
+ *      Author: kaisers
+ *
+ *  Persistent database connections for R:
+ *  A sqlite_con is wrapped into an external pointer (class
+ *  'sqliteToolsConnection'), which is closed by a finalizer.
+ *  Native functions accept it instead of a database file name, so
+ *  page cache, parsed schema and cached statements are kept across calls.
+ *
+ *  call_connection is the connection of one .Call: Either borrowed from
+ *  the external pointer or opened (and closed) for this call.
+ *  When a call fails, close_on_error() is called before R error() is
+ *  raised: An open transaction is rolled back, a persistent connection
+ *  stays open for the next call.
+ *  PRAGMAs which are changed during a call are restored at the end of
+ *  the call (see sqlite_con::restore_pragmas).
+ *
+ *  Only to be used from the main thread.
+ */
+
+#ifndef R_CONNECTION_H_
+#define R_CONNECTION_H_
+
+#include "sqlite_con.h"
+#include "rostream.h"
+
+#include <string>
+
+#include <R.h>
+#include <Rinternals.h>
+
+using namespace std;
+
+namespace sqlite {
+
+struct r_connection
+{
+	r_connection(const string &db_file, int verbose) : con(db_file, ros, verbose) {}
+
+	rostream ros;		// Must be constructed before con
+	sqlite_con con;
+};
+
+const char * const r_connection_class = "sqliteToolsConnection";
+
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
+// External pointer
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
+
+// Resets sync and journal mode and closes database
+void r_connection_finalizer(SEXP pCon);
+
+bool is_r_connection(SEXP pCon);
+
+// Returns 0 when pCon is no open connection handle
+r_connection * get_r_connection(SEXP pCon);
+
+SEXP new_r_connection(const string &db_file, int verbose);
+
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
+// Connection of one .Call
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
+class call_connection {
+public:
+	// pCon: Connection handle (R_NilValue: db_file is opened)
+	call_connection(SEXP pCon, const string &db_file, int verbose) :
+		local(db_file, ros, verbose), shared(get_r_connection(pCon)), mark(0)
+	{
+		if(pCon != R_NilValue && !shared)
+			error("Invalid or closed sqliteToolsConnection!");
+	}
+
+	// pDb: Database file name or connection handle
+	call_connection(SEXP pDb, int verbose) :
+		local(is_r_connection(pDb) ? string() : string(CHAR(STRING_ELT(pDb, 0))), ros, verbose),
+		shared(get_r_connection(pDb)), mark(0)
+	{
+		if(is_r_connection(pDb) && !shared)
+			error("Invalid or closed sqliteToolsConnection!");
+	}
+
+	sqlite_con & get() { return shared ? shared->con : local; }
+	bool persistent() const { return shared != 0; }
+
+	// Persistent connections are only opened when closed
+	bool open()
+	{
+		sqlite_con &con = get();
+		if(!(shared && con) && !con.open())
+			return false;
+		mark = con.pragma_mark();
+		return true;
+	}
+
+	// Persistent connections stay open: PRAGMAs changed during
+	// this call are restored and log is printed
+	bool close()
+	{
+		if(shared)
+		{
+			bool success = shared->con.restore_pragmas(mark);
+			shared->con.getos().flush();
+			return success;
+		}
+		return local.close();
+	}
+
+	// Failed call: Rolls back open transaction before close()
+	bool close_on_error()
+	{
+		get().rollback();
+		return close();
+	}
+
+private:
+	call_connection(const call_connection &rhs);
+
+	rostream ros;
+	sqlite_con local;
+	r_connection *shared;
+	size_t mark;		// PRAGMAs changed before this call
+};
+
+
+} // namespace sqlite
+#endif /* R_CONNECTION_H_ */
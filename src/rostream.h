@@ -6,36 +6,29 @@
  *
  *  Created on: 25.05.2011
  *      Author: wolfgang
+ *
+ *  Output stream to R console (log_sink implementation, see log_sink.h).
+ *  Only to be used from the main thread (other threads write into a
+ *  log_queue which is drained by the main thread).
  */
 
-#include <Rinternals.h>
-#include <string>
-#include <sstream>
+#include "log_sink.h"
+
+#include <R.h>
+
 using namespace std;
 
-template<typename charT,typename traits=char_traits<charT> >
-class rbuf: public basic_stringbuf<charT,traits>
+class r_sink: public sqlite::log_sink
 {
 public:
-	rbuf() {}
-	virtual ~rbuf() { sync(); }
-protected:
-	int sync()
-	{
-		Rprintf("%s",this->str().c_str());
-		this->str(basic_string<charT>());	// clear string buffer
-		return 0;
-	}
+	void write(int level, const char *text, size_t n) { Rprintf("%.*s", (int) n, text); }
 };
 
-template<typename charT,typename traits=char_traits<charT> >
-class basic_rostream: public basic_ostream<charT,traits>
+// Sink is constructed before stream
+class rostream: private r_sink, public sqlite::log_stream
 {
 public:
-	basic_rostream():basic_ostream<charT,traits>(new rbuf<charT,traits>()) {}
-	virtual ~basic_rostream(){ delete this->rdbuf(); }
+	rostream(): sqlite::log_stream(static_cast<r_sink&>(*this)) {}
 };
 
-typedef basic_rostream<char> rostream;
-
 #endif /* ROSTREAM_H_ */
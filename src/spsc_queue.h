@@ -0,0 +1,129 @@
+/*
+ * spsc_queue.h
+ *
+ *  Created on: 17.10.2026
+ *      Author: kaisers
+ *
+ *  Bounded lock-free queue for exactly one producer thread
+ *  and one consumer thread (ring buffer).
+ *  push() and pop() never block: They return false when the
+ *  queue is full (empty respectively).
+ *
+ *  spsc_waiter: Waiting for a queue (e.g. until pop() succeeds).
+ *  The waiting side spins a bounded number of times and then sleeps on
+ *  a condition variable, so a side which is blocked in I/O does not keep
+ *  the other side busy. The other side calls notify() after push() or
+ *  pop(); the mutex is only locked when a thread sleeps.
+ */
+
+#ifndef SPSC_QUEUE_H_
+#define SPSC_QUEUE_H_
+
+#include <atomic>
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <thread>
+#include <cstddef>
+
+namespace sqlite {
+
+template<typename T>
+class spsc_queue {
+public:
+	// Capacity is rounded up to next power of two
+	spsc_queue(size_t capacity) : head(0), tail(0)
+	{
+		size_t n = 1;
+		while(n < capacity)
+			n <<= 1;
+		buf.resize(n);
+		mask = n - 1;
+	}
+
+	size_t capacity() const { return buf.size(); }
+
+	// Producer
+	bool push(const T &item)
+	{
+		size_t t = tail.load(std::memory_order_relaxed);
+		if(t - head.load(std::memory_order_acquire) == buf.size())
+			return false;
+
+		buf[t & mask] = item;
+		tail.store(t + 1, std::memory_order_release);
+		return true;
+	}
+
+	// Consumer
+	bool pop(T &item)
+	{
+		size_t h = head.load(std::memory_order_relaxed);
+		if(h == tail.load(std::memory_order_acquire))
+			return false;
+
+		item = buf[h & mask];
+		head.store(h + 1, std::memory_order_release);
+		return true;
+	}
+
+private:
+	spsc_queue(const spsc_queue &rhs);
+
+	std::vector<T> buf;
+	size_t mask;
+
+	// Separate cache lines for consumer and producer position
+	alignas(64) std::atomic<size_t> head;
+	alignas(64) std::atomic<size_t> tail;
+};
+
+
+class spsc_waiter {
+public:
+	spsc_waiter() : n_sleeping(0) {}
+
+	// Returns when ready() returns true (ready may pop or push)
+	template<typename Pred>
+	void wait(Pred ready)
+	{
+		int i;
+		for(i = 0; i < spin_limit; ++i)
+		{
+			if(ready())
+				return;
+			std::this_thread::yield();
+		}
+
+		std::unique_lock<std::mutex> lock(mtx);
+		n_sleeping.fetch_add(1);
+		// Timeout: Backstop, notify() wakes the sleeping thread
+		while(!ready())
+			cv.wait_for(lock, std::chrono::milliseconds(10));
+		n_sleeping.fetch_sub(1);
+	}
+
+	// Called after push() or pop() (or when waiting shall be cancelled)
+	void notify()
+	{
+		// Orders the queue update before reading n_sleeping
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if(n_sleeping.load() == 0)
+			return;
+		std::lock_guard<std::mutex> lock(mtx);
+		cv.notify_all();
+	}
+
+private:
+	spsc_waiter(const spsc_waiter &rhs);
+
+	static const int spin_limit = 64;
+
+	std::mutex mtx;
+	std::condition_variable cv;
+	std::atomic<int> n_sleeping;
+};
+
+} // namespace sqlite
+#endif /* SPSC_QUEUE_H_ */
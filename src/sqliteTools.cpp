@@ -9,184 +9,214 @@
 
 extern "C"{
 
-struct callback_data
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
+// Expansion into data.frame (no output table).
+// Columns are preallocated from the number of created rows (span_sql).
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
+SEXP expand_to_frame(call_connection &cc, const expand_spec &spec, bool verbose)
 {
-	sqlite_stmt * stmt;
-	unsigned int expand_start;	// = 3 + n_copy_columns
-	unsigned int expand_end;	// = expand_start + n_expand - 1
-};
-
-
-int expand_callback(void *ptr, int nrows, char **column_value, char **column_name)
-{
-	callback_data *cd = (callback_data*) ptr;
-	sqlite_stmt * stmt = cd->stmt;
-	unsigned int i, n_expand;
-	int index, lo_bound, hi_bound;
+	sqlite_con &con = cc.get();
+	sqlite3_int64 n_total = -1;
+	sqlite_stmt span_stmt(con);
+	if(span_stmt.prepare(spec.span_sql()) && span_stmt.fetch())
+	{
+		n_total = span_stmt.column_int(0);
+		span_stmt.reset();
+	}
+	span_stmt.finalize();
 
-	ostream & os = stmt->get_con().getos();
+	if(n_total < 0)
+	{
+		cc.close_on_error();
+		error("[expand_table] Cannot count rows of expanded table!");
+	}
 
-	// SELECT id, min_woche, max_woche, cpy1, cpy2, exp1, exp2 FROM tbl;
-	lo_bound = atoi(column_value[1]);
-	hi_bound = atoi(column_value[2]);
-	n_expand = hi_bound - lo_bound + 1;
+	if(n_total > INT_MAX)
+	{
+		cc.close_on_error();
+		error("[expand_table] Expanded table has too many rows (%lld) for data.frame!", (long long) n_total);
+	}
 
-	// INSERT INTO rtbl (id, rid, woche, cpy1, cpy2, exp1, exp2) VALUES (?, ?, ?, ?, ?, ?, ?)
-	// 0: auto_id
-	stmt->bind_int(1, stmt->getAutoId());		// id
-	stmt->bind_int(2, atoi(column_value[0]));	// rid
+	if(verbose)
+		Rprintf("[expand_table] Allocating data.frame with %lld rows.\n", (long long) n_total);
 
-	// Bind values for copied columns
-	for(i = 3; i < cd->expand_start; ++i)
-		stmt->bind_text(i + 1, column_value[i]);
+	SEXP pDf = PROTECT(frame_sink::alloc_frame(spec, (R_xlen_t) n_total));
+	frame_sink sink(pDf, con.getos());
 
-	// Bind values for expanded columns
-	for(i = cd->expand_start; i <= cd->expand_end; ++i)
-		stmt->bind_double(i + 1, strtod(column_value[i], NULL) / n_expand);
+	long nRows = -1;
+	sqlite_stmt read_stmt(con);
+	if(read_stmt.prepare(spec.select_sql(spec.where_sql())))
+		nRows = expand_rows(read_stmt, sink, spec);
+	read_stmt.finalize();
 
-	for(index = lo_bound; index <= hi_bound; ++index)
+	if(nRows < 0 || sink.size() != n_total)
 	{
-		stmt->bind_int(1, stmt->getAutoId());
-		stmt->bind_int(3, index);
-		if(!stmt->step())
-			os << "[expand_table.expand_callback] Step error!";
+		UNPROTECT(1);
+		cc.close_on_error();
+		error("[expand_table] Expansion of table '%s' into data.frame failed!", spec.read_table.c_str());
 	}
-	return 0;
+
+	if(verbose)
+		Rprintf("[expand_table] Expanded %ld rows into %lu rows.\n", nRows, sink.lastAutoId());
+
+	UNPROTECT(1);
+	return pDf;
 }
 
 
-void create_output_table(sqlite_con &con,
-					string &write_table,
-					string &index_column,
-					list<string> &copyCols,
-					list<string> &copyColTypes,
-					list<string> &expandCols,
-					bool verbose)
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
+// Instrumentation (option instrument) as named list of named numeric
+// vectors: time, rows, select, insert, cache (see expand_stats.h)
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
+SEXP named_real(const char * const *names, const double *values, int n)
 {
-
-	stringstream sql;
-	list<string>::const_iterator iter, iter1, iter2;
-	// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
-	// Drop target table (if exists)
-	// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
-	if(con.drop_table(write_table))
-	{
-		if(verbose)
-			Rprintf("[expand_table] Drop table success.\n");
-	}
-	else
+	SEXP pVal = PROTECT(allocVector(REALSXP, n));
+	SEXP pNames = PROTECT(allocVector(STRSXP, n));
+	int i;
+	for(i = 0; i < n; ++i)
 	{
-		con.close();
-		error("Drop table error!");
+		REAL(pVal)[i] = values[i];
+		SET_STRING_ELT(pNames, i, mkChar(names[i]));
 	}
+	setAttrib(pVal, R_NamesSymbol, pNames);
+	UNPROTECT(2);
+	return pVal;
+}
 
+SEXP stmt_counters_to_real(const stmt_counters &c)
+{
+	static const char * const names[] = { "vm_steps", "sorts", "fullscan_steps", "autoindex" };
+	double values[] = { (double) c.vm_steps, (double) c.sorts, (double) c.fullscan_steps, (double) c.autoindex };
+	return named_real(names, values, 4);
+}
 
-	// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
-	// Create target table
-	// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
-	const char * delim = ", ";
-
-	// - - - - - - - - - - - - - - - - - - - - - - - - - //
-	// SQL string for creation of output table
-	// - - - - - - - - - - - - - - - - - - - - - - - - - //
-	sql << "CREATE TABLE IF NOT EXISTS "	<< write_table << " (";
-	sql << "id INTEGER "					<< delim;
-	sql << "rid INTEGER"					<< delim;
-
-	// Index column
-	sql << index_column << " TEXT"			<< delim;
-
-	// Names and types for columns which are copied
-	iter1 = copyCols.begin();
-	iter2 = copyColTypes.begin();
-
-	for(; iter1!=copyCols.end(); ++iter1, ++iter2)
-		sql << *iter1 << " " << *iter2 		<< delim;
+SEXP stats_to_list(const expand_stats &stats)
+{
+	const char *time_names[N_EXPAND_PHASES + 1];
+	double time_values[N_EXPAND_PHASES + 1];
+	int i;
+	for(i = 0; i < N_EXPAND_PHASES; ++i)
+	{
+		time_names[i] = expand_stats::phase_name(i);
+		time_values[i] = stats.phase_time[i];
+	}
+	time_names[N_EXPAND_PHASES] = "total";
+	time_values[N_EXPAND_PHASES] = stats.total;
+
+	static const char * const row_names[] = { "source", "expanded", "steps", "bytes_bound" };
+	double row_values[] = { (double) stats.source_rows, (double) stats.expanded_rows,
+			(double) stats.steps, (double) stats.bytes_bound };
+
+	static const char * const cache_names[] = { "hit", "miss", "write", "spill" };
+	double cache_values[] = { (double) stats.cache_hit, (double) stats.cache_miss,
+			(double) stats.cache_write, (double) stats.cache_spill };
+
+	static const char * const list_names[] = { "time", "rows", "select", "insert", "cache" };
+	SEXP pList = PROTECT(allocVector(VECSXP, 5));
+	SET_VECTOR_ELT(pList, 0, named_real(time_names, time_values, N_EXPAND_PHASES + 1));
+	SET_VECTOR_ELT(pList, 1, named_real(row_names, row_values, 4));
+	SET_VECTOR_ELT(pList, 2, stmt_counters_to_real(stats.read));
+	SET_VECTOR_ELT(pList, 3, stmt_counters_to_real(stats.insert));
+	SET_VECTOR_ELT(pList, 4, named_real(cache_names, cache_values, 4));
+
+	SEXP pNames = PROTECT(allocVector(STRSXP, 5));
+	for(i = 0; i < 5; ++i)
+		SET_STRING_ELT(pNames, i, mkChar(list_names[i]));
+	setAttrib(pList, R_NamesSymbol, pNames);
+	UNPROTECT(2);
+	return pList;
+}
 
-	// Names for columns which are expanded
-	for(iter1 = expandCols.begin(); iter1 != expandCols.end(); ++iter1)
-		sql << *iter1 << " REAL"			<< delim;
 
-	sql << "PRIMARY KEY(id));";
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
+// Access to named list of options.
+// Returns default value when option is not present.
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
+SEXP get_option(SEXP pOptions, const char *name)
+{
+	SEXP pNames = getAttrib(pOptions, R_NamesSymbol);
+	int i, n = length(pOptions);
 
-	// Print debug message
-	if(verbose)
-		Rprintf("[expand_table] SQL: '%s'\n", sql.str().c_str());
+	if(TYPEOF(pNames) != STRSXP)
+		return R_NilValue;
 
-	if(con.create_table(sql.str()))
+	for(i = 0; i < n; ++i)
 	{
-		if(verbose)
-			Rprintf("[expand_table] Create table success.\n");
+		if(strcmp(CHAR(STRING_ELT(pNames, i)), name) == 0)
+			return VECTOR_ELT(pOptions, i);
 	}
-	else
-	{
-		con.close();
-		error("[expand_table] Create table error!");
-	}
-	return;
+	return R_NilValue;
 }
 
-
-void prepare_insert_statement(sqlite_stmt &stmt,
-			string &read_table,
-			string &write_table,
-			string &index_column,
-			list<string> &copyCols,
-			list<string> expandCols,
-			string &lo_bound_col,
-			string &up_bound_col,
-			bool verbose)
+int get_int_option(SEXP pOptions, const char *name, int def)
 {
-	stringstream sql;
-	unsigned int nCopyCols = copyCols.size();
-	unsigned int nExpandCols = expandCols.size();
-	unsigned int i;
-	list<string>::const_iterator iter;
+	SEXP pVal = get_option(pOptions, name);
+	if(length(pVal) == 0)
+		return def;
 
-	// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
-	// Prepare INSERT statement
-	// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
+	if(TYPEOF(pVal) == INTSXP || TYPEOF(pVal) == LGLSXP)
+		return INTEGER(pVal)[0];
 
-	sql << "INSERT INTO " << write_table << " (id, rid, ";
+	if(TYPEOF(pVal) == REALSXP)
+		return (int) REAL(pVal)[0];
 
-	sql << index_column;
+	error("Option '%s' must be numeric!", name);
+	return def;
+}
 
-	// Copied columns
-	for(iter = copyCols.begin(); iter != copyCols.end(); ++iter)
-		sql << ", " << *iter ;
+string get_string_option(SEXP pOptions, const char *name, const string &def)
+{
+	SEXP pVal = get_option(pOptions, name);
+	if(length(pVal) == 0)
+		return def;
 
-	// Expanded columns
-	for(iter = expandCols.begin(); iter != expandCols.end(); ++iter)
-		sql << ", " << *iter;
+	if(TYPEOF(pVal) != STRSXP)
+		error("Option '%s' must be character!", name);
 
-	sql << ") VALUES (?, ?, ?"; // id, rid, index_column
+	return string(CHAR(STRING_ELT(pVal, 0)));
+}
 
-	for(i = 0; i < nCopyCols; ++i)
-		sql << ", ?";
+vector<string> get_string_vector_option(SEXP pOptions, const char *name)
+{
+	SEXP pVal = get_option(pOptions, name);
+	vector<string> res;
 
-	for(i = 0; i < nExpandCols; ++i)
-		sql << ", ?";
+	if(length(pVal) == 0)
+		return res;
 
-	sql << ");";
+	if(TYPEOF(pVal) != STRSXP)
+		error("Option '%s' must be character!", name);
 
-	// Print debug message
-	if(verbose)
-		Rprintf("[expand_table] SQL: '%s'\n", sql.str().c_str());
+	int i, n = length(pVal);
+	for(i = 0; i < n; ++i)
+		res.push_back(string(CHAR(STRING_ELT(pVal, i))));
+	return res;
+}
 
 
-	if(!stmt.prepare(sql.str()))
-	{
-		stmt.get_con().close();
-		error("[expand_table] Prepare statement error!");
-	}
 
-	return;
+// PRAGMA profile (option 'pragmaProfile') extended by named character
+// vector of PRAGMAs (option 'pragmas'). Returns false for unknown profile.
+bool get_pragma_options(SEXP pOptions, sqlite_con::pragma_list &pragmas)
+{
+	if(!sqlite_con::get_pragma_profile(get_string_option(pOptions, "pragmaProfile", "default"), pragmas))
+		return false;
 
-}
+	SEXP pVal = get_option(pOptions, "pragmas");
+	if(pVal == R_NilValue)
+		return true;
 
+	SEXP pNames = getAttrib(pVal, R_NamesSymbol);
+	if(TYPEOF(pVal) != STRSXP || TYPEOF(pNames) != STRSXP)
+		error("Option 'pragmas' must be named character!");
 
+	int i, n = length(pVal);
+	for(i = 0; i < n; ++i)
+		pragmas.push_back(make_pair(string(CHAR(STRING_ELT(pNames, i))), string(CHAR(STRING_ELT(pVal, i)))));
+	return true;
+}
 
-SEXP expand_table(SEXP pParams, SEXP pCopyCol, SEXP pCopyColTypes,  SEXP pExpCol, SEXP pVerbose)
+SEXP expand_table(SEXP pParams, SEXP pCopyCol, SEXP pCopyColTypes,  SEXP pExpCol, SEXP pVerbose, SEXP pOptions)
 {
 	if(TYPEOF(pParams) != STRSXP)
 		error("pParams must be character!");
@@ -206,14 +236,15 @@ SEXP expand_table(SEXP pParams, SEXP pCopyCol, SEXP pCopyColTypes,  SEXP pExpCol
 	if(TYPEOF(pVerbose) != INTSXP)
 		error("pVerbose must be integer!");
 
+	if(TYPEOF(pOptions) != VECSXP)
+		error("pOptions must be a list!");
+
 
 	if(length(pCopyCol) != length(pCopyColTypes))
 		error("pCopyCol and pCopyColTypes must have equal length!");
 
 
 	int i, nCopyCols, nExpandCols;
-	stringstream sql;
-	list<string>::const_iterator iter, iter1, iter2;
 
 	nCopyCols = length(pCopyCol);
 	nExpandCols = length(pExpCol);
@@ -236,34 +267,109 @@ SEXP expand_table(SEXP pParams, SEXP pCopyCol, SEXP pCopyColTypes,  SEXP pExpCol
 	//								from lower bound to upper bound
 	// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
 
+	expand_spec spec;
 	string db_file		= string(CHAR(STRING_ELT(pParams, 0)));
-	string read_table	= string(CHAR(STRING_ELT(pParams, 1)));
-	string write_table	= string(CHAR(STRING_ELT(pParams, 2)));
-	string lo_bound_col	= string(CHAR(STRING_ELT(pParams, 3)));
-	string up_bound_col	= string(CHAR(STRING_ELT(pParams, 4)));
-	string index_column	= string(CHAR(STRING_ELT(pParams, 5)));
+	spec.read_table		= string(CHAR(STRING_ELT(pParams, 1)));
+	spec.write_table	= string(CHAR(STRING_ELT(pParams, 2)));
+	spec.lo_bound_col	= string(CHAR(STRING_ELT(pParams, 3)));
+	spec.up_bound_col	= string(CHAR(STRING_ELT(pParams, 4)));
+	spec.index_column	= string(CHAR(STRING_ELT(pParams, 5)));
 
 	// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
 	// Table columns which will be copied
 	// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
-	list<string> copyCols;
 	for(i=0; i < nCopyCols; ++i)
-		copyCols.push_back(string(CHAR(STRING_ELT(pCopyCol, i))));
+		spec.copyCols.push_back(string(CHAR(STRING_ELT(pCopyCol, i))));
 
-	list<string> copyColTypes;
 	for(i=0; i < nCopyCols; ++i)
-		copyColTypes.push_back(string(CHAR(STRING_ELT(pCopyColTypes, i))));
+		spec.copyColTypes.push_back(string(CHAR(STRING_ELT(pCopyColTypes, i))));
 
 	// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
 	// Table columns which will be expanded
 	// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
-	list<string> expandCols;
 	for(i=0; i < nExpandCols; ++i)
-		expandCols.push_back(string(CHAR(STRING_ELT(pExpCol, i))));
+		spec.expandCols.push_back(string(CHAR(STRING_ELT(pExpCol, i))));
 
 	// Controls verbosity of printed messages
 	bool verbose = (bool) INTEGER(pVerbose)[0];
 
+	// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
+	// Options (named list):
+	// batchSize	: Number of rows per INSERT statement (0 = default, 64)
+	// threads		: Number of threads (0 = number of cores)
+	// pipeline		: Separate reader thread for scanning the read table
+	// sourceDb		: Database file which contains the read table
+	//				  (pipeline only, default: db_file)
+	// incremental	: Only expand source rows above recorded watermark
+	//				  and append them to the write table
+	// commitRows	: Commit (and write checkpoint) every n source rows
+	//				  (0 = single transaction, serial expansion only)
+	// bulkSchema	: Output table with INTEGER PRIMARY KEY (rowid alias)
+	//				  and integer index column
+	// indexCols	: Columns of write table which are indexed after loading
+	// analyze		: Run ANALYZE on write table after loading
+	// refCol		: Reference column. Index values are restricted to
+	//				  [refCol - window, refCol + window]
+	// window		: Window size around reference column (>= 0)
+	// relIndex		: Write index - refCol into index column
+	// distribution: Shares of expanded columns: "even" (default), "days",
+	//				  "weights", "first" or "last" (see distribution.h)
+	// dayCols		: Start and end day columns (distribution = "days")
+	// weightTable	: Table with columns (index, weight) (distribution = "weights")
+	// output		: "table" (default), "frame" (returns data.frame),
+	//				  "binary" or "csv" (writes file, see column_file.h).
+	//				  Output other than "table" requires serial expansion
+	// file			: Name of output file ("binary" and "csv")
+	// pragmaProfile: PRAGMAs for this call: "default" (synchronous=OFF),
+	//				  "bulk", "bulk_wal" or "none" (see sqlite_con.h).
+	//				  Previous values are restored at the end of the call
+	// pragmas		: Additional PRAGMAs (named character)
+	// instrument	: Return time per phase and counters as list
+	//				  (see expand_stats.h, not for output = "frame")
+	// engine		: "auto" (default), "callback" or "sql" (see expand_engine.h)
+	// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
+	expand_options opt;
+	opt.verbose = verbose;
+	opt.batch_size = get_int_option(pOptions, "batchSize", 0);
+	opt.n_threads = get_int_option(pOptions, "threads", 1);
+	opt.pipeline = (bool) get_int_option(pOptions, "pipeline", 0);
+	opt.source_db = get_string_option(pOptions, "sourceDb", "");
+	opt.incremental = (bool) get_int_option(pOptions, "incremental", 0);
+	opt.commit_rows = get_int_option(pOptions, "commitRows", 0);
+	opt.index_cols = get_string_vector_option(pOptions, "indexCols");
+	opt.analyze = (bool) get_int_option(pOptions, "analyze", 0);
+	opt.output = get_string_option(pOptions, "output", "table");
+	opt.file = get_string_option(pOptions, "file", "");
+	opt.weight_table = get_string_option(pOptions, "weightTable", "");
+	opt.instrument = (bool) get_int_option(pOptions, "instrument", 0);
+	opt.engine = engine_from_name(get_string_option(pOptions, "engine", "auto"));
+
+	spec.bulk_schema = (bool) get_int_option(pOptions, "bulkSchema", 0);
+	spec.ref_col = get_string_option(pOptions, "refCol", "");
+	int window = get_int_option(pOptions, "window", 0);
+	spec.window_lo = -window;
+	spec.window_hi = window;
+	spec.rel_index = (bool) get_int_option(pOptions, "relIndex", 0);
+
+	string dist_name = get_string_option(pOptions, "distribution", "even");
+	spec.dist.kernel = dist_kernel_from_name(dist_name);
+	if(spec.dist.kernel < 0)
+		error("Unknown distribution '%s'!", dist_name.c_str());
+
+	vector<string> day_cols = get_string_vector_option(pOptions, "dayCols");
+	if(spec.dist.kernel == DIST_DAYS && day_cols.size() == 2)
+	{
+		spec.dist.start_day_col = day_cols[0];
+		spec.dist.end_day_col = day_cols[1];
+	}
+
+	if(!get_pragma_options(pOptions, opt.pragmas))
+		error("Unknown pragmaProfile '%s'!", get_string_option(pOptions, "pragmaProfile", "").c_str());
+
+	string msg;
+	if(!expand_job::check(spec, opt, msg))
+		error("%s", msg.c_str());
+
 
 	// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
 	// Open connection to database
@@ -272,91 +378,860 @@ SEXP expand_table(SEXP pParams, SEXP pCopyCol, SEXP pCopyColTypes,  SEXP pExpCol
 	if(verbose)
 		Rprintf("[expand_table] Opening Database\n");
 
-	rostream ros;
-	sqlite_con con(db_file, ros, verbose);
+	// Connection handle (sqliteToolsConnect) or database file
+	call_connection cc(get_option(pOptions, "connection"), db_file, verbose);
+	sqlite_con &con = cc.get();
 
-	if(!con.open())
-		error("[expand_table] Could not open SQLite database '", db_file.c_str() , "'.\n");
+	if(!cc.open())
+		error("[expand_table] Could not open SQLite database '%s'.", db_file.c_str());
 
-	if(!con.set_sync(sqlite_con::SYNC_OFF))
+	// Weights and PRAGMAs (restored by cc.close())
+	expand_job job(con, spec, opt);
+	if(!job.prepare())
 	{
-		con.close();
-		error("[expand_table] Cannot set database to asynchronous state!");
+		cc.close_on_error();
+		error("%s", job.last_error().c_str());
 	}
 
-	sqlite_stmt stmt(con);
+	// No output table: Rows are returned as data.frame
+	if(opt.output == "frame")
+	{
+		SEXP pDf = PROTECT(expand_to_frame(cc, spec, verbose));
+		if(!cc.close())
+		{
+			UNPROTECT(1);
+			error("Database closing error!");
+		}
+		UNPROTECT(1);
+		return pDf;
+	}
 
-	create_output_table(con, write_table, index_column,
-						copyCols, copyColTypes, expandCols,
-						verbose);
+	// Output table or file (see expand_job.h)
+	if(!job.run())
+	{
+		cc.close_on_error();
+		error("%s", job.last_error().c_str());
+	}
 
+	// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
+	// Close database connection.
+	// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
+	if(verbose && !cc.persistent())
+		con.getos() << "[expand_table] Closing database.\n";
 
-	prepare_insert_statement(stmt, read_table, write_table,
-						index_column, copyCols, expandCols,
-						lo_bound_col, up_bound_col,
-						verbose);
+	// Restores PRAGMAs (persistent connections stay open)
+	if(cc.close())
+	{
+		if(verbose)
+			Rprintf("[expand_table] Finished.\n");
+	}
+	else
+		error("Database closing error!");
 
+	if(opt.instrument)
+		return stats_to_list(job.get_stats());
+	return R_NilValue;
+}
 
-	// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
-	// Create SELECT query
-	// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
-	sql.str("");
-	sql.clear();
 
-	sql << "SELECT id, " << lo_bound_col << ", " << up_bound_col;
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
+// Converts decimal comma text values ('13,21') of columns into REAL
+// (see convert_num.h).
+// Returns number of converted rows per column.
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
+SEXP convert_to_num(SEXP pDb, SEXP pTable, SEXP pColumns, SEXP pChunkRows, SEXP pRebuild, SEXP pVerbose)
+{
+	if(!is_r_connection(pDb) && (TYPEOF(pDb) != STRSXP || length(pDb) != 1))
+		error("pDb must be connection or character of length 1!");
 
-	// Copied columns
-	for(iter = copyCols.begin(); iter != copyCols.end(); ++iter)
-		sql << ", " << *iter;
+	if(TYPEOF(pTable) != STRSXP || length(pTable) != 1)
+		error("pTable must be character of length 1!");
 
-	// Expanded columns
-	for(iter = expandCols.begin(); iter != expandCols.end(); ++iter)
-		sql << ", " << *iter;
+	if(TYPEOF(pColumns) != STRSXP)
+		error("pColumns must be character!");
 
-	sql << " FROM " << read_table << ";";
+	if(TYPEOF(pChunkRows) != INTSXP || length(pChunkRows) != 1 || INTEGER(pChunkRows)[0] < 1)
+		error("pChunkRows must be positive integer!");
 
-	if(verbose)
-		Rprintf("[expand_table] SQL: '%s'\n", sql.str().c_str());
+	if(TYPEOF(pRebuild) != INTSXP || length(pRebuild) != 1)
+		error("pRebuild must be integer of length 1!");
 
-	// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
-	// Execute query and expand algorithm
-	// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
-	// See also:
-	// http://stackoverflow.com/questions/1711631/improve-insert-per-second-performance-of-sqlite
+	if(TYPEOF(pVerbose) != INTSXP)
+		error("pVerbose must be integer!");
+
+	string table = string(CHAR(STRING_ELT(pTable, 0)));
+	sqlite3_int64 chunk_rows = INTEGER(pChunkRows)[0];
+	bool rebuild = (bool) INTEGER(pRebuild)[0];
+	bool verbose = (bool) INTEGER(pVerbose)[0];
+	int i, n_cols = length(pColumns);
+
+	call_connection cc(pDb, verbose);
+	sqlite_con &con = cc.get();
+
+	if(!cc.open())
+		error("[convert_to_num] Could not open SQLite database '%s'.", con.get_db_name().c_str());
+
+	if(!register_dec_comma(con))
+	{
+		cc.close_on_error();
+		error("[convert_to_num] Cannot register function 'dec_comma'!");
+	}
+	con.set_sync(sqlite_con::SYNC_OFF);
+
+	SEXP pRes = PROTECT(allocVector(REALSXP, n_cols));
+	setAttrib(pRes, R_NamesSymbol, pColumns);
+
+	for(i = 0; i < n_cols; ++i)
+	{
+		string column = string(CHAR(STRING_ELT(pColumns, i)));
+		long n_converted = convert_column(con, table, column, chunk_rows, rebuild, verbose);
+		if(n_converted < 0)
+		{
+			cc.close_on_error();
+			UNPROTECT(1);
+			error("[convert_to_num] Conversion of column '%s' failed!", column.c_str());
+		}
+		REAL(pRes)[i] = (double) n_converted;
+
+		if(verbose)
+			Rprintf("[convert_to_num] Column '%s': %ld rows converted.\n", column.c_str(), n_converted);
+	}
+
+	// Restores PRAGMAs (persistent connections stay open)
+	cc.close();
+	UNPROTECT(1);
+	return pRes;
+}
+
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
+// Copies value column from base table into tables (joined by key column,
+// see woche_index.h).
+// pColumns: key column and value column (vers_id, woche_index)
+// Returns number of rows with matching key per table.
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
+SEXP woche_index(SEXP pDb, SEXP pTables, SEXP pBase, SEXP pColumns, SEXP pChunkRows, SEXP pVerbose)
+{
+	if(!is_r_connection(pDb) && (TYPEOF(pDb) != STRSXP || length(pDb) != 1))
+		error("pDb must be connection or character of length 1!");
+
+	if(TYPEOF(pTables) != STRSXP)
+		error("pTables must be character!");
+
+	if(TYPEOF(pBase) != STRSXP || length(pBase) != 1)
+		error("pBase must be character of length 1!");
+
+	if(TYPEOF(pColumns) != STRSXP || length(pColumns) != 2)
+		error("pColumns must be character of length 2!");
+
+	if(TYPEOF(pChunkRows) != INTSXP || length(pChunkRows) != 1 || INTEGER(pChunkRows)[0] < 1)
+		error("pChunkRows must be positive integer!");
+
+	if(TYPEOF(pVerbose) != INTSXP)
+		error("pVerbose must be integer!");
+
+	string base_table = string(CHAR(STRING_ELT(pBase, 0)));
+	string key_col = string(CHAR(STRING_ELT(pColumns, 0)));
+	string value_col = string(CHAR(STRING_ELT(pColumns, 1)));
+	sqlite3_int64 chunk_rows = INTEGER(pChunkRows)[0];
+	bool verbose = (bool) INTEGER(pVerbose)[0];
+	int i, n_tables = length(pTables);
 
-	// Prepare struct which will be passed to callback function
-	callback_data cd;
-	cd.stmt = &stmt;
-	cd.expand_start = 3 + nCopyCols;
-	cd.expand_end = cd.expand_start + nExpandCols - 1;
+	call_connection cc(pDb, verbose);
+	sqlite_con &con = cc.get();
 
+	if(!cc.open())
+		error("[woche_index] Could not open SQLite database '%s'.", con.get_db_name().c_str());
+
+	key_value_map map;
+	if(!map.load(con, base_table, key_col, value_col))
+	{
+		cc.close_on_error();
+		error("[woche_index] Cannot read '%s' from table '%s'!", value_col.c_str(), base_table.c_str());
+	}
+
+	if(verbose)
+		Rprintf("[woche_index] %lu keys loaded from '%s'.\n", (unsigned long) map.size(), base_table.c_str());
 
-	// ToDo: Check whether sync_off critically slows down execution
 	con.set_sync(sqlite_con::SYNC_OFF);
-	con.begin();
-	con.exec_callback(sql.str(), expand_callback, &cd);
-	con.commit();
-	con.set_sync(sqlite_con::SYNC_FULL); // Default
+
+	SEXP pRes = PROTECT(allocVector(REALSXP, n_tables));
+	setAttrib(pRes, R_NamesSymbol, pTables);
+
+	for(i = 0; i < n_tables; ++i)
+	{
+		string table = string(CHAR(STRING_ELT(pTables, i)));
+		long n_matched = update_from_map(con, map, table, key_col, value_col, chunk_rows, verbose);
+		if(n_matched < 0)
+		{
+			cc.close_on_error();
+			UNPROTECT(1);
+			error("[woche_index] Update of table '%s' failed!", table.c_str());
+		}
+		REAL(pRes)[i] = (double) n_matched;
+	}
+
+	// Restores PRAGMAs (persistent connections stay open)
+	cc.close();
+	UNPROTECT(1);
+	return pRes;
+}
+
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
+// Conversion of query result into data.frame.
+// R types are derived from declared column types (SQLite affinity rules)
+// or, for expressions, from the storage class of the first value.
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
+struct result_column
+{
+	int type;				// INTSXP, REALSXP or STRSXP
+	vector<double> num;
+	vector<string> text;
+	vector<bool> na;
+};
+
+SEXP stmt_to_dataframe(sqlite_stmt &stmt, bool &success)
+{
+	int j, n_cols = stmt.column_count();
+	unsigned long i, n_rows = 0;
+	vector<result_column> cols(n_cols);
+
+	for(j = 0; j < n_cols; ++j)
+		cols[j].type = decltype_to_sexptype(stmt.column_decltype(j));
+
+	for(const sqlite_row &row : sqlite_cursor(stmt))
+	{
+		for(j = 0; j < n_cols; ++j)
+		{
+			result_column &c = cols[j];
+			if(c.type == NILSXP)
+			{
+				switch(row.type(j))
+				{
+					case SQLITE_INTEGER: c.type = INTSXP; break;
+					case SQLITE_FLOAT: c.type = REALSXP; break;
+					case SQLITE_NULL: break;
+					default: c.type = STRSXP;
+				}
+			}
+
+			c.na.push_back(row.is_null(j));
+			if(c.type == STRSXP && row.is_null(j))
+				c.text.push_back(string());
+			else if(c.type == STRSXP)
+			{
+				// Text before bytes (sqlite3_column_bytes after conversion)
+				const char *text = row.get_text(j);
+				c.text.push_back(string(text, row.get_bytes(j)));
+			}
+			else
+				c.num.push_back(row.get_double(j));
+		}
+		++n_rows;
+	}
+	success = stmt.is_done();
+
+	SEXP pDf = PROTECT(allocVector(VECSXP, n_cols));
+	SEXP pNames = PROTECT(allocVector(STRSXP, n_cols));
+	for(j = 0; j < n_cols; ++j)
+	{
+		result_column &c = cols[j];
+		SET_STRING_ELT(pNames, j, mkChar(stmt.column_name(j)));
+
+		// Integer values outside of R integer range are returned as double
+		if(c.type == INTSXP)
+		{
+			for(i = 0; i < n_rows; ++i)
+			{
+				if(!c.na[i] && (c.num[i] > INT_MAX || c.num[i] <= INT_MIN))
+				{
+					c.type = REALSXP;
+					break;
+				}
+			}
+		}
+
+		SEXP pCol;
+		if(c.type == INTSXP)
+		{
+			pCol = allocVector(INTSXP, n_rows);
+			SET_VECTOR_ELT(pDf, j, pCol);
+			for(i = 0; i < n_rows; ++i)
+				INTEGER(pCol)[i] = c.na[i] ? NA_INTEGER : (int) c.num[i];
+		}
+		else if(c.type == STRSXP)
+		{
+			pCol = allocVector(STRSXP, n_rows);
+			SET_VECTOR_ELT(pDf, j, pCol);
+			for(i = 0; i < n_rows; ++i)
+				SET_STRING_ELT(pCol, i, c.na[i] ? NA_STRING : mkCharLenCE(c.text[i].data(), c.text[i].size(), CE_UTF8));
+		}
+		else
+		{
+			// REALSXP and all-NULL columns
+			pCol = allocVector(REALSXP, n_rows);
+			SET_VECTOR_ELT(pDf, j, pCol);
+			for(i = 0; i < n_rows; ++i)
+				REAL(pCol)[i] = (c.type == REALSXP && !c.na[i]) ? c.num[i] : NA_REAL;
+		}
+	}
+	setAttrib(pDf, R_NamesSymbol, pNames);
+
+	set_data_frame_attributes(pDf, n_rows);
+
+	UNPROTECT(2);
+	return pDf;
+}
+
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
+// Query on expanded table without materialization
+// (virtual table module 'expand', see expand_vtab.h)
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
+SEXP expand_query(SEXP pParams, SEXP pCopyCol, SEXP pExpCol, SEXP pWhere, SEXP pVerbose, SEXP pCon)
+{
+	if(TYPEOF(pParams) != STRSXP)
+		error("pParams must be character!");
+
+	if(length(pParams) != 6)
+		error("pParams must have length 6!");
+
+	if(TYPEOF(pCopyCol) != STRSXP)
+		error("pCopyCol must be character");
+
+	if(TYPEOF(pExpCol) != STRSXP)
+		error("pExpCol must be character!");
+
+	if(TYPEOF(pWhere) != STRSXP || length(pWhere) != 1)
+		error("pWhere must be character of length 1!");
+
+	if(TYPEOF(pVerbose) != INTSXP)
+		error("pVerbose must be integer!");
+
+	if(!length(pExpCol))
+		error("pExpandCols must not be empty!");
 
 	// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
-	// Close database connection.
+	// Provided parameters: see expand_table
+	// [2] write table name: Name of (temporary) virtual table
 	// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
+	string db_file		= string(CHAR(STRING_ELT(pParams, 0)));
+	string read_table	= string(CHAR(STRING_ELT(pParams, 1)));
+	string write_table	= string(CHAR(STRING_ELT(pParams, 2)));
+	string lo_bound_col	= string(CHAR(STRING_ELT(pParams, 3)));
+	string up_bound_col	= string(CHAR(STRING_ELT(pParams, 4)));
+	string index_column	= string(CHAR(STRING_ELT(pParams, 5)));
+	string where		= string(CHAR(STRING_ELT(pWhere, 0)));
+	bool verbose = (bool) INTEGER(pVerbose)[0];
+	int i;
+
+	stringstream sql;
+	sql << "DROP TABLE IF EXISTS temp." << write_table << ";";
+	sql << "CREATE VIRTUAL TABLE temp." << write_table << " USING expand(";
+	sql << read_table << ", " << lo_bound_col << ", " << up_bound_col << ", " << index_column;
+	for(i = 0; i < length(pCopyCol); ++i)
+		sql << ", copy=" << CHAR(STRING_ELT(pCopyCol, i));
+	for(i = 0; i < length(pExpCol); ++i)
+		sql << ", expand=" << CHAR(STRING_ELT(pExpCol, i));
+	sql << ");";
+
+	// Connection handle (sqliteToolsConnect) or database file
+	call_connection cc(pCon, db_file, verbose);
+	sqlite_con &con = cc.get();
+
+	if(!cc.open())
+		error("[expand_query] Could not open SQLite database '%s'.", db_file.c_str());
+
+	if(!con.create_module("expand", &expand_module))
+	{
+		cc.close_on_error();
+		error("[expand_query] Cannot register module 'expand'!");
+	}
+
 	if(verbose)
-		Rprintf("[expand_table] Closing database.\n");
+		Rprintf("[expand_query] SQL: '%s'\n", sql.str().c_str());
 
-	// Resets sync and journalling mode
-	if(con.close())
+	if(!con.exec(sql.str()))
 	{
-		if(verbose)
-			Rprintf("[expand_table] Finished.\n");
+		cc.close_on_error();
+		error("[expand_query] Cannot create virtual table!");
 	}
-	else
-		error("Database closing error!");
 
+	sql.str("");
+	sql << "SELECT * FROM temp." << write_table;
+	if(where.size())
+		sql << " WHERE " << where;
+	sql << ";";
+
+	if(verbose)
+		Rprintf("[expand_query] SQL: '%s'\n", sql.str().c_str());
+
+	sqlite_stmt stmt(con);
+	if(!stmt.prepare(sql.str()))
+	{
+		con.exec("DROP TABLE IF EXISTS temp." + write_table + ";");
+		cc.close_on_error();
+		error("[expand_query] Prepare SELECT statement error!");
+	}
+
+	bool success;
+	SEXP pDf = PROTECT(stmt_to_dataframe(stmt, success));
+	stmt.finalize();
+
+	// Virtual table must not stay on persistent connection
+	con.exec("DROP TABLE IF EXISTS temp." + write_table + ";");
+	cc.close();
+
+	if(!success)
+		error("[expand_query] Query on virtual table failed!");
+
+	UNPROTECT(1);
+	return pDf;
+}
+
+
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
+// Persistent connection handles (see r_connection.h)
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
+SEXP open_connection(SEXP pDbFile, SEXP pVerbose)
+{
+	if(TYPEOF(pDbFile) != STRSXP || length(pDbFile) != 1)
+		error("pDbFile must be character of length 1!");
+
+	if(TYPEOF(pVerbose) != INTSXP)
+		error("pVerbose must be integer!");
+
+	return new_r_connection(string(CHAR(STRING_ELT(pDbFile, 0))), INTEGER(pVerbose)[0]);
+}
+
+// Applies PRAGMA profile to persistent connection (kept until
+// restored or disconnected). pOptions: pragmaProfile, pragmas, restore
+// (restore all PRAGMAs before applying profile).
+// Returns previous values of all changed PRAGMAs.
+SEXP connection_pragmas(SEXP pCon, SEXP pOptions)
+{
+	r_connection *rc = get_r_connection(pCon);
+	if(!rc)
+		error("pCon must be open sqliteToolsConnection!");
+
+	if(TYPEOF(pOptions) != VECSXP)
+		error("pOptions must be a list!");
+
+	sqlite_con::pragma_list pragmas;
+	if(!get_pragma_options(pOptions, pragmas))
+		error("Unknown pragmaProfile '%s'!", get_string_option(pOptions, "pragmaProfile", "").c_str());
+
+	sqlite_con &con = rc->con;
+	if(!con && !con.open())
+		error("[connection_pragmas] Could not open SQLite database '%s'.", con.get_db_name().c_str());
+
+	bool success = true;
+	if(get_int_option(pOptions, "restore", 0))
+		success = con.restore_pragmas();
+
+	success = success && con.apply_pragmas(pragmas);
+	con.getos().flush();
+	if(!success)
+		error("[connection_pragmas] Cannot apply PRAGMAs!");
+
+	const sqlite_con::pragma_list &changed = con.changed_pragmas();
+	int i, n = (int) changed.size();
+	SEXP pRes = PROTECT(allocVector(STRSXP, n));
+	SEXP pNames = PROTECT(allocVector(STRSXP, n));
+	for(i = 0; i < n; ++i)
+	{
+		SET_STRING_ELT(pRes, i, mkChar(changed[i].second.c_str()));
+		SET_STRING_ELT(pNames, i, mkChar(changed[i].first.c_str()));
+	}
+	setAttrib(pRes, R_NamesSymbol, pNames);
+	UNPROTECT(2);
+	return pRes;
+}
+
+SEXP close_connection(SEXP pCon)
+{
+	if(!is_r_connection(pCon))
+		error("pCon must be sqliteToolsConnection!");
+
+	r_connection_finalizer(pCon);
 	return R_NilValue;
 }
 
 
 
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
+// Reads columnar binary file (see column_file.h) into data.frame.
+// Integer columns are returned as integer when all values are
+// inside R integer range (as double otherwise).
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
+SEXP read_column_file(SEXP pFile)
+{
+	if(TYPEOF(pFile) != STRSXP || length(pFile) != 1)
+		error("pFile must be character of length 1!");
+
+	rostream ros;
+	column_file_reader reader(ros);
+	if(!reader.open(string(CHAR(STRING_ELT(pFile, 0)))))
+		error("[read_column_file] Cannot read file!");
+
+	unsigned j, n_cols = reader.n_cols();
+	R_xlen_t i, n_rows = (R_xlen_t) reader.n_rows();
+
+	if(n_rows > INT_MAX)
+		error("[read_column_file] File has too many rows for data.frame!");
+
+	SEXP pDf = PROTECT(allocVector(VECSXP, n_cols));
+	SEXP pNames = PROTECT(allocVector(STRSXP, n_cols));
+
+	for(j = 0; j < n_cols; ++j)
+	{
+		SET_STRING_ELT(pNames, j, mkChar(reader.name(j)));
+		SEXP pCol;
+
+		if(reader.type(j) == COL_INT64)
+		{
+			const int64_t *v = reader.int_column(j);
+			bool in_range = true;
+			for(i = 0; in_range && i < n_rows; ++i)
+				in_range = (v[i] == column_file_na_int) || (v[i] <= INT_MAX && v[i] > INT_MIN);
+
+			if(in_range)
+			{
+				pCol = allocVector(INTSXP, n_rows);
+				SET_VECTOR_ELT(pDf, j, pCol);
+				int *p = INTEGER(pCol);
+				for(i = 0; i < n_rows; ++i)
+					p[i] = (v[i] == column_file_na_int) ? NA_INTEGER : (int) v[i];
+			}
+			else
+			{
+				pCol = allocVector(REALSXP, n_rows);
+				SET_VECTOR_ELT(pDf, j, pCol);
+				double *p = REAL(pCol);
+				for(i = 0; i < n_rows; ++i)
+					p[i] = (v[i] == column_file_na_int) ? NA_REAL : (double) v[i];
+			}
+		}
+		else if(reader.type(j) == COL_DOUBLE)
+		{
+			pCol = allocVector(REALSXP, n_rows);
+			SET_VECTOR_ELT(pDf, j, pCol);
+			if(n_rows)
+				memcpy(REAL(pCol), reader.double_column(j), n_rows * sizeof(double));
+		}
+		else
+		{
+			pCol = allocVector(STRSXP, n_rows);
+			SET_VECTOR_ELT(pDf, j, pCol);
+			size_t len = 0;
+			for(i = 0; i < n_rows; ++i)
+			{
+				const char *text = reader.text(j, i, len);
+				SET_STRING_ELT(pCol, i, text ? mkCharLenCE(text, len, CE_UTF8) : NA_STRING);
+			}
+		}
+	}
+	setAttrib(pDf, R_NamesSymbol, pNames);
+	set_data_frame_attributes(pDf, n_rows);
+
+	reader.close();
+	UNPROTECT(2);
+	return pDf;
+}
+
+
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
+// Writes data.frame into table (see column_batch.h):
+// Values are bound directly from the column vectors (no conversion in R).
+// integer, logical	: INTEGER
+// numeric			: REAL
+// character, factor	: TEXT (UTF-8 and ASCII strings are bound without copy,
+//					  others are translated into UTF-8)
+// Returns number of written rows.
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
+static const char * r_char_utf8(SEXP s, int &bytes)
+{
+	if(s == NA_STRING)
+		return 0;
+	if(IS_UTF8(s) || IS_ASCII(s))
+	{
+		bytes = LENGTH(s);
+		return CHAR(s);
+	}
+
+	// Allocated by R_alloc (valid until end of .Call)
+	const char *text = translateCharUTF8(s);
+	bytes = (int) strlen(text);
+	return text;
+}
+
+static const char * r_string_text(const void *ctx, size_t i, int &bytes)
+{
+	return r_char_utf8(STRING_ELT((SEXP) ctx, i), bytes);
+}
+
+// Levels are translated once
+struct r_factor
+{
+	const int *codes;
+	vector<const char*> levels;
+	vector<int> level_bytes;
+};
+
+static const char * r_factor_text(const void *ctx, size_t i, int &bytes)
+{
+	const r_factor *f = (const r_factor*) ctx;
+	int code = f->codes[i];
+	if(code == NA_INTEGER || code < 1 || code > (int) f->levels.size())
+		return 0;
+	bytes = f->level_bytes[code - 1];
+	return f->levels[code - 1];
+}
+
+SEXP write_table_fast(SEXP pDb, SEXP pTable, SEXP pDf, SEXP pChunkRows, SEXP pBatchSize, SEXP pOverwrite, SEXP pVerbose)
+{
+	if(!is_r_connection(pDb) && (TYPEOF(pDb) != STRSXP || length(pDb) != 1))
+		error("pDb must be connection or character of length 1!");
+
+	if(TYPEOF(pTable) != STRSXP || length(pTable) != 1)
+		error("pTable must be character of length 1!");
+
+	if(TYPEOF(pDf) != VECSXP || length(pDf) == 0)
+		error("pDf must be a non-empty list!");
+
+	if(TYPEOF(pChunkRows) != INTSXP || length(pChunkRows) != 1 || INTEGER(pChunkRows)[0] < 0)
+		error("pChunkRows must be integer >= 0!");
+
+	if(TYPEOF(pBatchSize) != INTSXP || length(pBatchSize) != 1 || INTEGER(pBatchSize)[0] < 0)
+		error("pBatchSize must be integer >= 0!");
+
+	if(TYPEOF(pOverwrite) != INTSXP || TYPEOF(pVerbose) != INTSXP)
+		error("pOverwrite and pVerbose must be integer!");
+
+	SEXP pNames = getAttrib(pDf, R_NamesSymbol);
+	int j, n_cols = length(pDf);
+	if(TYPEOF(pNames) != STRSXP || length(pNames) != n_cols)
+		error("pDf must have names!");
+
+	string table = string(CHAR(STRING_ELT(pTable, 0)));
+	bool verbose = (bool) INTEGER(pVerbose)[0];
+	size_t n_rows = length(VECTOR_ELT(pDf, 0));
+
+	// Column buffers point into the R vectors
+	vector<string> names(n_cols), types(n_cols);
+	vector<column_buffer> cols(n_cols);
+	vector<r_factor> factors(n_cols);
+
+	for(j = 0; j < n_cols; ++j)
+	{
+		SEXP pCol = VECTOR_ELT(pDf, j);
+		names[j] = CHAR(STRING_ELT(pNames, j));
+		if((size_t) length(pCol) != n_rows)
+			error("Column '%s' has %d rows (%lu expected)!", names[j].c_str(), length(pCol), (unsigned long) n_rows);
+
+		column_buffer &col = cols[j];
+		if(isFactor(pCol))
+		{
+			r_factor &f = factors[j];
+			f.codes = INTEGER(pCol);
+			SEXP pLevels = getAttrib(pCol, R_LevelsSymbol);
+			int k, n_levels = length(pLevels);
+			f.levels.resize(n_levels);
+			f.level_bytes.resize(n_levels);
+			for(k = 0; k < n_levels; ++k)
+				f.levels[k] = r_char_utf8(STRING_ELT(pLevels, k), f.level_bytes[k]);
+			col.type = column_buffer::BUF_TEXT;
+			col.text = r_factor_text;
+			col.ctx = &f;
+			types[j] = "TEXT";
+		}
+		else if(TYPEOF(pCol) == INTSXP || TYPEOF(pCol) == LGLSXP)
+		{
+			col.type = column_buffer::BUF_INT;
+			col.ints = TYPEOF(pCol) == INTSXP ? INTEGER(pCol) : LOGICAL(pCol);
+			types[j] = "INTEGER";
+		}
+		else if(TYPEOF(pCol) == REALSXP)
+		{
+			col.type = column_buffer::BUF_DOUBLE;
+			col.doubles = REAL(pCol);
+			types[j] = "REAL";
+		}
+		else if(TYPEOF(pCol) == STRSXP)
+		{
+			col.type = column_buffer::BUF_TEXT;
+			col.text = r_string_text;
+			col.ctx = pCol;
+			types[j] = "TEXT";
+		}
+		else
+			error("Column '%s' has unsupported type '%s'!", names[j].c_str(), type2char(TYPEOF(pCol)));
+	}
+
+	call_connection cc(pDb, verbose);
+	sqlite_con &con = cc.get();
+
+	if(!cc.open())
+		error("[write_table_fast] Could not open SQLite database '%s'.", con.get_db_name().c_str());
+	con.set_sync(sqlite_con::SYNC_OFF);
+
+	long n_written = write_columns(con, table, names, types, cols, n_rows,
+			INTEGER(pChunkRows)[0], INTEGER(pBatchSize)[0], (bool) INTEGER(pOverwrite)[0], verbose);
+
+	if(n_written < 0)
+	{
+		cc.close_on_error();
+		error("[write_table_fast] Writing table '%s' failed!", table.c_str());
+	}
+
+	// Restores PRAGMAs (persistent connections stay open)
+	cc.close();
+	return ScalarReal((double) n_written);
+}
+
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
+// Reads table into data.frame (see table_reader.h):
+// pColumns: Names or expressions (character(0): all columns)
+// pWhere: character(0) or WHERE clause (without 'WHERE')
+// pNRows: Expected number of rows (NA: counted)
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
+static void get_read_spec(SEXP pTable, SEXP pColumns, SEXP pWhere, read_spec &spec)
+{
+	if(TYPEOF(pTable) != STRSXP || length(pTable) != 1)
+		error("pTable must be character of length 1!");
+
+	if(TYPEOF(pColumns) != STRSXP)
+		error("pColumns must be character!");
+
+	if(TYPEOF(pWhere) != STRSXP || length(pWhere) > 1)
+		error("pWhere must be character of length 0 or 1!");
+
+	spec.table = CHAR(STRING_ELT(pTable, 0));
+	int j;
+	for(j = 0; j < length(pColumns); ++j)
+		spec.columns.push_back(CHAR(STRING_ELT(pColumns, j)));
+	if(length(pWhere))
+		spec.where = CHAR(STRING_ELT(pWhere, 0));
+}
+
+// NA: -1 (rows are counted)
+static double get_row_hint(SEXP pNRows)
+{
+	if(TYPEOF(pNRows) != REALSXP || length(pNRows) != 1)
+		error("pNRows must be numeric of length 1!");
+
+	double n_rows = REAL(pNRows)[0];
+	if(ISNAN(n_rows))
+		return -1;
+	if(n_rows < 0)
+		error("pNRows must be >= 0!");
+	return n_rows;
+}
+
+SEXP read_table_fast(SEXP pDb, SEXP pTable, SEXP pColumns, SEXP pWhere, SEXP pNRows, SEXP pVerbose)
+{
+	if(!is_r_connection(pDb) && (TYPEOF(pDb) != STRSXP || length(pDb) != 1))
+		error("pDb must be connection or character of length 1!");
+
+	if(TYPEOF(pVerbose) != INTSXP)
+		error("pVerbose must be integer!");
+
+	read_spec spec;
+	get_read_spec(pTable, pColumns, pWhere, spec);
+	double n_hint = get_row_hint(pNRows);
+	bool verbose = (bool) INTEGER(pVerbose)[0];
+
+	call_connection cc(pDb, verbose);
+	sqlite_con &con = cc.get();
+
+	if(!cc.open())
+		error("[read_table_fast] Could not open SQLite database '%s'.", con.get_db_name().c_str());
+
+	table_reader reader(con);
+	SEXP pDf = 0;
+	if(reader.open(spec, n_hint))
+		pDf = reader.read(0);
+
+	if(!pDf)
+	{
+		reader.close();
+		cc.close_on_error();
+		error("[read_table_fast] Reading table '%s' failed!", spec.table.c_str());
+	}
+	PROTECT(pDf);
+
+	if(verbose)
+		con.getos() << "[read_table_fast] " << reader.rows_read() << " rows read from table '" << spec.table << "'.\n";
+
+	reader.close();
+	cc.close();
+	UNPROTECT(1);
+	return pDf;
+}
+
+// Reader for chunked reading on separate connection (pDbFile: file name)
+SEXP open_table_reader(SEXP pDbFile, SEXP pTable, SEXP pColumns, SEXP pWhere, SEXP pChunkRows, SEXP pNRows, SEXP pVerbose)
+{
+	if(TYPEOF(pDbFile) != STRSXP || length(pDbFile) != 1)
+		error("pDbFile must be character of length 1!");
+
+	if(TYPEOF(pChunkRows) != INTSXP || length(pChunkRows) != 1 || INTEGER(pChunkRows)[0] < 1)
+		error("pChunkRows must be positive integer!");
+
+	if(TYPEOF(pVerbose) != INTSXP)
+		error("pVerbose must be integer!");
+
+	read_spec spec;
+	get_read_spec(pTable, pColumns, pWhere, spec);
+
+	// Chunks have fixed size: Rows are not counted for NA
+	double n_hint = std::max(get_row_hint(pNRows), 0.0);
+
+	return new_r_table_reader(string(CHAR(STRING_ELT(pDbFile, 0))), spec,
+			INTEGER(pChunkRows)[0], n_hint, INTEGER(pVerbose)[0]);
+}
+
+// Returns next chunk (NULL when all rows have been read).
+// Statement is finalized after the last chunk (releases read lock).
+SEXP read_table_chunk(SEXP pReader)
+{
+	r_table_reader *rr = get_r_table_reader(pReader);
+	if(!rr)
+		error("pReader must be open sqliteToolsReader!");
+
+	if(rr->reader.is_done())
+		return R_NilValue;
+
+	SEXP pDf = rr->reader.read(rr->chunk_rows);
+	if(!pDf)
+	{
+		rr->reader.close();
+		rr->ros.flush();
+		error("[read_table_chunk] Reading chunk failed!");
+	}
+
+	if(rr->reader.is_done())
+	{
+		PROTECT(pDf);
+		rr->reader.close();
+		UNPROTECT(1);
+	}
+	rr->ros.flush();
+	return pDf;
+}
+
+SEXP close_table_reader(SEXP pReader)
+{
+	if(TYPEOF(pReader) != EXTPTRSXP || !inherits(pReader, r_table_reader_class))
+		error("pReader must be sqliteToolsReader!");
+
+	r_table_reader_finalizer(pReader);
+	return R_NilValue;
+}
+
 
 } // extern "C"
@@ -1,5 +1,5 @@
 /*
- * hipr.h
+ * sqliteTools.h
  *
  *  Created on: 04.12.2014
  *      Author: kaisers
@@ -11,6 +11,19 @@
 #include <sqlite3.h>
 #include "sqlite_con.h"
 #include "sqlite_stmt.h"
+#include "sqlite_cursor.h"
+#include "sqlite_batch.h"
+#include "expander.h"
+#include "pipeline.h"
+#include "expand_vtab.h"
+#include "expand_job.h"
+#include "frame_sink.h"
+#include "column_file.h"
+#include "column_batch.h"
+#include "table_reader.h"
+#include "convert_num.h"
+#include "woche_index.h"
+#include "r_connection.h"
 using namespace sqlite;
 
 #include "rostream.h"
@@ -18,6 +31,10 @@ using namespace sqlite;
 #include <iostream>
 #include <sstream>
 #include <list>
+#include <thread>
+#include <algorithm>
+#include <climits>
+#include <cctype>
 using namespace std;
 
 #include <cstdlib>
@@ -30,7 +47,19 @@ using namespace std;
 
 
 extern "C" {
-SEXP expand_table(SEXP pParams, SEXP pCopyCol, SEXP pCopyColTypes,  SEXP pExpCol, SEXP pVerbose);
+SEXP expand_table(SEXP pParams, SEXP pCopyCol, SEXP pCopyColTypes,  SEXP pExpCol, SEXP pVerbose, SEXP pOptions);
+SEXP convert_to_num(SEXP pDb, SEXP pTable, SEXP pColumns, SEXP pChunkRows, SEXP pRebuild, SEXP pVerbose);
+SEXP woche_index(SEXP pDb, SEXP pTables, SEXP pBase, SEXP pColumns, SEXP pChunkRows, SEXP pVerbose);
+SEXP expand_query(SEXP pParams, SEXP pCopyCol, SEXP pExpCol, SEXP pWhere, SEXP pVerbose, SEXP pCon);
+SEXP open_connection(SEXP pDbFile, SEXP pVerbose);
+SEXP close_connection(SEXP pCon);
+SEXP connection_pragmas(SEXP pCon, SEXP pOptions);
+SEXP read_column_file(SEXP pFile);
+SEXP read_table_fast(SEXP pDb, SEXP pTable, SEXP pColumns, SEXP pWhere, SEXP pNRows, SEXP pVerbose);
+SEXP open_table_reader(SEXP pDbFile, SEXP pTable, SEXP pColumns, SEXP pWhere, SEXP pChunkRows, SEXP pNRows, SEXP pVerbose);
+SEXP read_table_chunk(SEXP pReader);
+SEXP close_table_reader(SEXP pReader);
+SEXP write_table_fast(SEXP pDb, SEXP pTable, SEXP pDf, SEXP pChunkRows, SEXP pBatchSize, SEXP pOverwrite, SEXP pVerbose);
 }
 
 
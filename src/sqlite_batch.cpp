@@ -0,0 +1,230 @@
+/*
+ * sqlite_batch.cpp
+ *
+ *  Created on: 17.10.2026
+ *      Author: kaisers
+ */
+
+#include "sqlite_batch.h"
+#include <algorithm>
+
+namespace sqlite {
+
+
+string multi_row_sql(const string &head, unsigned ncols, unsigned nrows)
+{
+	stringstream sql;
+	unsigned i, j;
+
+	sql << head;
+	for(i = 0; i < nrows; ++i)
+	{
+		if(i)
+			sql << ", ";
+		sql << "(?";
+		for(j = 1; j < ncols; ++j)
+			sql << ", ?";
+		sql << ")";
+	}
+	sql << ";";
+	return sql.str();
+}
+
+string sqlite_batch_stmt::row_sql(unsigned nrows) const
+{
+	return multi_row_sql(head, n_cols, nrows);
+}
+
+bool sqlite_batch_stmt::prepare(const string &sql_head, unsigned ncols, unsigned nbatch)
+{
+	if(!con)
+		return false;
+
+	if(ncols == 0)
+	{
+		con.getos() << log_error << "[sqlite_batch_stmt] prepare ERROR: Number of columns must be > 0!\n";
+		return false;
+	}
+
+	head = sql_head;
+	n_cols = ncols;
+
+	// Number of rows is restricted by maximal number of host parameters
+	unsigned max_batch = con.get_limit(SQLITE_LIMIT_VARIABLE_NUMBER) / n_cols;
+	if(max_batch == 0)
+	{
+		con.getos() << log_error << "[sqlite_batch_stmt] prepare ERROR: Too many columns (" << n_cols << ")!\n";
+		return false;
+	}
+
+	n_batch = std::min(nbatch ? nbatch : default_batch_rows, max_batch);
+	finalize_tails();
+
+	row.assign(n_cols, batch_cell());
+	pending.assign(n_batch * n_cols, batch_cell());
+	n_rows = 0;
+	arena.clear();
+
+	return stmt.prepare(row_sql(n_batch));
+}
+
+bool sqlite_batch_stmt::bind_rows(sqlite_stmt &s, unsigned first_row, unsigned nrows)
+{
+	unsigned i, n = nrows * n_cols;
+	sqlite3_int64 bytes = 0;
+	bool success = true;
+
+	const batch_cell *cells = &pending[first_row * n_cols];
+	for(i = 0; i < n; ++i)
+	{
+		const batch_cell &c = cells[i];
+		switch(c.type)
+		{
+			case SQLITE_INTEGER:
+				success = s.bind_int64(i + 1, c.ival);
+				bytes += 8;
+				break;
+			case SQLITE_FLOAT:
+				success = s.bind_double(i + 1, c.dval);
+				bytes += 8;
+				break;
+			case SQLITE_TEXT:
+				success = s.bind_text(i + 1, arena.data() + c.offset, c.bytes, true);
+				bytes += c.bytes;
+				break;
+			case SQLITE_BLOB:
+				success = s.bind_blob(i + 1, arena.data() + c.offset, c.bytes, true);
+				bytes += c.bytes;
+				break;
+			default:
+				success = s.bind_null(i + 1);
+		}
+		if(!success)
+			return false;
+	}
+	n_bytes += bytes;
+	return true;
+}
+
+sqlite_stmt * sqlite_batch_stmt::tail_stmt(unsigned k)
+{
+	if(k >= tails.size())
+		tails.resize(k + 1, 0);
+
+	if(!tails[k])
+	{
+		sqlite_stmt *s = new sqlite_stmt(con);
+		if(!s->prepare(row_sql(1u << k)))
+		{
+			delete s;
+			return 0;
+		}
+		tails[k] = s;
+	}
+	return tails[k];
+}
+
+void sqlite_batch_stmt::finalize_tails()
+{
+	size_t k;
+	for(k = 0; k < tails.size(); ++k)
+	{
+		if(tails[k])
+		{
+			if(stats)
+				stats->insert.add(*tails[k]);
+			tails[k]->finalize();
+			delete tails[k];
+		}
+	}
+	tails.clear();
+}
+
+void sqlite_batch_stmt::compact_arena()
+{
+	arena_swap.clear();
+	unsigned i;
+	for(i = 0; i < n_cols; ++i)
+	{
+		batch_cell &c = row[i];
+		if(c.type == SQLITE_TEXT || c.type == SQLITE_BLOB)
+		{
+			arena_swap.append(arena, c.offset, c.bytes);
+			c.offset = arena_swap.size() - c.bytes;
+		}
+	}
+	arena.swap(arena_swap);
+}
+
+bool sqlite_batch_stmt::step()
+{
+	// Copy current row into batch (text: reference into arena)
+	std::copy(row.begin(), row.end(), pending.begin() + n_rows * n_cols);
+
+	if(++n_rows < n_batch)
+		return true;
+
+	n_rows = 0;
+	++n_steps;
+	if(stats)
+		stats->lap(PHASE_EXPAND);
+
+	if(!bind_rows(stmt, 0, n_batch))
+		return false;
+	if(stats)
+		stats->lap(PHASE_BIND);
+
+	bool success = stmt.step();
+	compact_arena();
+	if(stats)
+		stats->lap(PHASE_STEP);
+	return success;
+}
+
+bool sqlite_batch_stmt::flush()
+{
+	if(n_rows == 0)
+		return true;
+
+	// Incomplete batch: Remaining rows are written in pieces of
+	// 2^k rows (largest first) by reused statements
+	unsigned k, first_row = 0, nrows = n_rows;
+	n_rows = 0;
+	bool success = true;
+
+	if(stats)
+		stats->lap(PHASE_EXPAND);
+
+	for(k = 31; success && nrows; --k)
+	{
+		unsigned piece = 1u << k;
+		if(nrows < piece)
+			continue;
+
+		sqlite_stmt *tail = tail_stmt(k);
+		success = tail && bind_rows(*tail, first_row, piece);
+		if(stats)
+			stats->lap(PHASE_BIND);
+
+		success = success && tail->step();
+		if(stats)
+			stats->lap(PHASE_STEP);
+
+		++n_steps;
+		first_row += piece;
+		nrows -= piece;
+	}
+	compact_arena();
+	return success;
+}
+
+bool sqlite_batch_stmt::finalize()
+{
+	finalize_tails();
+	if(stats)
+		stats->insert.add(stmt);
+	return stmt.finalize();
+}
+
+
+} // namespace sqlite
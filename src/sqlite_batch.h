@@ -0,0 +1,209 @@
+/*
+ * sqlite_batch.h
+ *
+ *  Created on: 17.10.2026
+ *      Author: kaisers
+ *
+ *  Batched insertion of rows with a multi-row INSERT statement:
+ *  INSERT INTO tbl (a, b) VALUES (?, ?), (?, ?), ... , (?, ?);
+ *
+ *  Values for one row are bound like for sqlite_stmt and remain
+ *  bound until they are overwritten. step() appends the current row
+ *  to the batch and executes the statement when the batch is full.
+ *  flush() must be called in order to write an incomplete last batch.
+ *  The remaining rows are written by statements for power of two numbers
+ *  of rows (e.g. 37 = 32 + 4 + 1), which are prepared once and reused.
+ *
+ *  Large batches are not faster: Preparing a statement with thousands of
+ *  rows takes longer than executing it, so the default is moderate
+ *  (default_batch_rows).
+ *
+ *  Text and blob values are copied once into a buffer (arena) when
+ *  they are bound. Rows of the batch refer to the arena and are bound
+ *  without copy (SQLITE_STATIC), so a copied column value is not
+ *  copied again for each expanded row.
+ */
+
+#ifndef SQLITE_BATCH_H_
+#define SQLITE_BATCH_H_
+
+#include "sqlite_stmt.h"
+#include "expand_stats.h"
+#include <string>
+#include <sstream>
+#include <vector>
+
+using namespace std;
+
+namespace sqlite {
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
+// Buffered value of one row cell
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
+struct sqlite_cell
+{
+	sqlite_cell() : type(SQLITE_NULL), ival(0), dval(0) {}
+	int type;			// SQLITE_INTEGER, SQLITE_FLOAT, SQLITE_TEXT, SQLITE_NULL
+	sqlite3_int64 ival;
+	double dval;
+	string text;
+};
+
+
+// Rows per statement when no batch size is given
+const unsigned default_batch_rows = 64;
+
+// head + "(?, ?, ...), (?, ?, ...), ...;" (nrows tuples of ncols parameters)
+string multi_row_sql(const string &head, unsigned ncols, unsigned nrows);
+
+
+class sqlite_batch_stmt {
+
+	// Cell of current row or batch (text and blob: position in arena)
+	struct batch_cell
+	{
+		batch_cell() : type(SQLITE_NULL), ival(0), dval(0), offset(0), bytes(0) {}
+		int type;			// SQLITE_INTEGER, SQLITE_FLOAT, SQLITE_TEXT, SQLITE_BLOB, SQLITE_NULL
+		sqlite3_int64 ival;
+		double dval;
+		size_t offset;
+		int bytes;
+	};
+
+public:
+	sqlite_batch_stmt(sqlite_con &c) : con(c), stmt(c),
+		n_cols(0), n_batch(0), n_rows(0), auto_id(0), n_steps(0), n_bytes(0), stats(0) {}
+	~sqlite_batch_stmt() { finalize_tails(); }
+
+	sqlite_con & get_con() const { return con; }
+	ostream & getos() const { return con.getos(); }
+
+	// Same semantics as sqlite_stmt
+	unsigned long getAutoId() { return ++auto_id; }
+	void setAutoId(unsigned long id) { auto_id = id; }
+	unsigned long lastAutoId() const { return auto_id; }
+
+	// sql_head	: "INSERT INTO tbl (a, b, c) VALUES "
+	// ncols	: Number of values per row
+	// nbatch	: Number of rows per statement (0: default_batch_rows).
+	//			  Restricted by SQLITE_LIMIT_VARIABLE_NUMBER.
+	bool prepare(const string &sql_head, unsigned ncols, unsigned nbatch = 0);
+	unsigned batch_size() const { return n_batch; }
+
+	///////////////////////////////////////////////////////////////////////////////////////////////
+	// Inline definition of bind functions (pos is 1-based position inside row)
+	void bind_int(unsigned pos, const sqlite3_int64 &value)
+	{
+		batch_cell &c = row[pos - 1];
+		c.type = SQLITE_INTEGER;
+		c.ival = value;
+	}
+
+	void bind_double(unsigned pos, const double &value)
+	{
+		batch_cell &c = row[pos - 1];
+		c.type = SQLITE_FLOAT;
+		c.dval = value;
+	}
+
+	void bind_text(unsigned pos, const char *text)
+	{
+		bind_bytes(pos, SQLITE_TEXT, text, strlen(text));
+	}
+
+	void bind_text(unsigned pos, const char *text, int n)
+	{
+		bind_bytes(pos, SQLITE_TEXT, text, n);
+	}
+
+	void bind_blob(unsigned pos, const void *data, int n)
+	{
+		bind_bytes(pos, SQLITE_BLOB, (const char*) data, n);
+	}
+
+	// Native value (storage class is kept)
+	void bind_value(unsigned pos, sqlite3_value *value)
+	{
+		const char *text;
+		switch(sqlite3_value_type(value))
+		{
+			case SQLITE_INTEGER:
+				bind_int(pos, sqlite3_value_int64(value));
+				break;
+			case SQLITE_FLOAT:
+				bind_double(pos, sqlite3_value_double(value));
+				break;
+			case SQLITE_NULL:
+				bind_null(pos);
+				break;
+			case SQLITE_BLOB:
+				bind_blob(pos, sqlite3_value_blob(value), sqlite3_value_bytes(value));
+				break;
+			default:
+				text = (const char*) sqlite3_value_text(value);
+				bind_text(pos, text, sqlite3_value_bytes(value));
+		}
+	}
+
+	void bind_null(unsigned pos)
+	{
+		row[pos - 1].type = SQLITE_NULL;
+	}
+
+	bool step();
+	bool flush();
+	bool finalize();
+
+	// Number of executed INSERT statements
+	unsigned long steps() const { return n_steps; }
+
+	// Size of bound values (8 bytes per number)
+	sqlite3_int64 bytes_bound() const { return n_bytes; }
+
+	// Instrumentation (0: disabled): bind and step time of batches
+	// and statement counters (added on finalize)
+	void set_stats(expand_stats *s) { stats = s; }
+	expand_stats * get_stats() const { return stats; }
+
+private:
+	sqlite_batch_stmt(const sqlite_batch_stmt &rhs);
+
+	string row_sql(unsigned nrows) const;
+	bool bind_rows(sqlite_stmt &s, unsigned first_row, unsigned nrows);
+
+	// Statement for 2^k rows (prepared on first use)
+	sqlite_stmt * tail_stmt(unsigned k);
+	void finalize_tails();
+
+	void bind_bytes(unsigned pos, int type, const char *data, int n)
+	{
+		batch_cell &c = row[pos - 1];
+		c.type = type;
+		c.offset = arena.size();
+		c.bytes = n;
+		arena.append(data, n);
+	}
+
+	// Keeps only values of current row (after batch has been written)
+	void compact_arena();
+
+	sqlite_con &con;
+	sqlite_stmt stmt;			// Prepared for n_batch rows
+	vector<sqlite_stmt*> tails;	// Index k: 2^k rows (incomplete batches)
+	string head;
+	unsigned n_cols;
+	unsigned n_batch;
+	unsigned n_rows;			// Number of rows in pending
+	vector<batch_cell> row;		// Current row
+	vector<batch_cell> pending;	// Rows of current batch
+	string arena;				// Text and blob values of row and pending
+	string arena_swap;
+	unsigned long int auto_id;
+	unsigned long int n_steps;
+	sqlite3_int64 n_bytes;
+	expand_stats *stats;
+};
+
+
+} // namespace sqlite
+#endif /* SQLITE_BATCH_H_ */
@@ -0,0 +1,755 @@
+/*
+ * sqlite_con.cpp
+ *
+ *  Created on: 17.10.2026
+ *      Author: kaisers
+ */
+
+#include "sqlite_con.h"
+
+namespace sqlite {
+
+
+// Static data
+const int sqlite_con::CON_OPEN		=1;
+const int sqlite_con::CON_CLOSED	=0;
+const int sqlite_con::CON_ERROR		=-1;
+
+const int sqlite_con::COM_BEGIN		=1;
+const int sqlite_con::COM_COMMITTED	=0;
+
+const int sqlite_con::SYNC_OFF=0;
+const int sqlite_con::SYNC_NORMAL=1;
+const int sqlite_con::SYNC_FULL=2;
+
+const string sqlite_con::JRNL_DELETE=string("DELETE");
+const string sqlite_con::JRNL_TRUNCATE=string("TRUNCATE");
+const string sqlite_con::JRNL_MEMORY=string("MEMORY");
+const string sqlite_con::JRNL_PERSIST=string("PERSIST");
+const string sqlite_con::JRNL_WAL=string("WAL");
+const string sqlite_con::JRNL_OFF=string("OFF");
+
+
+sqlite_con::sqlite_con(const string &name, ostream &file_out, int verb):
+		db(0), stmt(0), db_name(name),
+		con_status(CON_CLOSED), com_status(COM_COMMITTED),
+		stmt_cache_size(16),
+		os_(file_out), verbose(verb), row_errors(10)
+{}
+
+sqlite_con::~sqlite_con() {
+
+	if(con_status==CON_OPEN)
+	{
+		if(com_status==COM_BEGIN)
+			sqlite3_exec(db,"COMMIT",0,0,0);
+
+		// Reset (only when changed by this connection)
+		restore_pragmas();
+		clear_stmt_cache();
+		sqlite3_close_v2(db);
+	}
+	if(verbose)
+		os_ << "[sqlite_con] Destructed.\n";
+}
+
+
+sqlite_con& sqlite_con::operator=(const sqlite_con& rhs)
+{
+	if(this != &rhs)
+	{
+		result=rhs.result;
+		sql.str()=rhs.sql.str();
+	}
+	return *this;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// Database connection
+
+bool sqlite_con::open()
+{
+	result = sqlite3_open(db_name.c_str(), &db);
+	if(result == SQLITE_OK)
+	{
+		con_status = CON_OPEN;
+		if(verbose)
+			os_ << "[sqlite_con] Connection opened.\n";
+
+		return true;
+	}else
+	{
+		if(verbose)
+			os_ << log_error << "[sqlite_con]: Database connection could not be opened!\n";
+	}
+	return false;
+}
+
+bool sqlite_con::close()
+{
+	if(con_status==CON_OPEN)
+	{
+		// PRAGMAs can not be changed inside transaction
+		rollback();
+
+		// Reset (only when changed by this connection)
+		restore_pragmas();
+
+		// Borrowed statements are finalized on return
+		// (sqlite3_close_v2 defers closing until then)
+		clear_stmt_cache();
+		sqlite3_close_v2(db);
+		con_status=CON_CLOSED;
+
+		if(row_errors.suppressed())
+			os_ << log_warn << "[sqlite_con] " << row_errors.suppressed() << " further statement errors suppressed.\n";
+		row_errors.reset();
+
+		if(verbose)
+			os_ << "[sqlite_con] Database connection closed.\n";
+		os_.flush();
+		return true;
+	}
+	return false;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// Administration
+
+// Synchronous-status
+bool sqlite_con::set_sync(const int &SYNC_STATUS)
+{
+	stringstream value;
+	value << SYNC_STATUS;
+	if(!set_pragma("synchronous", value.str()))
+	{
+		os_ << log_error << "[sqlite_con] set_sync ERROR:" << sqlite_result(result) << endl;
+		return false;
+	}
+
+	if(verbose)
+		os_ << "[sqlite_con] Synchronous status: " << SYNC_STATUS << ".\n";
+
+	return true;
+}
+
+int sqlite_con::get_sync()
+{
+	string value;
+	if(!get_pragma("synchronous", value))
+		return -1;
+	return atoi(value.c_str());
+}
+
+bool sqlite_con::set_con_journal(const string & mode)
+{
+	if(!set_pragma("journal_mode", mode))
+	{
+		os_ << log_error << "[sqlite_con] set_con_journal ERROR: " << sqlite_result(result) << endl;
+		return false;
+	}
+
+	if(verbose)
+		os_ << "[sqlite_con] Journal mode: " << mode << "\n";
+
+	return true;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
+// PRAGMA profiles
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
+
+bool sqlite_con::get_pragma_profile(const string &name, pragma_list &profile)
+{
+	profile.clear();
+	if(name == "none")
+		return true;
+
+	profile.push_back(make_pair("synchronous", "OFF"));
+	if(name == "default")
+		return true;
+
+	if(name != "bulk" && name != "bulk_wal")
+		return false;
+
+	// Shared bulk settings: 256 MiB page cache, 256 MiB memory map
+	profile.push_back(make_pair("cache_size", "-262144"));
+	profile.push_back(make_pair("mmap_size", "268435456"));
+	profile.push_back(make_pair("temp_store", "MEMORY"));
+
+	if(name == "bulk")
+	{
+		// No other connections (readers or writers) while loading.
+		// Without journal, ROLLBACK does not restore the database.
+		profile.push_back(make_pair("locking_mode", "EXCLUSIVE"));
+		profile.push_back(make_pair("journal_mode", "OFF"));
+	}
+	else
+		profile.push_back(make_pair("journal_mode", "WAL"));
+
+	return true;
+}
+
+// Names and values are restricted to identifiers and numbers
+// (they are pasted into the PRAGMA statement).
+static bool is_pragma_token(const string &token)
+{
+	if(token.empty())
+		return false;
+
+	string::const_iterator iter;
+	for(iter = token.begin(); iter != token.end(); ++iter)
+	{
+		if(!isalnum((unsigned char) *iter) && *iter != '_' && *iter != '-')
+			return false;
+	}
+	return true;
+}
+
+bool sqlite_con::get_pragma(const string &name, string &value)
+{
+	if(!is_pragma_token(name))
+	{
+		os_ << log_error << "[sqlite_con] get_pragma ERROR: Invalid PRAGMA name '" << name << "'!\n";
+		return false;
+	}
+
+	cached_stmt cs = get_cached_stmt("PRAGMA " + name + ";");
+	if(!cs)
+		return false;
+
+	result = sqlite3_step(cs.get());
+	if(result != SQLITE_ROW)
+	{
+		os_ << log_error << "[sqlite_con] get_pragma '" << name << "' ERROR: "
+				<< (result == SQLITE_DONE ? "No value" : sqlite_result(result)) << "\n";
+		return false;
+	}
+
+	const char *text = (const char*) sqlite3_column_text(cs.get(), 0);
+	value = text ? text : "";
+	return true;
+}
+
+// Records previous value (when value is changed)
+bool sqlite_con::set_pragma(const string &name, const string &value)
+{
+	string previous;
+	if(!is_pragma_token(value))
+	{
+		os_ << log_error << "[sqlite_con] set_pragma ERROR: Invalid value '" << value << "' for PRAGMA " << name << "!\n";
+		return false;
+	}
+
+	if(!get_pragma(name, previous))
+		return false;
+
+	if(sqlite3_stricmp(previous.c_str(), value.c_str()) == 0)
+		return true;
+
+	result = sqlite3_exec(db, ("PRAGMA " + name + "=" + value + ";").c_str(), 0, 0, 0);
+	if(result != SQLITE_OK)
+	{
+		os_ << log_error << "[sqlite_con] set_pragma " << name << "=" << value << " ERROR: " << sqlite_result(result) << "\n";
+		return false;
+	}
+	pragma_stack.push_back(make_pair(name, previous));
+
+	if(verbose)
+		os_ << "[sqlite_con] PRAGMA " << name << ": " << previous << " -> " << value << "\n";
+	return true;
+}
+
+bool sqlite_con::apply_pragmas(const pragma_list &pragmas)
+{
+	pragma_list::const_iterator iter;
+	for(iter = pragmas.begin(); iter != pragmas.end(); ++iter)
+	{
+		if(!set_pragma(iter->first, iter->second))
+			return false;
+	}
+	return true;
+}
+
+bool sqlite_con::restore_pragmas(size_t mark)
+{
+	bool success = true;
+	while(pragma_stack.size() > mark)
+	{
+		const pair<string, string> &p = pragma_stack.back();
+		result = sqlite3_exec(db, ("PRAGMA " + p.first + "=" + p.second + ";").c_str(), 0, 0, 0);
+		if(result != SQLITE_OK)
+		{
+			os_ << log_error << "[sqlite_con] restore_pragmas " << p.first << "=" << p.second << " ERROR: " << sqlite_result(result) << "\n";
+			success = false;
+		}
+		else if(verbose)
+			os_ << "[sqlite_con] PRAGMA " << p.first << " restored: " << p.second << "\n";
+		pragma_stack.pop_back();
+	}
+	return success;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// Creation and drop of tables, creation of indexes, get_max_id_val
+
+bool sqlite_con::create_table(const string& sql)
+{
+	if(con_status!=CON_OPEN)
+	{
+		os_ << log_error << "[sqlite_con] create_table ERROR: Database connection is closed!" << endl;
+		return false;
+	}
+
+	result=sqlite3_prepare_v2(db,sql.c_str(),sql.length(),&stmt,0);
+	if(result!=SQLITE_OK)
+	{
+		os_ << log_error << "[sqlite_con] Create_table (prepare) ERROR: " << sqlite_result(result) << "!\n";
+		os_ << "[sqlite_con] SQL = '" << sql.c_str() << "'.\n";
+		return false;
+	}
+	result=sqlite3_step(stmt);
+
+	if(result!=SQLITE_DONE)
+	{
+		os_ << log_error << "[sqlite_con] Create_table (step) ERROR: " << sqlite_result(result) << "!\n";
+		return false;
+	}
+	sqlite3_finalize(stmt);
+
+	if(verbose)
+		os_ << "[sqlite_con] Table creation success.\n";
+
+	return true;
+}
+
+bool sqlite_con::drop_table(const string& tablename)
+{
+	sql.str("");
+	sql << "DROP TABLE IF EXISTS " << tablename << ";";
+	result=sqlite3_exec(db,sql.str().c_str(),0,0,0);
+
+	if(result != SQLITE_OK)
+	{
+		if(verbose)
+			os_ << log_error << "[sqlite_con] drop_table '" << tablename << "' ERROR: " << sqlite_result(result) << "!\n";
+
+		return false;
+	}
+
+	if(verbose)
+		os_ << "[sqlite_con] drop_table '" << tablename << "' success.\n";
+
+	return true;
+}
+
+bool sqlite_con::create_index(const string &indexname, const string &tablename, const char *colnames)
+{
+	if(con_status != CON_OPEN)
+	{
+		os_ << log_error << "[sqlite_con] create_index ERROR: Database connection is closed!\n";
+		os_ << "[sqlite_con] Table: '" << tablename << "\tIndex: '" << indexname << "'\n";
+		return false;
+	}
+
+	stringstream sql;
+	sql << "CREATE INDEX IF NOT EXISTS ";
+	sql << indexname;
+	sql << " on " << tablename;
+	sql << " (" << colnames << ");";
+
+	cached_stmt cs = get_cached_stmt(sql.str());
+	if(!cs)
+		return false;
+	result = sqlite3_step(cs.get());
+
+	if(result == SQLITE_DONE)
+	{
+		if(verbose)
+			os_ << "[sqlite_con] Created index '" << indexname << "' on table '" << tablename << "'\n";
+		return true;
+	}
+
+	os_ << log_error << "[sqlite_con] create_index ERROR: " << sqlite_result(result) << "!\n";
+	os_ << "[sqlite_con] Indexname '" << indexname << "' on table '" << tablename << "'.\n";
+	return false;
+}
+
+unsigned long int sqlite_con::get_max_id_val(const string &tablename)
+{
+	sqlite3_int64 max = 0;
+	if(!get_int_value("SELECT COALESCE(max(id),0) FROM " + tablename + ";", max))
+	{
+		os_ << log_error << "[sqlite_con] get_max_id_val ERROR on table '" << tablename << "'.\n";
+		return 0;
+	}
+	return (unsigned long) max;
+}
+
+long sqlite_con::get_count_value(const string &sql)
+{
+	sqlite3_int64 count = 0;
+	if(!get_int_value(sql, count))
+		return -1;
+	return (long) count;
+}
+
+// Steps cached statement to first result row
+bool sqlite_con::step_scalar(const string &caller, const string &sql, cached_stmt &cs)
+{
+	cs = get_cached_stmt(sql);
+	if(!cs)
+		return false;
+
+	result = sqlite3_step(cs.get());
+	if(result != SQLITE_ROW)
+	{
+		os_ << log_error << "[sqlite_con] " << caller << " ERROR: " << (result == SQLITE_DONE ? "No result row" : sqlite_result(result)) << "\n";
+		os_ << log_error << "sql: '" << sql << "'\n";
+		return false;
+	}
+
+	if(sqlite3_column_count(cs.get()) != 1)
+	{
+		os_ << log_error << "[sqlite_con] " << caller << " ERROR: Wrong result dimension: ncols=" << sqlite3_column_count(cs.get()) << "\n";
+		return false;
+	}
+	return true;
+}
+
+bool sqlite_con::get_int_value(const string &sql, sqlite3_int64 &value)
+{
+	cached_stmt cs;
+	if(!step_scalar("get_int_value", sql, cs))
+		return false;
+
+	value = sqlite3_column_int64(cs.get(), 0);
+	return true;
+}
+
+bool sqlite_con::get_double_value(const string &sql, double &value)
+{
+	cached_stmt cs;
+	if(!step_scalar("get_double_value", sql, cs))
+		return false;
+
+	value = sqlite3_column_double(cs.get(), 0);
+	return true;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
+// Prepared statement cache
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
+
+cached_stmt sqlite_con::get_cached_stmt(const string &sql)
+{
+	if(con_status != CON_OPEN)
+	{
+		os_ << log_error << "[sqlite_con] get_cached_stmt ERROR: Database connection is closed!\n";
+		return cached_stmt();
+	}
+
+	unordered_map<string, stmt_list::iterator>::iterator iter = stmt_index.find(sql);
+	if(iter != stmt_index.end())
+	{
+		sqlite3_stmt *s = iter->second->second;
+		stmt_lru.erase(iter->second);
+		stmt_index.erase(iter);
+		return cached_stmt(this, sql, s);
+	}
+
+	sqlite3_stmt *s = 0;
+	result = sqlite3_prepare_v2(db, sql.c_str(), sql.size(), &s, 0);
+	if(result != SQLITE_OK)
+	{
+		os_ << log_error << "[sqlite_con] get_cached_stmt (prepare) ERROR: " << sqlite3_errmsg(db) << "\n";
+		os_ << log_error << "sql: '" << sql << "'\n";
+		sqlite3_finalize(s);
+		return cached_stmt();
+	}
+	return cached_stmt(this, sql, s);
+}
+
+void sqlite_con::return_cached_stmt(const string &sql, sqlite3_stmt *s)
+{
+	sqlite3_reset(s);
+	sqlite3_clear_bindings(s);
+
+	if(con_status != CON_OPEN || stmt_cache_size == 0 || stmt_index.count(sql))
+	{
+		sqlite3_finalize(s);
+		return;
+	}
+
+	stmt_lru.push_front(make_pair(sql, s));
+	stmt_index[sql] = stmt_lru.begin();
+	trim_stmt_cache();
+}
+
+void sqlite_con::set_stmt_cache_size(size_t n)
+{
+	stmt_cache_size = n;
+	trim_stmt_cache();
+}
+
+// Finalizes least recently used statements
+void sqlite_con::trim_stmt_cache()
+{
+	while(stmt_lru.size() > stmt_cache_size)
+	{
+		stmt_index.erase(stmt_lru.back().first);
+		sqlite3_finalize(stmt_lru.back().second);
+		stmt_lru.pop_back();
+	}
+}
+
+void sqlite_con::clear_stmt_cache()
+{
+	stmt_list::iterator iter;
+	for(iter = stmt_lru.begin(); iter != stmt_lru.end(); ++iter)
+		sqlite3_finalize(iter->second);
+	stmt_lru.clear();
+	stmt_index.clear();
+}
+
+void cached_stmt::release()
+{
+	if(stmt)
+		con->return_cached_stmt(sql, stmt);
+	con = 0;
+	stmt = 0;
+}
+
+cached_stmt & cached_stmt::operator=(cached_stmt &&rhs)
+{
+	if(this != &rhs)
+	{
+		release();
+		con = rhs.con;
+		sql = std::move(rhs.sql);
+		stmt = rhs.stmt;
+		rhs.con = 0;
+		rhs.stmt = 0;
+	}
+	return *this;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
+// Beginning, Committing and sql-based insert, callback-based extraction
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
+
+void sqlite_con::begin()
+{
+	if(com_status==COM_COMMITTED)
+	{
+		if(verbose)
+			os_ << "[sqlite_con] Begin Database transaction.\n";
+		sqlite3_exec(db,"BEGIN",0,0,0);
+		com_status=COM_BEGIN;
+	}
+}
+
+void sqlite_con::commit()
+{
+	if(com_status==COM_BEGIN)
+	{
+		sqlite3_exec(db,"COMMIT",0,0,0);
+		com_status=COM_COMMITTED;
+
+		if(verbose)
+			os_ << "[sqlite_con] Database transaction committed.\n";
+	}
+}
+
+void sqlite_con::rollback()
+{
+	if(com_status==COM_BEGIN)
+	{
+		sqlite3_exec(db,"ROLLBACK",0,0,0);
+		com_status=COM_COMMITTED;
+
+		if(verbose)
+			os_ << "[sqlite_con] Database transaction rolled back.\n";
+	}
+}
+
+unsigned long int sqlite_con::insert_sql(const string& sql)
+{
+	if(con_status != CON_OPEN)
+			return 0;
+
+	cached_stmt cs = get_cached_stmt(sql);
+	if(!cs)
+		return 0;
+	result = sqlite3_step(cs.get());
+
+	if(result==SQLITE_OK || result==SQLITE_DONE)
+	{
+		return sqlite3_last_insert_rowid(db);
+	} else
+	{
+		os_ << log_error << "[sqlite_con] Database Insert ERROR: " << sqlite_result(result) << "\n";
+		os_ << log_error << sql << "\n";
+	}
+	return 0;
+}
+
+bool sqlite_con::exec_callback(const string & sql,  int (*callback)(void*,int,char**,char**),void *v)
+{
+	char *exec_error=NULL;
+	result=sqlite3_exec(db, sql.c_str(), callback, v, &exec_error);
+
+	if(result != SQLITE_OK)
+	{
+		os_ << log_error << "[sqlite_con] exec_callback ERROR: " << exec_error << "\n";
+		os_ << log_error << sql << "\n";
+		return false;
+	}
+	sqlite3_free(exec_error);
+	return true;
+}
+
+bool sqlite_con::create_module(const string &name, const sqlite3_module *module, void *aux)
+{
+	if(con_status != CON_OPEN)
+	{
+		os_ << log_error << "[sqlite_con] create_module ERROR: Database connection is closed!\n";
+		return false;
+	}
+
+	result = sqlite3_create_module(db, name.c_str(), module, aux);
+	if(result != SQLITE_OK)
+	{
+		os_ << log_error << "[sqlite_con] create_module '" << name << "' ERROR: " << sqlite_result(result) << "\n";
+		return false;
+	}
+
+	if(verbose)
+		os_ << "[sqlite_con] Registered module '" << name << "'.\n";
+	return true;
+}
+
+// Registers deterministic scalar function (UTF-8 arguments)
+bool sqlite_con::create_function(const string &name, int n_args,
+		void (*func)(sqlite3_context*, int, sqlite3_value**), void *aux)
+{
+	if(con_status != CON_OPEN)
+	{
+		os_ << log_error << "[sqlite_con] create_function ERROR: Database connection is closed!\n";
+		return false;
+	}
+
+	result = sqlite3_create_function(db, name.c_str(), n_args,
+			SQLITE_UTF8 | SQLITE_DETERMINISTIC, aux, func, 0, 0);
+	if(result != SQLITE_OK)
+	{
+		os_ << log_error << "[sqlite_con] create_function '" << name << "' ERROR: " << sqlite_result(result) << "\n";
+		return false;
+	}
+
+	if(verbose)
+		os_ << "[sqlite_con] Registered function '" << name << "'.\n";
+	return true;
+}
+
+bool sqlite_con::get_db_status(int op, int &value, bool reset)
+{
+	if(con_status != CON_OPEN)
+		return false;
+
+	int hiwtr;
+	result = sqlite3_db_status(db, op, &value, &hiwtr, reset);
+	if(result != SQLITE_OK)
+	{
+		os_ << log_error << "[sqlite_con] get_db_status ERROR: " << sqlite_result(result) << "\n";
+		return false;
+	}
+	return true;
+}
+
+// Executes (semicolon separated) SQL statements which return no data
+bool sqlite_con::exec(const string & sql)
+{
+	char *exec_error=NULL;
+	result=sqlite3_exec(db, sql.c_str(), 0, 0, &exec_error);
+
+	if(result != SQLITE_OK)
+	{
+		os_ << log_error << "[sqlite_con] exec ERROR: " << (exec_error ? exec_error : sqlite_result(result).c_str()) << "\n";
+		os_ << log_error << sql << "\n";
+		sqlite3_free(exec_error);
+		return false;
+	}
+	return true;
+}
+
+string sqlite_con::sqlite_result(unsigned res)
+{
+	switch(res)
+	{
+		case SQLITE_OK:
+			return std::string("SQLITE_OK\t0\tSuccessful result");
+		/* beginning-of-error-codes */
+		case  SQLITE_ERROR:
+			return std::string("SQLITE_ERROR\t1\tSQL error or missing database");
+		case  SQLITE_INTERNAL:
+			return std::string("SQLITE_INTERNAL\2\tInternal logic error in SQLite");
+		case  SQLITE_PERM:
+			return std::string("SQLITE_PERM\3\tAccess permission denied");
+		case  SQLITE_ABORT:
+			return std::string("SQLITE_ABORT\t4\tCallback routine requested an abort");
+		case  SQLITE_BUSY:
+			return std::string("SQLITE_BUSY\t5\tThe database file is locked");
+		case  SQLITE_LOCKED:
+			return std::string("SQLITE_LOCKED\t6\tA table in the database is locked");
+		case  SQLITE_NOMEM:
+			return std::string("SQLITE_NOMEM\t7\tA malloc() failed");
+		case  SQLITE_READONLY:
+			return std::string("SQLITE_NOMEM\t8\tAttempt to write a readonly database");
+		case  SQLITE_INTERRUPT:
+			return std::string("SQLITE_INTERRUPT\t9\tOperation terminated by sqlite3_interrupt()");
+		case  SQLITE_IOERR:
+			return std::string("SQLITE_IOERR\t10\tSome kind of disk I/O error occurred");
+		case  SQLITE_CORRUPT:
+			return std::string("SQLITE_CORRUPT\t11\tThe database disk image is malformed");
+		case  SQLITE_NOTFOUND:
+			return std::string("SQLITE_NOTFOUND\t12\tNOT USED. Table or record not found");
+		case  SQLITE_FULL:
+			return std::string("SQLITE_FULL\t13\tInsertion failed because database is full");
+		case  SQLITE_CANTOPEN:
+			return std::string("SQLITE_CANTOPEN\t14\tUnable to open the database file");
+		case  SQLITE_PROTOCOL:
+			return std::string("SQLITE_PROTOCOL\t15\tDatabase lock protocol error");
+		case  SQLITE_EMPTY:
+			return std::string("SQLITE_EMPTY\t16\tDatabase is empty");
+		case  SQLITE_SCHEMA:
+			return std::string("SQLITE_SCHEMA\t17\tThe database schema changed");
+		case  SQLITE_TOOBIG:
+			return std::string("SQLITE_TOOBIG\t18\tString or BLOB exceeds size limit");
+		case  SQLITE_CONSTRAINT:
+			return std::string("SQLITE_CONSTRAINT\t19\tAbort due to constraint violation");
+		case  SQLITE_MISMATCH:
+			return std::string("SQLITE_MISMATCH\t20\tData type mismatch");
+		case  SQLITE_MISUSE:
+			return std::string("SQLITE_MISUSE\t21\tLibrary used incorrectly");
+		case  SQLITE_NOLFS:
+			return std::string("SQLITE_NOLFS\t22\tUses OS features not supported on host");
+		case  SQLITE_AUTH:
+			return std::string("SQLITE_AUTH\t23\tAuthorization denied");
+		case  SQLITE_FORMAT:
+			return std::string("SQLITE_FORMAT\t24\tAuxiliary database format error");
+		case  SQLITE_RANGE:
+			return std::string("SQLITE_RANGE\t25\t2nd parameter to sqlite3_bind out of range");
+		case  SQLITE_NOTADB:
+			return std::string("SQLITE_NOTADB\t26\tFile opened that is not a database file");
+		case  SQLITE_ROW:
+			return std::string("SQLITE_ROW\t100\tsqlite3_step() has another row ready");
+		case  SQLITE_DONE:
+			return std::string("SQLITE_DONE\t101\tsqlite3_step() has finished executing");
+		default:
+			return std::string("Undefined sqlite3 message");
+	}
+}
+
+
+} // namespace sqlite
@@ -0,0 +1,84 @@
+/*
+ * sqlite_cursor.h
+ *
+ *  Created on: 17.10.2026
+ *      Author: kaisers
+ *
+ *  Typed, step based read access to query results.
+ *  In contrast to sqlite_con::exec_callback, column values
+ *  are not converted into text representation.
+ *
+ *  sqlite_stmt stmt(con);
+ *  stmt.prepare("SELECT id, val FROM tbl;");
+ *  for(const sqlite_row &row : sqlite_cursor(stmt))
+ *  	sum += row.get_double(1);
+ */
+
+#ifndef SQLITE_CURSOR_H_
+#define SQLITE_CURSOR_H_
+
+#include "sqlite_stmt.h"
+
+namespace sqlite {
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
+// View on current result row of a prepared statement
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
+class sqlite_row {
+public:
+	sqlite_row(const sqlite_stmt &s) : stmt(s) {}
+
+	int size() const							{ return stmt.column_count(); }
+	int type(int col) const						{ return stmt.column_type(col); }
+	bool is_null(int col) const					{ return stmt.column_is_null(col); }
+	sqlite3_int64 get_int(int col) const		{ return stmt.column_int(col); }
+	double get_double(int col) const			{ return stmt.column_double(col); }
+	const char * get_text(int col) const		{ return stmt.column_text(col); }
+	const void * get_blob(int col) const		{ return stmt.column_blob(col); }
+	int get_bytes(int col) const				{ return stmt.column_bytes(col); }
+	sqlite3_value * get_value(int col) const	{ return stmt.column_value(col); }
+
+private:
+	const sqlite_stmt &stmt;
+};
+
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
+// Range over all result rows (single pass).
+// After the loop, stmt.is_done() tells whether all rows have been read
+// or iteration was stopped by an error.
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
+class sqlite_cursor {
+public:
+	class iterator {
+	public:
+		iterator(sqlite_stmt *s, const sqlite_stmt &r) : stmt(s), row(r) {}
+		iterator(const iterator &rhs) : stmt(rhs.stmt), row(rhs.row) {}
+
+		const sqlite_row & operator*() const { return row; }
+		const sqlite_row * operator->() const { return &row; }
+		iterator & operator++()
+		{
+			if(!stmt->fetch())
+				stmt = 0;
+			return *this;
+		}
+		bool operator!=(const iterator &rhs) const { return stmt != rhs.stmt; }
+		bool operator==(const iterator &rhs) const { return stmt == rhs.stmt; }
+
+	private:
+		sqlite_stmt *stmt;
+		sqlite_row row;
+	};
+
+	sqlite_cursor(sqlite_stmt &s) : stmt(s) {}
+
+	iterator begin() { iterator iter(&stmt, stmt); return ++iter; }
+	iterator end() { return iterator(0, stmt); }
+
+private:
+	sqlite_stmt &stmt;
+};
+
+} // namespace sqlite
+#endif /* SQLITE_CURSOR_H_ */
@@ -0,0 +1,322 @@
+/*
+ * sqlite_stmt.cpp
+ *
+ *  Created on: 17.10.2026
+ *      Author: kaisers
+ */
+
+#include "sqlite_stmt.h"
+
+#include <climits>
+#include <cmath>
+
+namespace sqlite {
+
+
+const int sqlite_stmt::STMT_UNPREP = 1;
+const int sqlite_stmt::STMT_PREPARED = 2;
+const int sqlite_stmt::STMT_FINALIZED = 3;
+
+sqlite_stmt::sqlite_stmt(const sqlite_stmt &rhs) : con(rhs.get_con()), result(0), auto_id(0)
+{
+	if(!con)
+	{
+		stmt_status = sqlite_stmt::STMT_FINALIZED;
+		stmt=0;
+		con.os_ << log_error << "[sqlite_stmt] copy_constructor error: connection is not open!\n";
+	}
+	else
+	{
+		stmt_status = rhs.stmt_status;
+		if(rhs.stmt_status == STMT_UNPREP)
+		{
+			stmt=0;
+		}
+		else
+		{
+			sql = rhs.sql;
+			result = sqlite3_prepare_v2(con.db, sql.c_str(), sql.length(), &stmt, 0);
+			if(result == SQLITE_OK)
+			{
+				stmt_status = STMT_PREPARED;
+			}
+			else
+			{
+				con.os_ << log_error << "[sqlite_stmt] copy_constructor prepare error: " << con.sqlite_result(result) << "\n";
+				con.os_ << log_error << "sql: " << sql << "\n";
+				result = sqlite3_finalize(stmt);
+				stmt = 0;
+				stmt_status = STMT_FINALIZED;
+			}
+		}
+	}
+}
+
+sqlite_stmt& sqlite_stmt::operator=(const sqlite_stmt &rhs)
+{
+	if(this == &rhs)
+		return *this;
+
+	sql=rhs.sql;
+	stmt_status=rhs.stmt_status;
+	con=rhs.get_con();
+
+	if(stmt!=0)
+	{
+		result=sqlite3_finalize(stmt);
+		stmt=0;
+	}
+
+	if(!con)
+	{
+		stmt_status = STMT_FINALIZED;
+		con.os_ << log_error << "[sqlite_stmt] operator=: sqlite connection is not open!\n";
+		return *this;
+	}
+
+	if(stmt_status == STMT_PREPARED)
+	{
+		sql=rhs.sql;
+		result=sqlite3_prepare_v2(con.db,sql.c_str(),sql.length(),&stmt,0);
+		if(result == SQLITE_OK)
+		{
+	       stmt_status=STMT_PREPARED;
+
+		}else
+		{
+			con.os_ << log_error << "[sqlite_stmt] operator= prepare error: " << con.sqlite_result(result) << "\n";
+			con.os_ << log_error << "sql: " << sql << "\n";
+	        result = sqlite3_finalize(stmt);
+	        stmt = 0;
+	        stmt_status = STMT_FINALIZED;
+		}
+	}
+	return *this;
+}
+
+
+sqlite_stmt::~sqlite_stmt()
+{
+	if(stmt_status!=STMT_FINALIZED)
+        sqlite3_finalize(stmt);
+}
+
+bool sqlite_stmt::prepare(const string &sql_txt)
+{
+	if(!con)
+		return false;
+
+	if(stmt_status == STMT_FINALIZED)
+	{
+		con.os_ << log_error << "[sqlite_stmt] prepare error: stmt_status=STMT_FINALIZED!\n";
+		return false;
+	}
+
+	result = sqlite3_prepare_v2(con.db,sql_txt.c_str(),sql_txt.length(),&stmt,0);
+	if(result == SQLITE_OK)
+	{
+       stmt_status=STMT_PREPARED;
+       return true;
+	}else
+	{
+		con.os_ << log_error << "[sqlite_stmt] prepare error: " << con.sqlite_result(result) << "\n";
+		con.os_ << log_error << "sql: " << sql_txt << "\n";
+        result = sqlite3_finalize(stmt);
+        stmt = 0;
+        stmt_status = STMT_FINALIZED;
+	}
+    return false;
+}
+
+bool sqlite_stmt::step()
+{
+	if(!con)
+		return false;
+
+	if(stmt_status != STMT_PREPARED)
+    {
+		con.os_ << log_error << "[sqlite_stmt] step NOT EXECUTED because stmt_status!=STMT_PREPARED!\n";
+		return false;
+    }
+	result = sqlite3_step(stmt);
+	if(result != SQLITE_DONE)
+	{
+		if(con.row_errors.admit())
+			con.os_ << log_error << "[sqlite_stmt] step error: " << con.sqlite_result(result) << "\n";
+		return false;
+	}
+	result = sqlite3_reset(stmt);
+	if(result != SQLITE_OK)
+	{
+		if(con.row_errors.admit())
+			con.os_ << log_error << "[sqlite_stmt] step reset error: " << con.sqlite_result(result) << "\n";
+		return false;
+	}
+	return true;
+}
+
+// Steps a query statement and makes the next result row accessible
+// via the column_* functions. Returns false when the result set is
+// exhausted (is_done() is then true) or on error.
+bool sqlite_stmt::fetch()
+{
+	if(!con)
+		return false;
+
+	if(stmt_status != STMT_PREPARED)
+	{
+		con.os_ << log_error << "[sqlite_stmt] fetch NOT EXECUTED because stmt_status!=STMT_PREPARED!\n";
+		return false;
+	}
+
+	result = sqlite3_step(stmt);
+	if(result == SQLITE_ROW)
+		return true;
+
+	if(result != SQLITE_DONE)
+	{
+		if(con.row_errors.admit())
+			con.os_ << log_error << "[sqlite_stmt] fetch error: " << con.sqlite_result(result) << "\n";
+		sqlite3_reset(stmt);
+		return false;
+	}
+
+	// Statement can be re-used with new bindings
+	sqlite3_reset(stmt);
+	return false;
+}
+
+// Stops iteration over result rows (bindings are retained)
+bool sqlite_stmt::reset()
+{
+	if(stmt_status != STMT_PREPARED)
+		return false;
+
+	sqlite3_reset(stmt);
+	return true;
+}
+
+bool sqlite_stmt::step(const unsigned &pos, const vector<unsigned long int> &v)
+{
+	if( (stmt==0) || (stmt_status != STMT_PREPARED) )
+	{
+		con.os_ << log_error << "[sqlite_stmt] step(vector) ERROR: stmt==0 or stmt_status!=STMT_PREPARED!\n";
+		return false;
+	}
+
+	unsigned long int i;
+	for(i=0; i<v.size(); ++i)
+	{
+		result = sqlite3_bind_int64(stmt, pos, v[i]);
+		if(result != SQLITE_OK)
+		{
+			if(con.row_errors.admit())
+				con.os_ << log_error << "[sqlite_stmt] step(vector) bind ERROR i=" << i << " and v[i]=" << v[i] << ": " << con.sqlite_result(result) << "\n";
+			return false;
+		}
+
+		result = sqlite3_step(stmt);
+		if(result != SQLITE_DONE)
+		{
+			if(con.row_errors.admit())
+				con.os_ << log_error << "[sqlite_stmt] step(vector) step ERROR i=" << i << " and v[i]=" << v[i] << ": " << con.sqlite_result(result) << "\n";
+			return false;
+		}
+
+		result = sqlite3_reset(stmt);
+		if(result != SQLITE_OK)
+		{
+			if(con.row_errors.admit())
+				con.os_ << log_error << "[sqlite_stmt] step(vector) reset ERROR i=" << i << " and v[i]=" << v[i] << ": " << con.sqlite_result(result) << "\n";
+			return false;
+		}
+	}
+	return true;
+}
+
+
+bool sqlite_stmt::step(const vector<column_buffer> &cols, size_t first, unsigned nrows)
+{
+	if( (stmt==0) || (stmt_status != STMT_PREPARED) )
+	{
+		con.os_ << log_error << "[sqlite_stmt] step(columns) ERROR: stmt==0 or stmt_status!=STMT_PREPARED!\n";
+		return false;
+	}
+
+	// Parameter of row r and column c: r * n_cols + c + 1
+	unsigned c, r, n_cols = cols.size();
+	int pos, bytes;
+	for(c = 0; c < n_cols; ++c)
+	{
+		const column_buffer &col = cols[c];
+		result = SQLITE_OK;
+		pos = c + 1;
+
+		if(col.type == column_buffer::BUF_INT)
+		{
+			const int *v = col.ints + first;
+			for(r = 0; r < nrows && result == SQLITE_OK; ++r, pos += n_cols)
+			{
+				if(v[r] == INT_MIN)
+					result = sqlite3_bind_null(stmt, pos);
+				else
+					result = sqlite3_bind_int(stmt, pos, v[r]);
+			}
+		}
+		else if(col.type == column_buffer::BUF_DOUBLE)
+		{
+			const double *v = col.doubles + first;
+			for(r = 0; r < nrows && result == SQLITE_OK; ++r, pos += n_cols)
+			{
+				if(std::isnan(v[r]))
+					result = sqlite3_bind_null(stmt, pos);
+				else
+					result = sqlite3_bind_double(stmt, pos, v[r]);
+			}
+		}
+		else
+		{
+			for(r = 0; r < nrows && result == SQLITE_OK; ++r, pos += n_cols)
+			{
+				const char *text = col.text(col.ctx, first + r, bytes);
+				if(text)
+					result = sqlite3_bind_text(stmt, pos, text, bytes, SQLITE_STATIC);
+				else
+					result = sqlite3_bind_null(stmt, pos);
+			}
+		}
+
+		if(result != SQLITE_OK)
+		{
+			if(con.row_errors.admit())
+				con.os_ << log_error << "[sqlite_stmt] step(columns) bind ERROR in column " << c
+					<< ": " << con.sqlite_result(result) << "\n";
+			return false;
+		}
+	}
+	return step();
+}
+
+
+bool sqlite_stmt::finalize()
+{
+	if(!stmt)
+		return true;
+
+	if(stmt_status != STMT_FINALIZED)
+    {
+        result = sqlite3_finalize(stmt);
+        if(result != SQLITE_OK)
+        {
+			con.os_ << log_error << "[sqlite_stmt] Finalize ERROR: " << con.sqlite_result(result) << "\n";
+			return false;
+        }
+
+        stmt = 0;
+        stmt_status = STMT_FINALIZED;
+    }
+    return true;
+}
+
+
+} // namespace sqlite
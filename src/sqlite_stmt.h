@@ -18,6 +18,31 @@ using namespace std;
 
 namespace sqlite {
 
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
+// Column-major typed buffer: Values of one column for consecutive rows
+// (see sqlite_stmt::step(columns, ...)). NULL values:
+// BUF_INT		: INT_MIN (= NA_integer_ in R)
+// BUF_DOUBLE	: NaN
+// BUF_TEXT		: text() returns 0
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
+struct column_buffer
+{
+	enum { BUF_INT, BUF_DOUBLE, BUF_TEXT };
+
+	// Text of row i and its size in bytes. Text must remain valid
+	// until the statement has been stepped (bound without copy).
+	typedef const char * (*text_fn)(const void *ctx, size_t i, int &bytes);
+
+	column_buffer() : type(BUF_INT), ints(0), doubles(0), text(0), ctx(0) {}
+
+	int type;
+	const int *ints;
+	const double *doubles;
+	text_fn text;
+	const void *ctx;			// Passed to text()
+};
+
+
 class sqlite_stmt {
 public:
 	sqlite_stmt(sqlite_con &c) : con(c), stmt(0), stmt_status(STMT_UNPREP), result(0), auto_id(0) {}
@@ -31,6 +56,7 @@ public:
 	// Does *NOT* garantee no-reuse!
 	unsigned long getAutoId() { return ++auto_id; }
 	void setAutoId(unsigned long id) { auto_id = id; }
+	unsigned long lastAutoId() const { return auto_id; }
 	bool prepare(const string &sql);
 
 	///////////////////////////////////////////////////////////////////////////////////////////////
@@ -42,33 +68,46 @@ public:
 
 		if(stmt_status == STMT_FINALIZED)
 		{
-			con.os_ << "[sqlite_stmt] bind_int ERROR: Statement is FINALIZED!\n";
+			if(con.row_errors.admit())
+				con.os_ << log_error << "[sqlite_stmt] bind_int ERROR: Statement is FINALIZED!\n";
 			return false;
 		}
 
 		result = sqlite3_bind_int64(stmt,pos,value);
 		if(result != SQLITE_OK)
 		{
-			con.os_ << "[sqlite_stmt] bind_int ERROR: " << con.sqlite_result(result) << "\n";
+			if(con.row_errors.admit())
+				con.os_ << log_error << "[sqlite_stmt] bind_int ERROR: " << con.sqlite_result(result) << "\n";
 			return false;
 		}
 		return true;
 	}
 
+	// Signed 64 bit values (rowids, copied INTEGER values):
+	// unsigned long has only 32 bits on LLP64 (Windows)
+	bool bind_int64(unsigned pos, sqlite3_int64 value)
+	{
+		if(!con)
+			return false;
+		return bind_result("bind_int64", sqlite3_bind_int64(stmt, pos, value));
+	}
+
 	bool bind_double(unsigned pos, const double &value)
 	{
 		if(!con)
 			return false;
 		if(stmt_status==STMT_FINALIZED)
 		{
-			con.os_ << "[sqlite_stmt] bind_double ERROR: Statement is FINALIZED!\n";
+			if(con.row_errors.admit())
+				con.os_ << log_error << "[sqlite_stmt] bind_double ERROR: Statement is FINALIZED!\n";
 			return false;
 		}
 
 		result=sqlite3_bind_double(stmt,pos,value);
 		if(result!=SQLITE_OK)
 		{
-			con.os_ << "[sqlite_stmt] bind_double ERROR: " << con.sqlite_result(result) << "\n";
+			if(con.row_errors.admit())
+				con.os_ << log_error << "[sqlite_stmt] bind_double ERROR: " << con.sqlite_result(result) << "\n";
 			return false;
 		}
 		return true;
@@ -82,14 +121,16 @@ public:
 
 		if(stmt_status == STMT_FINALIZED)
 		{
-			con.os_ << "[sqlite_stmt] bind_text ERROR: Statement is FINALIZED!\n";
+			if(con.row_errors.admit())
+				con.os_ << log_error << "[sqlite_stmt] bind_text ERROR: Statement is FINALIZED!\n";
 			return false;
 		}
 
 		result = sqlite3_bind_text(stmt, pos, text.c_str(), text.size(), SQLITE_TRANSIENT);
 		if(result!=SQLITE_OK)
 		{
-			con.os_ << "[sqlite_stmt] bind_text ERROR: " << con.sqlite_result(result) << "\n";
+			if(con.row_errors.admit())
+				con.os_ << log_error << "[sqlite_stmt] bind_text ERROR: " << con.sqlite_result(result) << "\n";
 			return false;
 		}
 		return true;
@@ -101,235 +142,126 @@ public:
 
 		if(stmt_status == STMT_FINALIZED)
 		{
-			con.os_ << "[sqlite_stmt] bind_text ERROR: stmt_status=STMT_FINALIZED!\n";
+			if(con.row_errors.admit())
+				con.os_ << log_error << "[sqlite_stmt] bind_text ERROR: stmt_status=STMT_FINALIZED!\n";
 			return false;
 		}
 
 		result=sqlite3_bind_text(stmt,pos,text,strlen(text),SQLITE_TRANSIENT);
 		if(result!=SQLITE_OK)
 		{
-			con.os_ << "[sqlite_stmt] bind_text ERROR: " << con.sqlite_result(result) << "\n";
+			if(con.row_errors.admit())
+				con.os_ << log_error << "[sqlite_stmt] bind_text ERROR: " << con.sqlite_result(result) << "\n";
 			return false;
 		}
 		return true;
 	}
 
 
-
-	bool step();
-	bool step(const unsigned &pos, const vector<unsigned long int> &v);
-	bool finalize();
-	friend class align_con;
-
-private:
-	sqlite_con &con;
-	sqlite3_stmt *stmt;
-	string sql;
-	int stmt_status;
-	int result;
-	unsigned long int auto_id;
-
-	static const int STMT_UNPREP;
-	static const int STMT_PREPARED;
-	static const int STMT_FINALIZED;
-};
-
-const int sqlite_stmt::STMT_UNPREP = 1;
-const int sqlite_stmt::STMT_PREPARED = 2;
-const int sqlite_stmt::STMT_FINALIZED = 3;
-
-sqlite_stmt::sqlite_stmt(const sqlite_stmt &rhs) : con(rhs.get_con()), result(0), auto_id(0)
-{
-	if(!con)
+	// Text or blob of n bytes. is_static: Value is not copied (SQLITE_STATIC),
+	// memory must remain valid until the statement has been stepped and
+	// the parameter is bound again (or the statement is finalized).
+	bool bind_text(unsigned pos, const char *text, int n, bool is_static)
 	{
-		stmt_status = sqlite_stmt::STMT_FINALIZED;
-		stmt=0;
-		con.os_ << "[sqlite_stmt] copy_constructor error: connection is not open!\n";
+		return bind_result("bind_text",
+				sqlite3_bind_text(stmt, pos, text, n, is_static ? SQLITE_STATIC : SQLITE_TRANSIENT));
 	}
-	else
-	{
-		stmt_status = rhs.stmt_status;
-		if(rhs.stmt_status == STMT_UNPREP)
-		{
-			stmt=0;
-		}
-		else
-		{
-			sql = rhs.sql;
-			result = sqlite3_prepare_v2(con.db, sql.c_str(), sql.length(), &stmt, 0);
-			if(result == SQLITE_OK)
-			{
-				stmt_status = STMT_PREPARED;
-			}
-			else
-			{
-				con.os_ << "[sqlite_stmt] copy_constructor prepare error: " << con.sqlite_result(result) << "\n";
-				con.os_ << "sql: " << sql << "\n";
-				result = sqlite3_finalize(stmt);
-				stmt = 0;
-				stmt_status = STMT_FINALIZED;
-			}
-		}
-	}
-}
 
-sqlite_stmt& sqlite_stmt::operator=(const sqlite_stmt &rhs)
-{
-	if(this == &rhs)
-		return *this;
-
-	sql=rhs.sql;
-	stmt_status=rhs.stmt_status;
-	con=rhs.get_con();
-
-	if(stmt!=0)
+	bool bind_blob(unsigned pos, const void *data, int n, bool is_static)
 	{
-		result=sqlite3_finalize(stmt);
-		stmt=0;
+		return bind_result("bind_blob",
+				sqlite3_bind_blob(stmt, pos, data, n, is_static ? SQLITE_STATIC : SQLITE_TRANSIENT));
 	}
 
-	if(!con)
+	// Native value (e.g. column_value of another statement): Keeps type,
+	// text and blob values are copied by SQLite
+	bool bind_value(unsigned pos, const sqlite3_value *value)
 	{
-		stmt_status = STMT_FINALIZED;
-		con.os_ << "[sqlite_stmt] operator=: sqlite connection is not open!\n";
-		return *this;
+		return bind_result("bind_value", sqlite3_bind_value(stmt, pos, value));
 	}
 
-	if(stmt_status == STMT_PREPARED)
+	bool bind_null(const unsigned &pos)
 	{
-		sql=rhs.sql;
-		result=sqlite3_prepare_v2(con.db,sql.c_str(),sql.length(),&stmt,0);
-		if(result == SQLITE_OK)
-		{
-	       stmt_status=STMT_PREPARED;
+		if(!con)
+			return false;
 
-		}else
+		if(stmt_status == STMT_FINALIZED)
 		{
-			con.os_ << "[sqlite_stmt] operator= prepare error: " << con.sqlite_result(result) << "\n";
-			con.os_ << "sql: " << sql << "\n";
-	        result = sqlite3_finalize(stmt);
-	        stmt = 0;
-	        stmt_status = STMT_FINALIZED;
+			if(con.row_errors.admit())
+				con.os_ << log_error << "[sqlite_stmt] bind_null ERROR: Statement is FINALIZED!\n";
+			return false;
 		}
-	}
-	return *this;
-}
-
 
-
-sqlite_stmt::~sqlite_stmt()
-{
-	if(stmt_status!=STMT_FINALIZED)
-        sqlite3_finalize(stmt);
-}
-
-bool sqlite_stmt::prepare(const string &sql_txt)
-{
-	if(!con)
-		return false;
-
-	if(stmt_status == STMT_FINALIZED)
-	{
-		con.os_ << "[sqlite_stmt] prepare error: stmt_status=STMT_FINALIZED!\n";
-		return false;
-	}
-
-	result = sqlite3_prepare_v2(con.db,sql_txt.c_str(),sql_txt.length(),&stmt,0);
-	if(result == SQLITE_OK)
-	{
-       stmt_status=STMT_PREPARED;
-       return true;
-	}else
-	{
-		con.os_ << "[sqlite_stmt] prepare error: " << con.sqlite_result(result) << "\n";
-		con.os_ << "sql: " << sql_txt << "\n";
-        result = sqlite3_finalize(stmt);
-        stmt = 0;
-        stmt_status = STMT_FINALIZED;
+		result = sqlite3_bind_null(stmt, pos);
+		if(result != SQLITE_OK)
+		{
+			if(con.row_errors.admit())
+				con.os_ << log_error << "[sqlite_stmt] bind_null ERROR: " << con.sqlite_result(result) << "\n";
+			return false;
+		}
+		return true;
 	}
-    return false;
-}
 
-bool sqlite_stmt::step()
-{
-	if(!con)
-		return false;
+	///////////////////////////////////////////////////////////////////////////////////////////////
+	// Inline definition of column access functions.
+	// Valid after fetch() has returned true (i.e. for SELECT statements)
+	int column_count() const					{ return sqlite3_column_count(stmt); }
+	int column_type(int col) const				{ return sqlite3_column_type(stmt, col); }
+	bool column_is_null(int col) const			{ return sqlite3_column_type(stmt, col) == SQLITE_NULL; }
+	sqlite3_int64 column_int(int col) const		{ return sqlite3_column_int64(stmt, col); }
+	double column_double(int col) const			{ return sqlite3_column_double(stmt, col); }
+	const char * column_text(int col) const		{ return (const char*) sqlite3_column_text(stmt, col); }
+	int column_bytes(int col) const				{ return sqlite3_column_bytes(stmt, col); }
+	const char * column_name(int col) const		{ return sqlite3_column_name(stmt, col); }
+	const char * column_decltype(int col) const	{ return sqlite3_column_decltype(stmt, col); }
+	const void * column_blob(int col) const		{ return sqlite3_column_blob(stmt, col); }
+	sqlite3_value * column_value(int col) const	{ return sqlite3_column_value(stmt, col); }
+
+	// Statement counters (e.g. SQLITE_STMTSTATUS_SORT, see sqlite3_stmt_status)
+	int status(int op, bool reset=false) const	{ return stmt ? sqlite3_stmt_status(stmt, op, reset) : 0; }
 
-	if(stmt_status != STMT_PREPARED)
-    {
-		con.os_ << "[sqlite_stmt] step NOT EXECUTED because stmt_status!=STMT_PREPARED!\n";
-		return false;
-    }
-	result = sqlite3_step(stmt);
-	if(result != SQLITE_DONE)
-	{
-		con.os_ << "[sqlite_stmt] step error: " << con.sqlite_result(result) << "\n";
-		return false;
-	}
-	result = sqlite3_reset(stmt);
-	if(result != SQLITE_OK)
-	{
-		con.os_ << "[sqlite_stmt] step reset error: " << con.sqlite_result(result) << "\n";
-		return false;
-	}
-	return true;
-}
+	bool step();
+	bool step(const unsigned &pos, const vector<unsigned long int> &v);
 
-bool sqlite_stmt::step(const unsigned &pos, const vector<unsigned long int> &v)
-{
-	if( (stmt==0) || (stmt_status != STMT_PREPARED) )
-	{
-		con.os_ << "[sqlite_stmt] step(vector) ERROR: stmt==0 or stmt_status!=STMT_PREPARED!\n";
-		return false;
-	}
+	// Statement with nrows value tuples of cols.size() parameters:
+	// Binds rows first .. first + nrows - 1 column by column and steps once.
+	bool step(const vector<column_buffer> &cols, size_t first, unsigned nrows);
+	bool fetch();
+	bool is_done() const { return result == SQLITE_DONE; }
+	bool reset();
+	bool finalize();
+	friend class align_con;
 
-	unsigned long int i;
-	for(i=0; i<v.size(); ++i)
+private:
+	// Result of sqlite3_bind_* (statement status is checked afterwards:
+	// binding to a finalized statement returns SQLITE_MISUSE)
+	bool bind_result(const char *name, int res)
 	{
-		result = sqlite3_bind_int64(stmt, pos, v[i]);
-		if(result != SQLITE_OK)
-		{
-			con.os_ << "[sqlite_stmt] step(vector) bind ERROR i=" << i << " and v[i]=" << v[i] << ": " << con.sqlite_result(result) << "\n";
-			return false;
-		}
-
-		result = sqlite3_step(stmt);
-		if(result != SQLITE_DONE)
-		{
-			con.os_ << "[sqlite_stmt] step(vector) step ERROR i=" << i << " and v[i]=" << v[i] << ": " << con.sqlite_result(result) << "\n";
-			return false;
-		}
+		result = res;
+		if(result == SQLITE_OK)
+			return true;
 
-		result = sqlite3_reset(stmt);
-		if(result != SQLITE_OK)
+		if(con.row_errors.admit())
 		{
-			con.os_ << "[sqlite_stmt] step(vector) reset ERROR i=" << i << " and v[i]=" << v[i] << ": " << con.sqlite_result(result) << "\n";
-			return false;
+			if(stmt_status == STMT_FINALIZED)
+				con.os_ << log_error << "[sqlite_stmt] " << name << " ERROR: Statement is FINALIZED!\n";
+			else
+				con.os_ << log_error << "[sqlite_stmt] " << name << " ERROR: " << con.sqlite_result(result) << "\n";
 		}
+		return false;
 	}
-	return true;
-}
-
 
-bool sqlite_stmt::finalize()
-{
-	if(!stmt)
-		return true;
-
-	if(stmt_status != STMT_FINALIZED)
-    {
-        result = sqlite3_finalize(stmt);
-        if(result != SQLITE_OK)
-        {
-			con.os_ << "[sqlite_stmt] Finalize ERROR: " << con.sqlite_result(result) << "\n";
-			return false;
-        }
+	sqlite_con &con;
+	sqlite3_stmt *stmt;
+	string sql;
+	int stmt_status;
+	int result;
+	unsigned long int auto_id;
 
-        stmt = 0;
-        stmt_status = STMT_FINALIZED;
-    }
-    return true;
-}
+	static const int STMT_UNPREP;
+	static const int STMT_PREPARED;
+	static const int STMT_FINALIZED;
+};
 
 
 } // namespace sqlite
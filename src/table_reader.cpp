@@ -0,0 +1,289 @@
+/*
+ * table_reader.cpp
+ *
+ *  Created on: 17.10.2026
+ *      Author: kaisers
+ */
+
+#include "table_reader.h"
+
+#include <sstream>
+#include <algorithm>
+#include <climits>
+
+namespace sqlite {
+
+
+string read_spec::select_sql() const
+{
+	stringstream sql;
+	sql << "SELECT ";
+	if(columns.empty())
+		sql << "*";
+
+	size_t j;
+	for(j = 0; j < columns.size(); ++j)
+		sql << (j ? ", " : "") << columns[j];
+
+	sql << " FROM " << table;
+	if(where.size())
+		sql << " WHERE " << where;
+	sql << ";";
+	return sql.str();
+}
+
+string read_spec::count_sql() const
+{
+	string sql = "SELECT COUNT(*) FROM " + table;
+	if(where.size())
+		sql += " WHERE " + where;
+	return sql + ";";
+}
+
+
+bool table_reader::open(const read_spec &spec, double n_hint)
+{
+	if(!con)
+		return false;
+
+	n_expected = n_hint > 0 ? n_hint : -1;
+	n_read = 0;
+
+	if(n_hint < 0)
+	{
+		sqlite_stmt count(con);
+		if(!count.prepare(spec.count_sql()) || !count.fetch())
+		{
+			con.getos() << log_error << "[table_reader] Cannot count rows of table '" << spec.table << "'!\n";
+			return false;
+		}
+		n_expected = (double) count.column_int(0);
+		count.finalize();
+	}
+
+	if(!stmt.prepare(spec.select_sql()))
+		return false;
+
+	// First row is fetched for types of undeclared columns
+	has_row = stmt.fetch();
+	if(!has_row && !stmt.is_done())
+		return false;
+
+	set_types();
+	return true;
+}
+
+
+void table_reader::set_types()
+{
+	int j, n_cols = stmt.column_count();
+	names.clear();
+	types.clear();
+
+	for(j = 0; j < n_cols; ++j)
+	{
+		names.push_back(stmt.column_name(j));
+		int type = decltype_to_sexptype(stmt.column_decltype(j));
+		if(type == NILSXP && has_row)
+		{
+			switch(stmt.column_type(j))
+			{
+				case SQLITE_INTEGER:	type = INTSXP; break;
+				case SQLITE_FLOAT:		type = REALSXP; break;
+			}
+		}
+		types.push_back(type == NILSXP ? STRSXP : type);
+	}
+}
+
+
+SEXP table_reader::alloc_frame(R_xlen_t n_rows)
+{
+	unsigned j, n_cols = types.size();
+	SEXP pDf = PROTECT(allocVector(VECSXP, n_cols));
+	SEXP pNames = PROTECT(allocVector(STRSXP, n_cols));
+
+	cols.resize(n_cols);
+	for(j = 0; j < n_cols; ++j)
+	{
+		cols[j] = allocVector(types[j], n_rows);
+		SET_VECTOR_ELT(pDf, j, cols[j]);
+		SET_STRING_ELT(pNames, j, mkCharCE(names[j].c_str(), CE_UTF8));
+	}
+	setAttrib(pDf, R_NamesSymbol, pNames);
+	UNPROTECT(2);
+	return pDf;
+}
+
+void table_reader::resize(SEXP pDf, R_xlen_t n_rows)
+{
+	unsigned j;
+	for(j = 0; j < cols.size(); ++j)
+	{
+		cols[j] = xlengthgets(cols[j], n_rows);
+		SET_VECTOR_ELT(pDf, j, cols[j]);
+	}
+}
+
+// Integer column continues as double (REAL value or value outside
+// of R integer range)
+void table_reader::promote(SEXP pDf, unsigned col, R_xlen_t n_rows)
+{
+	SEXP pInt = cols[col];
+	R_xlen_t i, n = XLENGTH(pInt);
+
+	cols[col] = allocVector(REALSXP, n);
+	const int *v = INTEGER(pInt);
+	double *p = REAL(cols[col]);
+	for(i = 0; i < n_rows; ++i)
+		p[i] = (v[i] == NA_INTEGER) ? NA_REAL : (double) v[i];
+
+	SET_VECTOR_ELT(pDf, col, cols[col]);
+	types[col] = REALSXP;
+}
+
+
+void table_reader::store(SEXP pDf, R_xlen_t i)
+{
+	unsigned j;
+	for(j = 0; j < cols.size(); ++j)
+	{
+		int type = stmt.column_type(j);
+		bool is_null = (type == SQLITE_NULL);
+		if(types[j] == INTSXP)
+		{
+			if(is_null)
+			{
+				INTEGER(cols[j])[i] = NA_INTEGER;
+				continue;
+			}
+
+			if(type != SQLITE_FLOAT)
+			{
+				sqlite3_int64 v = stmt.column_int(j);
+				if(v <= INT_MAX && v > INT_MIN)
+				{
+					INTEGER(cols[j])[i] = (int) v;
+					continue;
+				}
+			}
+			promote(pDf, j, i);
+		}
+
+		if(types[j] == REALSXP)
+			REAL(cols[j])[i] = is_null ? NA_REAL : stmt.column_double(j);
+		else
+		{
+			if(is_null)
+				SET_STRING_ELT(cols[j], i, NA_STRING);
+			else
+			{
+				const char *text = stmt.column_text(j);
+				SET_STRING_ELT(cols[j], i, mkCharLenCE(text, stmt.column_bytes(j), CE_UTF8));
+			}
+		}
+	}
+}
+
+
+SEXP table_reader::read(R_xlen_t max_rows)
+{
+	// Remaining rows (< 0: unknown)
+	double remaining = n_expected < 0 ? -1 : std::max(n_expected - n_read, 0.0);
+	R_xlen_t capacity, n_rows = 0;
+
+	if(remaining < 0)
+		capacity = max_rows ? max_rows : 1024;
+	else if(max_rows)
+		capacity = (R_xlen_t) std::min((double) max_rows, remaining);
+	else
+		capacity = (R_xlen_t) remaining;
+
+	SEXP pDf = PROTECT(alloc_frame(capacity));
+
+	while(has_row && (max_rows == 0 || n_rows < max_rows))
+	{
+		// Expected number of rows exceeded
+		if(n_rows == capacity)
+		{
+			capacity = std::max(2 * capacity, (R_xlen_t) 1024);
+			if(max_rows)
+				capacity = std::min(capacity, max_rows);
+			resize(pDf, capacity);
+		}
+
+		store(pDf, n_rows);
+		++n_rows;
+
+		has_row = stmt.fetch();
+		if(!has_row && !stmt.is_done())
+		{
+			UNPROTECT(1);
+			return 0;
+		}
+	}
+
+	if(n_rows < capacity)
+		resize(pDf, n_rows);
+
+	set_data_frame_attributes(pDf, n_rows);
+	n_read += n_rows;
+	UNPROTECT(1);
+	return pDf;
+}
+
+
+bool table_reader::close()
+{
+	has_row = false;
+	return stmt.finalize();
+}
+
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
+// External pointer
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
+
+void r_table_reader_finalizer(SEXP pReader)
+{
+	r_table_reader *rr = (r_table_reader*) R_ExternalPtrAddr(pReader);
+	if(rr)
+	{
+		delete rr;
+		R_ClearExternalPtr(pReader);
+	}
+}
+
+r_table_reader * get_r_table_reader(SEXP pReader)
+{
+	if(TYPEOF(pReader) != EXTPTRSXP || !inherits(pReader, r_table_reader_class))
+		return 0;
+	return (r_table_reader*) R_ExternalPtrAddr(pReader);
+}
+
+SEXP new_r_table_reader(const string &db_file, const read_spec &spec,
+		R_xlen_t chunk_rows, double n_hint, int verbose)
+{
+	r_table_reader *rr = new r_table_reader(db_file, verbose);
+	if(!rr->con.open())
+	{
+		delete rr;
+		error("[openTableReader] Could not open SQLite database '%s'.", db_file.c_str());
+	}
+
+	if(!rr->reader.open(spec, n_hint))
+	{
+		delete rr;
+		error("[openTableReader] Query on table '%s' failed!", spec.table.c_str());
+	}
+	rr->chunk_rows = chunk_rows;
+
+	SEXP pReader = PROTECT(R_MakeExternalPtr(rr, R_NilValue, R_NilValue));
+	R_RegisterCFinalizerEx(pReader, r_table_reader_finalizer, TRUE);
+	setAttrib(pReader, R_ClassSymbol, mkString(r_table_reader_class));
+	UNPROTECT(1);
+	return pReader;
+}
+
+
+} // namespace sqlite
@@ -0,0 +1,123 @@
+/*
+ * table_reader.h
+ *
+ *  Created on: 17.10.2026
+ *      Author: kaisers
+ *
+ *  Reads query results of one table into R vectors (columns of a
+ *  data.frame, see readTableFast in R):
+ *
+ *  read_spec		: SELECT columns FROM table [WHERE ...]
+ *  table_reader	: Steps through the result. Column vectors are allocated
+ *  				  once from the expected number of rows (COUNT(*) or a
+ *  				  hint of the caller) and filled by sqlite3_column_*.
+ *  				  Vectors are only resized when the expectation is wrong.
+ *  				  Successive calls of read() return consecutive chunks.
+ *  r_table_reader	: Reader with its own connection, wrapped into an
+ *  				  external pointer (class 'sqliteToolsReader'), so
+ *  				  chunks can be read in successive .Calls.
+ *
+ *  R types from declared column types (see decltype_to_sexptype).
+ *  Without declared type (expressions), the type of the value in the
+ *  first row is used. Integer columns are continued as double when a
+ *  value is REAL or outside of R integer range.
+ *  Text values and column names are marked as UTF-8 (SQLite text encoding).
+ *
+ *  Only to be used from the main thread.
+ */
+
+#ifndef TABLE_READER_H_
+#define TABLE_READER_H_
+
+#include "sqlite_con.h"
+#include "sqlite_stmt.h"
+#include "frame_sink.h"
+#include "rostream.h"
+
+#include <string>
+#include <vector>
+
+#include <R.h>
+#include <Rinternals.h>
+
+using namespace std;
+
+namespace sqlite {
+
+struct read_spec
+{
+	string table;
+	vector<string> columns;		// Names or expressions (empty: all columns)
+	string where;				// Without 'WHERE' (empty: all rows)
+
+	string select_sql() const;
+	string count_sql() const;
+};
+
+
+class table_reader {
+public:
+	table_reader(sqlite_con &c) : con(c), stmt(c), n_expected(-1), n_read(0), has_row(false) {}
+
+	// n_hint: Expected number of rows (< 0: counted with COUNT(*),
+	// 0: no expectation, vectors are grown while reading)
+	bool open(const read_spec &spec, double n_hint);
+
+	// Returns data.frame with next max_rows rows (0: all remaining rows),
+	// not protected. Returns 0 on error.
+	SEXP read(R_xlen_t max_rows);
+
+	// All rows have been read
+	bool is_done() const { return !has_row; }
+	double rows_read() const { return n_read; }
+
+	bool close();
+
+private:
+	table_reader(const table_reader &rhs);
+
+	void set_types();
+	SEXP alloc_frame(R_xlen_t n_rows);
+	void resize(SEXP pDf, R_xlen_t n_rows);
+	void store(SEXP pDf, R_xlen_t i);
+	void promote(SEXP pDf, unsigned col, R_xlen_t n_rows);
+
+	sqlite_con &con;
+	sqlite_stmt stmt;
+	vector<string> names;
+	vector<int> types;
+	vector<SEXP> cols;		// Columns of current chunk (protected by data.frame)
+	double n_expected;
+	double n_read;
+	bool has_row;			// Current row of stmt has not been read
+};
+
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
+// External pointer
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
+struct r_table_reader
+{
+	r_table_reader(const string &db_file, int verbose) : con(db_file, ros, verbose), reader(con), chunk_rows(0) {}
+
+	rostream ros;			// Must be constructed before con
+	sqlite_con con;
+	table_reader reader;	// Must be destructed before con
+	R_xlen_t chunk_rows;
+};
+
+const char * const r_table_reader_class = "sqliteToolsReader";
+
+// Finalizes statement and closes database
+void r_table_reader_finalizer(SEXP pReader);
+
+// Returns 0 when pReader is no open reader handle
+r_table_reader * get_r_table_reader(SEXP pReader);
+
+// Raises R error when database cannot be opened or query fails
+SEXP new_r_table_reader(const string &db_file, const read_spec &spec,
+		R_xlen_t chunk_rows, double n_hint, int verbose);
+
+
+} // namespace sqlite
+#endif /* TABLE_READER_H_ */
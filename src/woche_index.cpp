@@ -0,0 +1,221 @@
+/*
+ * woche_index.cpp
+ *
+ *  Created on: 17.10.2026
+ *      Author: kaisers
+ */
+
+#include "woche_index.h"
+
+namespace sqlite {
+
+
+const sqlite3_int64 key_value_map::null_value = LLONG_MIN;
+
+
+// REAL values are used when they are integral (e.g. 17.0)
+static bool integral_value(double x, sqlite3_int64 &value)
+{
+	if(!(x >= -9.2e18 && x <= 9.2e18) || x != (double) (sqlite3_int64) x)
+		return false;
+	value = (sqlite3_int64) x;
+	return true;
+}
+
+
+bool key_value_map::load(sqlite_con &con, const string &table, const string &key_col, const string &value_col)
+{
+	ostream &os = con.getos();
+	long n_rows = con.get_count_value("SELECT COUNT(*) FROM " + table + ";");
+	if(n_rows < 0)
+		return false;
+
+	bool found;
+	if(!get_column_decltype(con, table, value_col, found, value_decl))
+		return false;
+
+	int_keys.clear();
+	text_keys.clear();
+	int_keys.reserve(n_rows);
+
+	sqlite_stmt s(con);
+	if(!s.prepare("SELECT " + key_col + ", " + value_col + " FROM " + table + ";"))
+		return false;
+
+	sqlite3_int64 value;
+	while(s.fetch())
+	{
+		if(s.column_type(1) == SQLITE_NULL)
+			insert(s, null_value);
+		else if(s.column_type(1) == SQLITE_INTEGER)
+			insert(s, s.column_int(1));
+		else if(s.column_type(1) == SQLITE_FLOAT && integral_value(s.column_double(1), value))
+			insert(s, value);
+		else
+		{
+			os << "[key_value_map] Column '" << value_col << "' of table '" << table
+					<< "' contains non integer value!\n";
+			s.reset();
+			s.finalize();
+			return false;
+		}
+	}
+	if(!s.is_done())
+		return false;
+	return s.finalize();
+}
+
+void key_value_map::insert(const sqlite_stmt &s, sqlite3_int64 value)
+{
+	sqlite3_int64 key;
+	switch(s.column_type(0))
+	{
+		case SQLITE_INTEGER:
+			int_keys.insert(make_pair(s.column_int(0), value));
+			break;
+
+		case SQLITE_FLOAT:
+			if(integral_value(s.column_double(0), key))
+				int_keys.insert(make_pair(key, value));
+			break;
+
+		case SQLITE_TEXT:
+			text_keys.insert(make_pair(string(s.column_text(0), s.column_bytes(0)), value));
+			break;
+	}
+}
+
+bool key_value_map::find(const sqlite_stmt &s, int col, sqlite3_int64 &value, bool &is_null) const
+{
+	sqlite3_int64 key;
+	switch(s.column_type(col))
+	{
+		case SQLITE_INTEGER:
+		{
+			unordered_map<sqlite3_int64, sqlite3_int64>::const_iterator iter = int_keys.find(s.column_int(col));
+			if(iter == int_keys.end())
+				return false;
+			value = iter->second;
+			break;
+		}
+
+		case SQLITE_FLOAT:
+		{
+			if(!integral_value(s.column_double(col), key))
+				return false;
+			unordered_map<sqlite3_int64, sqlite3_int64>::const_iterator iter = int_keys.find(key);
+			if(iter == int_keys.end())
+				return false;
+			value = iter->second;
+			break;
+		}
+
+		case SQLITE_TEXT:
+		{
+			unordered_map<string, sqlite3_int64>::const_iterator iter =
+					text_keys.find(string(s.column_text(col), s.column_bytes(col)));
+			if(iter == text_keys.end())
+				return false;
+			value = iter->second;
+			break;
+		}
+
+		default:
+			return false;
+	}
+	is_null = (value == null_value);
+	return true;
+}
+
+
+long update_from_map(sqlite_con &con, const key_value_map &map, const string &table,
+		const string &key_col, const string &value_col, sqlite3_int64 chunk_rows, bool verbose)
+{
+	ostream &os = con.getos();
+	bool found;
+	string decl;
+
+	if(!get_column_decltype(con, table, key_col, found, decl))
+		return -1;
+	if(!found)
+	{
+		os << "[update_from_map] Table '" << table << "' has no column '" << key_col << "'!\n";
+		return -1;
+	}
+
+	if(!get_column_decltype(con, table, value_col, found, decl))
+		return -1;
+	// Value column gets declared type of base table
+	if(!found && !con.exec("ALTER TABLE " + table + " ADD COLUMN " + value_col
+			+ (map.value_decltype().empty() ? "" : " " + map.value_decltype()) + ";"))
+		return -1;
+
+	sqlite3_int64 max_rowid;
+	if(!get_max_rowid(con, table, max_rowid))
+		return -1;
+
+	sqlite_stmt read_stmt(con);
+	sqlite_stmt write_stmt(con);
+	if(!read_stmt.prepare("SELECT rowid, " + key_col + " FROM " + table + " WHERE rowid > ?1 ORDER BY rowid LIMIT ?2;")
+			|| !write_stmt.prepare("UPDATE " + table + " SET " + value_col + " = ?1 WHERE rowid = ?2;"))
+		return -1;
+
+	// Chunk is read completely before it is updated
+	vector<pair<sqlite3_int64, sqlite3_int64> > rows;
+	rows.reserve(chunk_rows);
+
+	long n_matched = 0, n_rows = 0;
+	sqlite3_int64 value, last_rowid = LLONG_MIN;
+	bool is_null, success = true;
+
+	while(success && last_rowid < max_rowid)
+	{
+		rows.clear();
+		if(!read_stmt.bind_int64(1, last_rowid) || !read_stmt.bind_int(2, chunk_rows))
+			return -1;
+
+		while(read_stmt.fetch())
+		{
+			last_rowid = read_stmt.column_int(0);
+			if(map.find(read_stmt, 1, value, is_null))
+				++n_matched;
+			else
+				is_null = true;
+			rows.push_back(make_pair(last_rowid, is_null ? key_value_map::null_value : value));
+		}
+		if(!read_stmt.is_done())
+			return -1;
+		if(rows.empty())
+			break;
+
+		con.begin();
+		vector<pair<sqlite3_int64, sqlite3_int64> >::const_iterator iter;
+		for(iter = rows.begin(); success && iter != rows.end(); ++iter)
+		{
+			if(iter->second == key_value_map::null_value)
+				success = write_stmt.bind_null(1);
+			else
+				success = write_stmt.bind_int64(1, iter->second);
+
+			success = success && write_stmt.bind_int64(2, iter->first) && write_stmt.step();
+		}
+
+		if(!success)
+		{
+			con.rollback();
+			break;
+		}
+		con.commit();
+		n_rows += rows.size();
+
+		if(verbose)
+			os << "[update_from_map] Table '" << table << "': " << n_rows << " rows updated.\n";
+	}
+	read_stmt.finalize();
+	write_stmt.finalize();
+
+	return success ? n_matched : -1;
+}
+
+
+} // namespace sqlite
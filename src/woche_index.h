@@ -0,0 +1,74 @@
+/*
+ * woche_index.h
+ *
+ *  Created on: 17.10.2026
+ *      Author: kaisers
+ *
+ *  Copies woche_index values from base table (fbas or kbas) into
+ *  other tables (joined by vers_id).
+ *
+ *  The base table is read once into a hash map (key -> value).
+ *  Target tables are updated in place over rowid ranges
+ *  (one transaction per chunk): No table is read into memory or rewritten.
+ *  Keys are matched by value: Integer keys (and integral REAL keys)
+ *  with integer keys, text keys with text keys.
+ *  Values must be integer (or integral REAL). A missing value column is
+ *  added with the declared type of the value column in the base table.
+ */
+
+#ifndef WOCHE_INDEX_H_
+#define WOCHE_INDEX_H_
+
+#include "sqlite_con.h"
+#include "sqlite_stmt.h"
+#include "expander.h"
+
+#include <string>
+#include <sstream>
+#include <vector>
+#include <unordered_map>
+#include <climits>
+
+using namespace std;
+
+namespace sqlite {
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
+// Hash map key -> integer value (loaded from base table)
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
+class key_value_map {
+public:
+	bool load(sqlite_con &con, const string &table, const string &key_col, const string &value_col);
+
+	// Returns false when key is not found.
+	// is_null: Value in base table is NULL
+	bool find(const sqlite_stmt &s, int col, sqlite3_int64 &value, bool &is_null) const;
+
+	size_t size() const { return int_keys.size() + text_keys.size(); }
+
+	// Declared type of value column in base table
+	const string & value_decltype() const { return value_decl; }
+
+	static const sqlite3_int64 null_value;
+
+private:
+	// The first occurrence of a key is used (as for match() in R)
+	void insert(const sqlite_stmt &s, sqlite3_int64 value);
+
+	unordered_map<sqlite3_int64, sqlite3_int64> int_keys;
+	unordered_map<string, sqlite3_int64> text_keys;
+	string value_decl;
+};
+
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
+// Writes mapped values into value_col of table (column is added when
+// missing). Rows without matching key get NULL.
+// Returns number of rows with matching key or -1 on error.
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
+long update_from_map(sqlite_con &con, const key_value_map &map, const string &table,
+		const string &key_col, const string &value_col, sqlite3_int64 chunk_rows, bool verbose);
+
+
+} // namespace sqlite
+#endif /* WOCHE_INDEX_H_ */
@@ -0,0 +1,189 @@
+/*
+ * bench_data.h
+ *
+ *  Created on: 17.10.2026
+ *      Author: kaisers
+ *
+ *  Synthetic source tables for expand_bench:
+ *
+ *  CREATE TABLE src (id INTEGER PRIMARY KEY, lo INTEGER, hi INTEGER,
+ *  		ci1 INTEGER, ..., cr1 REAL, ..., ct1 TEXT, ..., e1 REAL, ...);
+ *
+ *  lo is uniform in [0, index_range), the span hi - lo + 1 is either
+ *  uniform in [1, max_span] or heavy tailed (Pareto with shape alpha,
+ *  truncated at max_span). Values are generated from a seeded engine,
+ *  so equal parameters produce equal tables.
+ */
+
+#ifndef BENCH_DATA_H_
+#define BENCH_DATA_H_
+
+#include "sqlite_con.h"
+#include "sqlite_batch.h"
+#include "expander.h"
+
+#include <string>
+#include <sstream>
+#include <random>
+#include <cmath>
+#include <cstdio>
+
+using namespace std;
+
+namespace sqlite {
+
+enum span_distribution { SPAN_UNIFORM = 0, SPAN_PARETO };
+
+struct bench_table_spec
+{
+	bench_table_spec() : table("src"), n_rows(100000), span(SPAN_UNIFORM), max_span(52),
+			alpha(1.5), index_range(520), n_copy_int(1), n_copy_real(1), n_copy_text(1),
+			n_expand(2), text_size(12), seed(1) {}
+
+	string table;
+	long n_rows;
+	int span;					// span_distribution
+	int max_span;
+	double alpha;				// SPAN_PARETO: shape (smaller: heavier tail)
+	int index_range;
+	unsigned n_copy_int;
+	unsigned n_copy_real;
+	unsigned n_copy_text;
+	unsigned n_expand;
+	unsigned text_size;			// Characters per text value
+	unsigned long seed;
+
+	// Expansion of table into write_table (index column 'idx')
+	expand_spec get_expand_spec(const string &write_table) const;
+};
+
+
+expand_spec bench_table_spec::get_expand_spec(const string &write_table) const
+{
+	expand_spec spec;
+	spec.read_table = table;
+	spec.write_table = write_table;
+	spec.lo_bound_col = "lo";
+	spec.up_bound_col = "hi";
+	spec.index_column = "idx";
+
+	unsigned i;
+	for(i = 1; i <= n_copy_int; ++i)
+	{
+		spec.copyCols.push_back("ci" + to_string(i));
+		spec.copyColTypes.push_back("INTEGER");
+	}
+	for(i = 1; i <= n_copy_real; ++i)
+	{
+		spec.copyCols.push_back("cr" + to_string(i));
+		spec.copyColTypes.push_back("REAL");
+	}
+	for(i = 1; i <= n_copy_text; ++i)
+	{
+		spec.copyCols.push_back("ct" + to_string(i));
+		spec.copyColTypes.push_back("TEXT");
+	}
+	for(i = 1; i <= n_expand; ++i)
+		spec.expandCols.push_back("e" + to_string(i));
+
+	return spec;
+}
+
+
+// Span hi - lo + 1 (>= 1)
+int bench_span(const bench_table_spec &ts, mt19937_64 &rng)
+{
+	if(ts.span == SPAN_PARETO)
+	{
+		// Inverse transform: x = u^(-1/alpha) (x >= 1)
+		uniform_real_distribution<double> unif(0, 1);
+		double u = 1 - unif(rng);
+		double x = pow(u, -1.0 / ts.alpha);
+		return x >= ts.max_span ? ts.max_span : (int) x;
+	}
+	uniform_int_distribution<int> unif(1, ts.max_span);
+	return unif(rng);
+}
+
+
+// Creates (replaces) source table. Returns false on error.
+bool generate_source_table(sqlite_con &con, const bench_table_spec &ts)
+{
+	ostream &os = con.getos();
+	expand_spec spec = ts.get_expand_spec(string());
+	list<string>::const_iterator iter, titer;
+
+	if(ts.n_rows < 0 || ts.max_span < 1 || ts.index_range < 1 || ts.alpha <= 0)
+	{
+		os << "[generate_source_table] Invalid table parameters!\n";
+		return false;
+	}
+
+	stringstream sql;
+	sql << "CREATE TABLE " << ts.table << " (id INTEGER PRIMARY KEY, lo INTEGER, hi INTEGER";
+	for(iter = spec.copyCols.begin(), titer = spec.copyColTypes.begin(); iter != spec.copyCols.end(); ++iter, ++titer)
+		sql << ", " << *iter << " " << *titer;
+	for(iter = spec.expandCols.begin(); iter != spec.expandCols.end(); ++iter)
+		sql << ", " << *iter << " REAL";
+	sql << ");";
+
+	if(!con.drop_table(ts.table) || !con.create_table(sql.str()))
+		return false;
+
+	sql.str("");
+	sql << "INSERT INTO " << ts.table << " VALUES ";
+
+	unsigned n_cols = 3 + spec.copyCols.size() + spec.expandCols.size();
+	sqlite_batch_stmt stmt(con);
+	if(!stmt.prepare(sql.str(), n_cols))
+		return false;
+
+	mt19937_64 rng(ts.seed);
+	uniform_int_distribution<int> lo_dist(0, ts.index_range - 1);
+	uniform_int_distribution<sqlite3_int64> int_dist(0, 1000000);
+	uniform_real_distribution<double> real_dist(0, 1000);
+	uniform_int_distribution<int> char_dist('a', 'z');
+	string text(ts.text_size, ' ');
+
+	long i;
+	unsigned j, pos;
+	bool success = true;
+
+	con.begin();
+	for(i = 1; success && i <= ts.n_rows; ++i)
+	{
+		int lo = lo_dist(rng);
+		pos = 1;
+		stmt.bind_int(pos++, i);
+		stmt.bind_int(pos++, lo);
+		stmt.bind_int(pos++, lo + bench_span(ts, rng) - 1);
+
+		for(j = 0; j < ts.n_copy_int; ++j)
+			stmt.bind_int(pos++, int_dist(rng));
+		for(j = 0; j < ts.n_copy_real; ++j)
+			stmt.bind_double(pos++, real_dist(rng));
+		for(j = 0; j < ts.n_copy_text; ++j)
+		{
+			string::iterator c;
+			for(c = text.begin(); c != text.end(); ++c)
+				*c = (char) char_dist(rng);
+			stmt.bind_text(pos++, text.c_str());
+		}
+		for(j = 0; j < ts.n_expand; ++j)
+			stmt.bind_double(pos++, real_dist(rng));
+
+		success = stmt.step();
+	}
+	success = success && stmt.flush();
+
+	if(success)
+		con.commit();
+	else
+		con.rollback();
+	stmt.finalize();
+	return success;
+}
+
+
+} // namespace sqlite
+#endif /* BENCH_DATA_H_ */
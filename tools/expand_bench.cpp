@@ -0,0 +1,701 @@
+/*
+ * expand_bench.cpp
+ *
+ *  Created on: 17.10.2026
+ *      Author: kaisers
+ *
+ *  Standalone benchmark for expand_table (no R required):
+ *  Generates a synthetic source table (see bench_data.h) and expands it
+ *  with each expansion mode. Reports time per phase, rows/s and
+ *  bytes written (median of repeated runs).
+ *
+ *  Phases:
+ *  prepare	: Drop and create write table, prepare statements
+ *  expand	: Read, expand and insert rows (threads: including merge of
+ *  		  partitions, chunked: including intermediate commits)
+ *  commit	: Final COMMIT
+ *
+ *  Bytes written: Growth of used database pages (page_count - freelist_count)
+ *  for table output, file size for binary and csv output.
+ *
+ *  Modes: serial, batch, chunked, pipeline (callback engine), threads,
+ *  sql (sql engine), vtab (INSERT ... SELECT from virtual table 'expand'),
+ *  binary, csv (file output).
+ *
+ *  --check: The output of each mode is compared with the output of a
+ *  single thread (threads=1). Write tables: ids, index values and all
+ *  copied and expanded values must be identical. Binary file: Number of
+ *  rows and sums of ids, index values and expanded values must be
+ *  identical. CSV output is not compared (values are rounded to 15
+ *  digits). Returns 1 on difference.
+ *
+ *  Usage: expand_bench [--option=value ...] (see usage())
+ */
+
+#include "sqlite_con.h"
+#include "sqlite_stmt.h"
+#include "sqlite_batch.h"
+#include "expander.h"
+#include "pipeline.h"
+#include "column_file.h"
+#include "expand_engine.h"
+#include "expand_vtab.h"
+#include "bench_data.h"
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+
+using namespace std;
+using namespace sqlite;
+
+const char * const all_modes = "serial,batch,chunked,threads,pipeline,sql,vtab,binary,csv";
+
+struct bench_options
+{
+	bench_options() : db_file("expand_bench.db"), modes(all_modes), generate(true),
+			repeat(3), batch_size(0), commit_rows(10000), n_threads(4),
+			profile("default"), check(false), verbose(false) {}
+
+	bench_table_spec table;
+	string db_file;
+	string modes;
+	bool generate;
+	int repeat;
+	int batch_size;			// Modes other than serial (0: default_batch_rows)
+	int commit_rows;		// chunked
+	int n_threads;			// threads
+	string profile;			// PRAGMA profile (see sqlite_con.h)
+	bool check;				// Compare output with reference
+	bool verbose;
+};
+
+struct bench_result
+{
+	bench_result() : n_src(-1), n_out(0), steps(0), bytes(0),
+			t_prepare(0), t_expand(0), t_commit(0), t_total(0) {}
+
+	long n_src;				// -1: Failed
+	sqlite3_int64 n_out;
+	unsigned long steps;	// Executed INSERT statements
+	sqlite3_int64 bytes;
+	double t_prepare;
+	double t_expand;
+	double t_commit;
+	double t_total;
+};
+
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
+// Helpers
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
+class bench_timer {
+public:
+	bench_timer() : start(chrono::steady_clock::now()), last(start) {}
+
+	// Seconds since last lap
+	double lap()
+	{
+		chrono::steady_clock::time_point now = chrono::steady_clock::now();
+		double res = chrono::duration<double>(now - last).count();
+		last = now;
+		return res;
+	}
+
+	double total() const { return chrono::duration<double>(last - start).count(); }
+
+private:
+	chrono::steady_clock::time_point start;
+	chrono::steady_clock::time_point last;
+};
+
+// Bytes in used database pages
+sqlite3_int64 used_bytes(sqlite_con &con)
+{
+	sqlite3_int64 n_pages = 0, n_free = 0, page_size = 0;
+	if(!con.get_int_value("PRAGMA page_count;", n_pages)
+			|| !con.get_int_value("PRAGMA freelist_count;", n_free)
+			|| !con.get_int_value("PRAGMA page_size;", page_size))
+		return 0;
+	return (n_pages - n_free) * page_size;
+}
+
+sqlite3_int64 file_size(const string &file)
+{
+	FILE *f = fopen(file.c_str(), "rb");
+	if(!f)
+		return 0;
+	fseek(f, 0, SEEK_END);
+	sqlite3_int64 size = ftell(f);
+	fclose(f);
+	return size;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
+// Output check: Hash over all values of the write table (in id order)
+// and sums of ids, index values and expanded values.
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
+struct table_digest
+{
+	table_digest() : n_rows(-1), hash(14695981039346656037ULL), sum_id(0), sum_idx(0), sum_expanded(0) {}
+
+	void add(const void *data, size_t n)
+	{
+		const unsigned char *p = (const unsigned char*) data;
+		size_t i;
+		for(i = 0; i < n; ++i)
+			hash = (hash ^ p[i]) * 1099511628211ULL;
+	}
+
+	bool operator==(const table_digest &rhs) const { return n_rows == rhs.n_rows && hash == rhs.hash; }
+	bool operator!=(const table_digest &rhs) const { return !(*this == rhs); }
+
+	// Files: Only rows and sums are compared (no hash over values)
+	bool same_sums(const table_digest &rhs) const
+	{
+		return n_rows == rhs.n_rows && sum_id == rhs.sum_id && sum_idx == rhs.sum_idx
+				&& sum_expanded == rhs.sum_expanded;
+	}
+
+	sqlite3_int64 n_rows;	// -1: Failed
+	sqlite3_uint64 hash;
+	sqlite3_int64 sum_id;
+	sqlite3_int64 sum_idx;
+	double sum_expanded;
+};
+
+table_digest get_table_digest(sqlite_con &con, const expand_spec &spec)
+{
+	table_digest dg;
+	sqlite_stmt stmt(con);
+	if(!stmt.prepare("SELECT * FROM " + spec.write_table + " ORDER BY id;"))
+		return dg;
+
+	int j, n_cols = -1, first_expanded = 0;
+	sqlite3_int64 n_rows = 0;
+	while(stmt.fetch())
+	{
+		if(n_cols < 0)
+		{
+			n_cols = stmt.column_count();
+			first_expanded = n_cols - (int) spec.expandCols.size();
+		}
+
+		for(j = 0; j < n_cols; ++j)
+		{
+			unsigned char type = (unsigned char) stmt.column_type(j);
+			dg.add(&type, 1);
+			if(type == SQLITE_INTEGER)
+			{
+				sqlite3_int64 v = stmt.column_int(j);
+				dg.add(&v, sizeof(v));
+			}
+			else if(type == SQLITE_FLOAT)
+			{
+				double v = stmt.column_double(j);
+				dg.add(&v, sizeof(v));
+			}
+			else if(type != SQLITE_NULL)
+			{
+				const char *text = stmt.column_text(j);
+				int bytes = stmt.column_bytes(j);
+				dg.add(&bytes, sizeof(bytes));
+				dg.add(text, bytes);
+			}
+		}
+		dg.sum_id += stmt.column_int(0);
+		dg.sum_idx += stmt.column_int(2);
+		for(j = first_expanded; j < n_cols; ++j)
+			dg.sum_expanded += stmt.column_double(j);
+		++n_rows;
+	}
+
+	if(stmt.is_done())
+		dg.n_rows = n_rows;
+	stmt.finalize();
+	return dg;
+}
+
+// Binary file: NA values are counted as 0 (as NULL in get_table_digest)
+table_digest get_file_digest(const string &file, const expand_spec &spec)
+{
+	table_digest dg;
+	column_file_reader reader(cerr);
+	if(!reader.open(file))
+		return dg;
+
+	unsigned j, n_cols = reader.n_cols(), first_expanded = n_cols - (unsigned) spec.expandCols.size();
+	int64_t i, n_rows = reader.n_rows();
+	const int64_t *id = reader.int_column(0);
+	const int64_t *idx = reader.int_column(2);
+
+	for(i = 0; i < n_rows; ++i)
+	{
+		if(id[i] != column_file_na_int)
+			dg.sum_id += id[i];
+		if(idx[i] != column_file_na_int)
+			dg.sum_idx += idx[i];
+	}
+
+	// Summed in row order (same order of additions as get_table_digest)
+	for(i = 0; i < n_rows; ++i)
+	{
+		for(j = first_expanded; j < n_cols; ++j)
+		{
+			double v = reader.double_column(j)[i];
+			if(!std::isnan(v))
+				dg.sum_expanded += v;
+		}
+	}
+	dg.n_rows = n_rows;
+	reader.close();
+	return dg;
+}
+
+void print_digest(const char *name, const table_digest &dg)
+{
+	printf("  %-10s rows=%lld hash=%016llx sum(id)=%lld sum(idx)=%lld sum(expanded)=%.10g\n", name,
+			(long long) dg.n_rows, (unsigned long long) dg.hash, (long long) dg.sum_id,
+			(long long) dg.sum_idx, dg.sum_expanded);
+}
+
+
+bool has_exclusive_locking(const sqlite_con::pragma_list &pragmas)
+{
+	sqlite_con::pragma_list::const_iterator iter;
+	for(iter = pragmas.begin(); iter != pragmas.end(); ++iter)
+	{
+		if(sqlite3_stricmp(iter->first.c_str(), "locking_mode") == 0
+				&& sqlite3_stricmp(iter->second.c_str(), "EXCLUSIVE") == 0)
+			return true;
+	}
+	return false;
+}
+
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
+// Expansion modes
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
+
+// Write table output: serial, batch, chunked, threads, pipeline, sql, vtab
+bench_result run_table_mode(sqlite_con &con, const bench_options &opt, const string &mode)
+{
+	bench_result res;
+	bench_timer timer;
+	expand_spec spec = opt.table.get_expand_spec("expanded");
+
+	if(!con.drop_table(spec.write_table) || !con.exec("DELETE FROM " + string(expand_meta_table) + ";"))
+		return res;
+	sqlite3_int64 bytes = used_bytes(con);
+	if(!con.create_table(spec.create_sql(spec.write_table)))
+		return res;
+
+	if(mode == "threads" || mode == "threads1")
+	{
+		res.t_prepare = timer.lap();
+		if(!parallel_expand(con, spec, mode == "threads" ? opt.n_threads : 1, opt.batch_size, opt.verbose))
+			return res;
+		res.t_expand = timer.lap();
+		res.n_src = con.get_count_value("SELECT COUNT(*) FROM " + spec.read_table + ";");
+		res.n_out = con.get_max_id_val(spec.write_table);
+	}
+	else if(mode == "sql")
+	{
+		// Statistics (max span) are part of prepare
+		source_stats st;
+		if(!st.load(con, spec))
+			return res;
+		sqlite_stmt stmt(con);
+		if(!stmt.prepare(spec.expand_sql(spec.write_table, st.max_span, 0)))
+			return res;
+		res.t_prepare = timer.lap();
+
+		con.begin();
+		bool success = stmt.step();
+		res.t_expand = timer.lap();
+		if(success)
+			con.commit();
+		else
+			con.rollback();
+		res.t_commit = timer.lap();
+		stmt.finalize();
+
+		if(!success)
+			return res;
+		res.n_src = st.rows;
+		res.n_out = st.expanded;
+		res.steps = 1;
+	}
+	else if(mode == "vtab")
+	{
+		// Ids are numbered in source rowid and index order (window function)
+		stringstream sql;
+		list<string>::const_iterator iter;
+		sql << "DROP TABLE IF EXISTS temp.expand_vtab; CREATE VIRTUAL TABLE temp.expand_vtab USING expand("
+				<< spec.read_table << ", " << spec.lo_bound_col << ", " << spec.up_bound_col << ", " << spec.index_column;
+		for(iter = spec.copyCols.begin(); iter != spec.copyCols.end(); ++iter)
+			sql << ", copy=" << *iter;
+		for(iter = spec.expandCols.begin(); iter != spec.expandCols.end(); ++iter)
+			sql << ", expand=" << *iter;
+		sql << ");";
+		if(!con.exec(sql.str()))
+			return res;
+
+		sqlite_stmt stmt(con);
+		if(!stmt.prepare("INSERT INTO " + spec.write_table
+				+ " SELECT row_number() OVER (ORDER BY rid, " + spec.index_column + "), * FROM temp.expand_vtab;"))
+			return res;
+		res.t_prepare = timer.lap();
+
+		con.begin();
+		bool success = stmt.step();
+		res.t_expand = timer.lap();
+		if(success)
+			con.commit();
+		else
+			con.rollback();
+		res.t_commit = timer.lap();
+		stmt.finalize();
+		con.exec("DROP TABLE IF EXISTS temp.expand_vtab;");
+
+		if(!success)
+			return res;
+		res.n_src = con.get_count_value("SELECT COUNT(*) FROM " + spec.read_table + ";");
+		res.n_out = con.get_max_id_val(spec.write_table);
+		res.steps = 1;
+	}
+	else
+	{
+		sqlite_batch_stmt stmt(con);
+		if(!stmt.prepare(spec.insert_sql(spec.write_table), spec.n_columns(), mode == "serial" ? 1 : opt.batch_size))
+			return res;
+
+		size_t mark = con.pragma_mark();
+		if(mode == "pipeline" && !con.set_con_journal(sqlite_con::JRNL_WAL))
+			return res;
+
+		sqlite_stmt read_stmt(con);
+		if(mode != "pipeline" && !read_stmt.prepare(spec.select_sql(spec.where_sql()) ))
+			return res;
+		res.t_prepare = timer.lap();
+
+		long n_src;
+		if(mode == "chunked")
+		{
+			expand_watermark wm;
+			wm.rowid = LLONG_MIN;
+			sqlite3_int64 high_mark;
+			if(!get_max_rowid(con, spec.read_table, high_mark))
+				return res;
+			n_src = expand_chunked(stmt, spec, wm, high_mark, opt.commit_rows, opt.verbose);
+			res.t_expand = timer.lap();
+		}
+		else
+		{
+			con.begin();
+			if(mode == "pipeline")
+			{
+				expand_pipeline pl(spec, opt.db_file, opt.verbose);
+				n_src = pl.run(stmt);
+			}
+			else
+				n_src = expand_rows(read_stmt, stmt, spec);
+			res.t_expand = timer.lap();
+
+			if(n_src >= 0)
+				con.commit();
+			else
+				con.rollback();
+			res.t_commit = timer.lap();
+		}
+		read_stmt.finalize();
+		stmt.finalize();
+
+		if(!con.restore_pragmas(mark) || n_src < 0)
+			return res;
+
+		res.n_src = n_src;
+		res.n_out = stmt.lastAutoId();
+		res.steps = stmt.steps();
+	}
+	res.bytes = used_bytes(con) - bytes;
+	res.t_total = timer.total();
+	return res;
+}
+
+// File output: binary, csv
+// digest: Digest of binary file (optional)
+bench_result run_file_mode(sqlite_con &con, const bench_options &opt, const string &mode,
+		sqlite3_int64 n_expected, table_digest *digest)
+{
+	bench_result res;
+	bench_timer timer;
+	expand_spec spec = opt.table.get_expand_spec("expanded");
+	string file = opt.db_file + "." + mode;
+
+	remove(file.c_str());
+	res.t_prepare = timer.lap();
+	res.n_src = expand_to_file(con, spec, mode, file);
+	res.t_expand = timer.lap();
+	res.t_total = timer.total();
+
+	if(res.n_src >= 0)
+	{
+		res.n_out = n_expected;
+		res.bytes = file_size(file);
+		if(digest && mode == "binary")
+			*digest = get_file_digest(file, spec);
+	}
+	remove(file.c_str());
+	return res;
+}
+
+bench_result run_mode(sqlite_con &con, const bench_options &opt, const string &mode,
+		sqlite3_int64 n_expected, table_digest *digest)
+{
+	if(mode == "binary" || mode == "csv")
+		return run_file_mode(con, opt, mode, n_expected, digest);
+	return run_table_mode(con, opt, mode);
+}
+
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
+// Command line
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
+void usage()
+{
+	cout << "Usage: expand_bench [--option=value ...]\n"
+			<< "  --db=FILE          Database file (default: expand_bench.db)\n"
+			<< "  --rows=N           Source rows (default: 100000)\n"
+			<< "  --span=DIST        Span distribution: uniform or pareto (default: uniform)\n"
+			<< "  --max-span=N       Maximal span hi - lo + 1 (default: 52)\n"
+			<< "  --alpha=X          Pareto shape (default: 1.5)\n"
+			<< "  --copy-int=N       Copied INTEGER columns (default: 1)\n"
+			<< "  --copy-real=N      Copied REAL columns (default: 1)\n"
+			<< "  --copy-text=N      Copied TEXT columns (default: 1)\n"
+			<< "  --text-size=N      Characters per text value (default: 12)\n"
+			<< "  --expand=N         Expanded REAL columns (default: 2)\n"
+			<< "  --seed=N           Random seed (default: 1)\n"
+			<< "  --no-generate      Use existing source table\n"
+			<< "  --modes=LIST       Comma separated (default: " << all_modes << ")\n"
+			<< "  --repeat=N         Runs per mode, median is reported (default: 3)\n"
+			<< "  --batch=N          Rows per INSERT statement (default: 64)\n"
+			<< "  --commit-rows=N    Source rows per commit, chunked mode (default: 10000)\n"
+			<< "  --threads=N        Threads, threads mode (default: 4)\n"
+			<< "  --profile=NAME     PRAGMA profile: none, default, bulk, bulk_wal (default: default)\n"
+			<< "  --check            Compare output of each mode with single thread\n"
+			<< "  --verbose          Print log of database connection\n";
+}
+
+bool parse_args(int argc, char **argv, bench_options &opt)
+{
+	int i;
+	for(i = 1; i < argc; ++i)
+	{
+		string arg(argv[i]), name, value;
+		size_t eq = arg.find('=');
+		name = arg.substr(0, eq);
+		if(eq != string::npos)
+			value = arg.substr(eq + 1);
+
+		if(name == "--db")					opt.db_file = value;
+		else if(name == "--rows")			opt.table.n_rows = atol(value.c_str());
+		else if(name == "--max-span")		opt.table.max_span = atoi(value.c_str());
+		else if(name == "--alpha")			opt.table.alpha = atof(value.c_str());
+		else if(name == "--copy-int")		opt.table.n_copy_int = atoi(value.c_str());
+		else if(name == "--copy-real")		opt.table.n_copy_real = atoi(value.c_str());
+		else if(name == "--copy-text")		opt.table.n_copy_text = atoi(value.c_str());
+		else if(name == "--text-size")		opt.table.text_size = atoi(value.c_str());
+		else if(name == "--expand")			opt.table.n_expand = atoi(value.c_str());
+		else if(name == "--seed")			opt.table.seed = strtoul(value.c_str(), NULL, 10);
+		else if(name == "--no-generate")	opt.generate = false;
+		else if(name == "--modes")			opt.modes = value;
+		else if(name == "--repeat")			opt.repeat = atoi(value.c_str());
+		else if(name == "--batch")			opt.batch_size = atoi(value.c_str());
+		else if(name == "--commit-rows")	opt.commit_rows = atoi(value.c_str());
+		else if(name == "--threads")		opt.n_threads = atoi(value.c_str());
+		else if(name == "--profile")		opt.profile = value;
+		else if(name == "--check")			opt.check = true;
+		else if(name == "--verbose")		opt.verbose = true;
+		else if(name == "--span")
+		{
+			if(value == "uniform")
+				opt.table.span = SPAN_UNIFORM;
+			else if(value == "pareto")
+				opt.table.span = SPAN_PARETO;
+			else
+			{
+				cerr << "Unknown span distribution '" << value << "'!\n";
+				return false;
+			}
+		}
+		else
+		{
+			if(name != "--help")
+				cerr << "Unknown option '" << arg << "'!\n";
+			return false;
+		}
+	}
+
+	if(opt.repeat < 1 || opt.batch_size < 0 || opt.commit_rows < 1 || opt.n_threads < 1
+			|| opt.table.n_expand < 1 || opt.table.n_copy_int + opt.table.n_copy_real + opt.table.n_copy_text < 1)
+	{
+		cerr << "Invalid option value (at least one copy and one expand column are required)!\n";
+		return false;
+	}
+	return true;
+}
+
+
+int main(int argc, char **argv)
+{
+	bench_options opt;
+	if(!parse_args(argc, argv, opt))
+	{
+		usage();
+		return 1;
+	}
+
+	sqlite_con::pragma_list pragmas;
+	if(!sqlite_con::get_pragma_profile(opt.profile, pragmas))
+	{
+		cerr << "Unknown PRAGMA profile '" << opt.profile << "'!\n";
+		return 1;
+	}
+
+	sqlite_con con(opt.db_file, cerr, opt.verbose);
+	if(!con.open() || !con.apply_pragmas(pragmas) || !create_expand_meta(con)
+			|| !con.create_module("expand", &expand_module))
+	{
+		cerr << "Cannot open database '" << opt.db_file << "'!\n";
+		return 1;
+	}
+
+	// - - - - - - - - - - - - - - - - - - - - - - - - - //
+	// Source table
+	// - - - - - - - - - - - - - - - - - - - - - - - - - //
+	bench_timer timer;
+	if(opt.generate && !generate_source_table(con, opt.table))
+	{
+		cerr << "Cannot generate source table!\n";
+		return 1;
+	}
+	double t_generate = timer.lap();
+
+	expand_spec spec = opt.table.get_expand_spec("expanded");
+	long n_src = con.get_count_value("SELECT COUNT(*) FROM " + spec.read_table + ";");
+	sqlite3_int64 n_expected = -1;
+	if(n_src < 0 || !con.get_int_value(spec.span_sql(), n_expected))
+	{
+		cerr << "Cannot read source table '" << spec.read_table << "'!\n";
+		return 1;
+	}
+
+	printf("SQLite %s, profile '%s'\n", sqlite3_libversion(), opt.profile.c_str());
+	printf("Source: %ld rows (%u copy, %u expand columns), %lld expanded rows (%.2f per row)",
+			n_src, (unsigned) spec.copyCols.size(), (unsigned) spec.expandCols.size(),
+			(long long) n_expected, n_src ? (double) n_expected / n_src : 0.0);
+	if(opt.generate)
+		printf(", generated in %.3f s", t_generate);
+	printf("\n\n");
+
+	// - - - - - - - - - - - - - - - - - - - - - - - - - //
+	// Reference output: Single thread (serial numbering)
+	// - - - - - - - - - - - - - - - - - - - - - - - - - //
+	table_digest reference;
+	if(opt.check)
+	{
+		if(run_table_mode(con, opt, "threads1").n_src >= 0)
+			reference = get_table_digest(con, spec);
+		if(reference.n_rows != n_expected)
+		{
+			cerr << "Cannot create reference output!\n";
+			return 1;
+		}
+		printf("Reference (threads=1):\n");
+		print_digest("threads1", reference);
+		printf("\n");
+	}
+
+	printf("%-9s %10s %12s %9s %9s %9s %9s %12s %10s %9s\n", "mode", "src_rows", "out_rows",
+			"prepare_s", "expand_s", "commit_s", "total_s", "rows/s", "MB", "steps");
+
+	// - - - - - - - - - - - - - - - - - - - - - - - - - //
+	// Expansion modes
+	// - - - - - - - - - - - - - - - - - - - - - - - - - //
+	bool exclusive = has_exclusive_locking(pragmas);
+	bool success = true;
+	stringstream modes(opt.modes);
+	string mode;
+
+	while(getline(modes, mode, ','))
+	{
+		if(mode != "serial" && mode != "batch" && mode != "chunked" && mode != "threads"
+				&& mode != "pipeline" && mode != "sql" && mode != "vtab" && mode != "binary" && mode != "csv")
+		{
+			cerr << "Unknown mode '" << mode << "'!\n";
+			success = false;
+			continue;
+		}
+
+		// Workers and reader thread use separate connections
+		if(exclusive && (mode == "threads" || mode == "pipeline"))
+		{
+			printf("%-9s (skipped: locking_mode=EXCLUSIVE)\n", mode.c_str());
+			continue;
+		}
+
+		vector<bench_result> runs;
+		table_digest file_digest;
+		int i;
+		for(i = 0; i < opt.repeat; ++i)
+		{
+			runs.push_back(run_mode(con, opt, mode, n_expected, &file_digest));
+			cerr.flush();
+			if(runs.back().n_src < 0)
+				break;
+		}
+
+		if(runs.back().n_src < 0 || runs.back().n_out != n_expected)
+		{
+			printf("%-9s FAILED (%lld of %lld rows)\n", mode.c_str(),
+					(long long) runs.back().n_out, (long long) n_expected);
+			success = false;
+			continue;
+		}
+
+		if(opt.check && mode != "csv")
+		{
+			bool is_file = (mode == "binary");
+			table_digest dg = is_file ? file_digest : get_table_digest(con, spec);
+			if(is_file ? !dg.same_sums(reference) : dg != reference)
+			{
+				printf("%-9s FAILED (output differs from threads=1)\n", mode.c_str());
+				print_digest(mode.c_str(), dg);
+				success = false;
+				continue;
+			}
+		}
+
+		// Median of total time
+		sort(runs.begin(), runs.end(),
+				[](const bench_result &a, const bench_result &b) { return a.t_total < b.t_total; });
+		const bench_result &r = runs[runs.size() / 2];
+
+		printf("%-9s %10ld %12lld %9.3f %9.3f %9.3f %9.3f %12.0f %10.1f %9lu\n", mode.c_str(),
+				r.n_src, (long long) r.n_out, r.t_prepare, r.t_expand, r.t_commit, r.t_total,
+				r.t_total > 0 ? r.n_out / r.t_total : 0.0, r.bytes / 1048576.0, r.steps);
+	}
+
+	con.drop_table("expanded");
+	con.close();
+	return success ? 0 : 1;
+}
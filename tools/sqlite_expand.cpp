@@ -0,0 +1,303 @@
+/*
+ * sqlite_expand.cpp
+ *
+ *  Created on: 17.10.2026
+ *      Author: kaisers
+ *
+ *  Command line interface for expand_table (no R required).
+ *  Options have the names of the arguments and options of expandTable
+ *  in R (see expand_job.h). Column lists are comma separated.
+ *
+ *  Example:
+ *  sqlite-expand --dbfile=data.db --tables=src,res --boundCols=lo,hi \
+ *  	--indexCol=woche --copyCols=id,name --expandCols=amount --threads=0
+ *
+ *  Returns 0 on success, 1 on invalid options, 2 on expansion errors.
+ *  Messages are written to standard error.
+ */
+
+#include "sqlite_con.h"
+#include "expander.h"
+#include "expand_job.h"
+#include "log_sink.h"
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <list>
+#include <cstdlib>
+
+using namespace std;
+using namespace sqlite;
+
+
+struct cli_options
+{
+	cli_options() : pragma_profile("default"), window(0), verbose(false) {}
+
+	string db_file;
+	vector<string> tables;			// read, write
+	vector<string> bound_cols;		// lo, hi
+	string index_col;
+	vector<string> copy_cols;
+	vector<string> copy_col_types;	// Empty: Declared types of read table
+	vector<string> expand_cols;
+	string distribution;
+	vector<string> day_cols;
+	string pragma_profile;
+	sqlite_con::pragma_list pragmas;
+	int window;
+	bool verbose;
+};
+
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
+// Command line
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - //
+void usage()
+{
+	cerr << "Usage: sqlite-expand --option=value ...\n"
+			<< "  --dbfile=FILE            Database file\n"
+			<< "  --tables=READ,WRITE      Read table and write table\n"
+			<< "  --boundCols=LO,HI        Lower and upper bound columns\n"
+			<< "  --indexCol=NAME          Index column of write table\n"
+			<< "  --copyCols=LIST          Copied columns\n"
+			<< "  --copyColTypes=LIST      Types of copied columns (default: declared types)\n"
+			<< "  --expandCols=LIST        Expanded columns\n"
+			<< "  --batchSize=N            Rows per INSERT statement (default: 64)\n"
+			<< "  --threads=N              Threads (default: 1, 0 = number of cores)\n"
+			<< "  --pipeline               Separate reader thread\n"
+			<< "  --sourceDb=FILE          Database file of read table (pipeline only)\n"
+			<< "  --incremental            Append rows above recorded watermark\n"
+			<< "  --commitRows=N           Commit every N source rows (default: 0)\n"
+			<< "  --bulkSchema             INTEGER PRIMARY KEY and integer index column\n"
+			<< "  --indexCols=LIST         Columns indexed after loading\n"
+			<< "  --analyze                ANALYZE write table after loading\n"
+			<< "  --output=TYPE            table, binary or csv (default: table)\n"
+			<< "  --file=FILE              Output file (binary and csv)\n"
+			<< "  --refCol=NAME            Reference column\n"
+			<< "  --window=N               Window around reference column (default: 0)\n"
+			<< "  --relIndex               Write index - refCol into index column\n"
+			<< "  --distribution=NAME      even, days, weights, first or last (default: even)\n"
+			<< "  --dayCols=START,END      Start and end day columns (distribution days)\n"
+			<< "  --weightTable=NAME       Table (index, weight) (distribution weights)\n"
+			<< "  --engine=NAME            auto, callback or sql (default: auto)\n"
+			<< "  --pragmaProfile=NAME     none, default, bulk or bulk_wal (default: default)\n"
+			<< "  --pragmas=NAME=VALUE,... Additional PRAGMAs\n"
+			<< "  --instrument             Print time per phase and counters\n"
+			<< "  --verbose                Print log messages\n";
+}
+
+vector<string> split_list(const string &value)
+{
+	vector<string> res;
+	stringstream ss(value);
+	string item;
+	while(getline(ss, item, ','))
+	{
+		if(item.size())
+			res.push_back(item);
+	}
+	return res;
+}
+
+bool parse_args(int argc, char **argv, cli_options &cli, expand_spec &spec, expand_options &opt)
+{
+	int i;
+	for(i = 1; i < argc; ++i)
+	{
+		string arg(argv[i]), name, value;
+		size_t eq = arg.find('=');
+		name = arg.substr(0, eq);
+		if(eq != string::npos)
+			value = arg.substr(eq + 1);
+
+		if(name == "--dbfile")				cli.db_file = value;
+		else if(name == "--tables")			cli.tables = split_list(value);
+		else if(name == "--boundCols")		cli.bound_cols = split_list(value);
+		else if(name == "--indexCol")		cli.index_col = value;
+		else if(name == "--copyCols")		cli.copy_cols = split_list(value);
+		else if(name == "--copyColTypes")	cli.copy_col_types = split_list(value);
+		else if(name == "--expandCols")		cli.expand_cols = split_list(value);
+		else if(name == "--batchSize")		opt.batch_size = atoi(value.c_str());
+		else if(name == "--threads")		opt.n_threads = atoi(value.c_str());
+		else if(name == "--pipeline")		opt.pipeline = true;
+		else if(name == "--sourceDb")		opt.source_db = value;
+		else if(name == "--incremental")	opt.incremental = true;
+		else if(name == "--commitRows")		opt.commit_rows = atoi(value.c_str());
+		else if(name == "--bulkSchema")		spec.bulk_schema = true;
+		else if(name == "--indexCols")		opt.index_cols = split_list(value);
+		else if(name == "--analyze")		opt.analyze = true;
+		else if(name == "--output")			opt.output = value;
+		else if(name == "--file")			opt.file = value;
+		else if(name == "--refCol")			spec.ref_col = value;
+		else if(name == "--window")			cli.window = atoi(value.c_str());
+		else if(name == "--relIndex")		spec.rel_index = true;
+		else if(name == "--distribution")	cli.distribution = value;
+		else if(name == "--dayCols")		cli.day_cols = split_list(value);
+		else if(name == "--weightTable")	opt.weight_table = value;
+		else if(name == "--engine")			opt.engine = engine_from_name(value);
+		else if(name == "--pragmaProfile")	cli.pragma_profile = value;
+		else if(name == "--verbose")		cli.verbose = true;
+		else if(name == "--instrument")		opt.instrument = true;
+		else if(name == "--pragmas")
+		{
+			vector<string> items = split_list(value);
+			vector<string>::const_iterator iter;
+			for(iter = items.begin(); iter != items.end(); ++iter)
+			{
+				size_t pos = iter->find('=');
+				if(pos == string::npos)
+				{
+					cerr << "PRAGMA '" << *iter << "' must be given as name=value!\n";
+					return false;
+				}
+				cli.pragmas.push_back(make_pair(iter->substr(0, pos), iter->substr(pos + 1)));
+			}
+		}
+		else
+		{
+			if(name != "--help")
+				cerr << "Unknown option '" << arg << "'!\n";
+			return false;
+		}
+	}
+
+	if(cli.db_file.empty() || cli.tables.size() != 2 || cli.bound_cols.size() != 2
+			|| cli.index_col.empty() || cli.copy_cols.empty() || cli.expand_cols.empty())
+	{
+		cerr << "Options dbfile, tables, boundCols, indexCol, copyCols and expandCols are required!\n";
+		return false;
+	}
+
+	if(cli.copy_col_types.size() && cli.copy_col_types.size() != cli.copy_cols.size())
+	{
+		cerr << "copyCols and copyColTypes must have equal length!\n";
+		return false;
+	}
+
+	if(opt.output == "frame")
+	{
+		cerr << "output='frame' is only available in R!\n";
+		return false;
+	}
+
+	spec.read_table = cli.tables[0];
+	spec.write_table = cli.tables[1];
+	spec.lo_bound_col = cli.bound_cols[0];
+	spec.up_bound_col = cli.bound_cols[1];
+	spec.index_column = cli.index_col;
+	spec.copyCols.assign(cli.copy_cols.begin(), cli.copy_cols.end());
+	spec.expandCols.assign(cli.expand_cols.begin(), cli.expand_cols.end());
+	spec.window_lo = -cli.window;
+	spec.window_hi = cli.window;
+
+	if(cli.distribution.size())
+	{
+		spec.dist.kernel = dist_kernel_from_name(cli.distribution);
+		if(spec.dist.kernel < 0)
+		{
+			cerr << "Unknown distribution '" << cli.distribution << "'!\n";
+			return false;
+		}
+	}
+
+	if(spec.dist.kernel == DIST_DAYS && cli.day_cols.size() == 2)
+	{
+		spec.dist.start_day_col = cli.day_cols[0];
+		spec.dist.end_day_col = cli.day_cols[1];
+	}
+
+	if(!sqlite_con::get_pragma_profile(cli.pragma_profile, opt.pragmas))
+	{
+		cerr << "Unknown pragmaProfile '" << cli.pragma_profile << "'!\n";
+		return false;
+	}
+	opt.pragmas.insert(opt.pragmas.end(), cli.pragmas.begin(), cli.pragmas.end());
+	opt.verbose = cli.verbose;
+
+	string msg;
+	if(!expand_job::check(spec, opt, msg))
+	{
+		cerr << msg << "\n";
+		return false;
+	}
+	return true;
+}
+
+
+// Copied columns are created with declared types of read table
+bool get_copy_col_types(sqlite_con &con, const cli_options &cli, expand_spec &spec)
+{
+	if(cli.copy_col_types.size())
+	{
+		spec.copyColTypes.assign(cli.copy_col_types.begin(), cli.copy_col_types.end());
+		return true;
+	}
+
+	list<string>::const_iterator iter;
+	for(iter = spec.copyCols.begin(); iter != spec.copyCols.end(); ++iter)
+	{
+		bool found;
+		string decl;
+		if(!get_column_decltype(con, spec.read_table, *iter, found, decl))
+			return false;
+		if(!found)
+		{
+			con.getos() << "[sqlite-expand] Table '" << spec.read_table << "' has no column '" << *iter << "'!\n";
+			return false;
+		}
+		spec.copyColTypes.push_back(decl);
+	}
+	return true;
+}
+
+
+int main(int argc, char **argv)
+{
+	cli_options cli;
+	expand_spec spec;
+	expand_options opt;
+
+	if(!parse_args(argc, argv, cli, spec, opt))
+	{
+		usage();
+		return 1;
+	}
+
+	stderr_sink sink;
+	log_stream os(sink);
+	sqlite_con con(cli.db_file, os, cli.verbose);
+
+	if(!con.open())
+	{
+		os << "[sqlite-expand] Could not open SQLite database '" << cli.db_file << "'.\n";
+		return 2;
+	}
+
+	expand_job job(con, spec, opt);
+	bool success = get_copy_col_types(con, cli, spec);
+	if(success && !(job.prepare() && job.run()))
+	{
+		os << job.last_error() << "\n";
+		success = false;
+	}
+
+	// Restores PRAGMAs
+	if(!con.close())
+	{
+		os << "[sqlite-expand] Database closing error!\n";
+		success = false;
+	}
+
+	// Verbose run has printed counters
+	if(success && opt.instrument && !cli.verbose)
+		job.get_stats().print(os);
+
+	if(success && cli.verbose)
+		os << "[sqlite-expand] Finished.\n";
+
+	os.flush();
+	return success ? 0 : 2;
+}